@@ -0,0 +1,79 @@
+#pragma once
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace tinykube {
+    // "0-3,8,10-11" -> {0,1,2,3,8,10,11}; false on malformed input
+    inline bool parse_cpu_list(const std::string& text, std::vector<int>& cpus) {
+        cpus.clear();
+        std::istringstream in(text);
+        std::string part;
+        auto number = [](const std::string& digits, int& value) {
+            auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+            return error == std::errc() && end == digits.data() + digits.size();
+        };
+        while (std::getline(in, part, ',')) {
+            auto dash = part.find('-');
+            int first = 0, last = 0;
+            if (!number(part.substr(0, dash), first) ||
+                !number(dash == std::string::npos ? part : part.substr(dash + 1), last)) {
+                return false;
+            }
+            if (first < 0 || last < first || last >= CPU_SETSIZE) {
+                return false;
+            }
+            for (int cpu = first; cpu <= last; cpu++) {
+                cpus.push_back(cpu);
+            }
+        }
+        return !cpus.empty();
+    }
+
+    // no-op for an empty list, so "not configured" needs no special casing
+    inline bool pin_current_thread(const std::vector<int>& cpus) {
+        if (cpus.empty()) {
+            return true;
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) {
+            CPU_SET(cpu, &set);
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+
+    // NUMA node a CPU belongs to according to sysfs, -1 if unknown
+    inline int numa_node_of_cpu(int cpu) {
+        std::error_code error;
+        std::filesystem::directory_iterator it("/sys/devices/system/cpu/cpu" + std::to_string(cpu), error);
+        for (; !error && it != std::filesystem::directory_iterator(); it.increment(error)) {
+            std::string name = it->path().filename().string();
+            if (name.rfind("node", 0) == 0 && name.size() > 4) {
+                int node = -1;
+                std::from_chars(name.data() + 4, name.data() + name.size(), node);
+                return node;
+            }
+        }
+        return -1;
+    }
+
+    // Prefer allocating from `node` on this thread and every thread it creates
+    // afterwards (MPOL_PREFERRED). Called before the service starts, it keeps
+    // the registry shards on the ingestion core's node.
+    inline bool prefer_numa_node(int node) {
+        constexpr int MPOL_PREFERRED_MODE = 1;
+        if (node < 0 || node >= 64) {
+            return false;
+        }
+        unsigned long mask = 1UL << node;
+        return ::syscall(SYS_set_mempolicy, MPOL_PREFERRED_MODE, &mask, sizeof(mask) * 8) == 0;
+    }
+} // namespace tinykube
@@ -0,0 +1,422 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tinykube {
+    enum class ArrowType { INT64, FLOAT64, BOOL, UTF8, TIMESTAMP_MS };
+
+    // One column in Arrow's memory layout, so a batch goes to disk or the
+    // wire as-is: fixed-width values back to back, bools as LSB-first bits,
+    // strings as int32 offsets plus the concatenated bytes. No nulls.
+    class ArrowColumn {
+    public:
+        ArrowColumn(std::string name, ArrowType type) : name_(std::move(name)), type_(type) {
+            offsets_.push_back(0);
+        }
+
+        void append_int64(int64_t value) {
+            ints_.push_back(value);
+            length_++;
+        }
+
+        void append_double(double value) {
+            doubles_.push_back(value);
+            length_++;
+        }
+
+        void append_bool(bool value) {
+            if (length_ % 8 == 0) {
+                bits_.push_back(0);
+            }
+            bits_.back() |= static_cast<uint8_t>(value ? 1u << (length_ % 8) : 0u);
+            length_++;
+        }
+
+        void append_utf8(std::string_view value) {
+            chars_.append(value);
+            offsets_.push_back(static_cast<int32_t>(chars_.size()));
+            length_++;
+        }
+
+        void reserve(size_t rows, size_t bytes_per_row = 16) {
+            switch (type_) {
+                case ArrowType::INT64:
+                case ArrowType::TIMESTAMP_MS: ints_.reserve(rows); break;
+                case ArrowType::FLOAT64:      doubles_.reserve(rows); break;
+                case ArrowType::BOOL:         bits_.reserve(rows / 8 + 1); break;
+                case ArrowType::UTF8:
+                    offsets_.reserve(rows + 1);
+                    chars_.reserve(rows * bytes_per_row);
+                    break;
+            }
+        }
+
+        void clear() {
+            ints_.clear();
+            doubles_.clear();
+            bits_.clear();
+            offsets_.assign(1, 0);
+            chars_.clear();
+            length_ = 0;
+        }
+
+        const std::string& name() const {
+            return name_;
+        }
+
+        ArrowType type() const {
+            return type_;
+        }
+
+        size_t length() const {
+            return length_;
+        }
+
+        // the data buffers after the (empty) validity bitmap, in IPC order
+        std::vector<std::string_view> buffers() const {
+            auto bytes = [](const auto& vector) {
+                return std::string_view(reinterpret_cast<const char*>(vector.data()),
+                                        vector.size() * sizeof(vector[0]));
+            };
+            switch (type_) {
+                case ArrowType::INT64:
+                case ArrowType::TIMESTAMP_MS: return {bytes(ints_)};
+                case ArrowType::FLOAT64:      return {bytes(doubles_)};
+                case ArrowType::BOOL:         return {bytes(bits_)};
+                case ArrowType::UTF8:         return {bytes(offsets_), chars_};
+            }
+            return {};
+        }
+    private:
+        std::string name_;
+        ArrowType type_;
+        size_t length_{0};
+        std::vector<int64_t> ints_;
+        std::vector<double> doubles_;
+        std::vector<uint8_t> bits_;
+        std::vector<int32_t> offsets_;
+        std::string chars_;
+    };
+
+    namespace arrow_detail {
+        // Front-to-back FlatBuffers writer, enough for Arrow's few metadata
+        // tables. A table's offset fields are patched once its children have
+        // been placed after it, so every offset points forward as the format
+        // requires. Assumes a little-endian host.
+        class FlatWriter {
+        public:
+            struct Field {
+                uint16_t id;
+                uint8_t size;  // 1, 2, 4 or 8 bytes; offsets are 4 and patched later
+                uint64_t value;
+            };
+
+            std::string buffer;
+
+            FlatWriter() {
+                put<uint32_t>(0);  // root offset
+            }
+
+            void align(size_t alignment) {
+                while (buffer.size() % alignment != 0) {
+                    buffer.push_back('\0');
+                }
+            }
+
+            template <typename T>
+            size_t put(T value) {
+                size_t at = buffer.size();
+                buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+                return at;
+            }
+
+            template <typename T>
+            void patch(size_t at, T value) {
+                std::memcpy(buffer.data() + at, &value, sizeof(T));
+            }
+
+            // makes the offset field at `from` refer to the object at `to`
+            void point(size_t from, size_t to) {
+                patch<uint32_t>(from, static_cast<uint32_t>(to - from));
+            }
+
+            void root(size_t table) {
+                point(0, table);
+            }
+
+            // Writes the vtable then the table, widest fields first so none
+            // needs padding. Returns the table; `slots[i]` is fields[i]'s position.
+            size_t table(const std::vector<Field>& fields, std::vector<size_t>& slots) {
+                size_t count = 0;
+                for (const auto& field : fields) {
+                    count = std::max<size_t>(count, field.id + 1u);
+                }
+                align(2);
+                size_t vtable = put<uint16_t>(static_cast<uint16_t>(4 + 2 * count));
+                put<uint16_t>(0);
+                for (size_t i = 0; i < count; i++) {
+                    put<uint16_t>(0);
+                }
+                // the table starts 4 bytes before an 8-byte boundary, so the
+                // fields after its soffset begin 8-aligned
+                align(4);
+                if (buffer.size() % 8 == 0) {
+                    put<uint32_t>(0);
+                }
+                size_t table = put<int32_t>(static_cast<int32_t>(buffer.size() - vtable));
+                std::vector<size_t> order(fields.size());
+                std::iota(order.begin(), order.end(), 0);
+                std::stable_sort(order.begin(), order.end(),
+                                 [&](size_t a, size_t b) { return fields[a].size > fields[b].size; });
+                slots.assign(fields.size(), 0);
+                for (size_t index : order) {
+                    const auto& field = fields[index];
+                    align(field.size);
+                    slots[index] = buffer.size();
+                    buffer.append(reinterpret_cast<const char*>(&field.value), field.size);
+                    patch<uint16_t>(vtable + 4 + 2 * field.id, static_cast<uint16_t>(slots[index] - table));
+                }
+                patch<uint16_t>(vtable + 2, static_cast<uint16_t>(buffer.size() - table));
+                return table;
+            }
+
+            size_t table(const std::vector<Field>& fields) {
+                std::vector<size_t> slots;
+                return table(fields, slots);
+            }
+
+            // length prefix, then `count` zeroed elements aligned to `alignment`
+            size_t vector(size_t count, size_t element_size, size_t alignment) {
+                while (buffer.size() % 4 != 0 || (buffer.size() + 4) % alignment != 0) {
+                    buffer.push_back('\0');
+                }
+                size_t at = put<uint32_t>(static_cast<uint32_t>(count));
+                buffer.append(count * element_size, '\0');
+                return at;
+            }
+
+            size_t string(std::string_view text) {
+                align(4);
+                size_t at = put<uint32_t>(static_cast<uint32_t>(text.size()));
+                buffer.append(text);
+                buffer.push_back('\0');
+                return at;
+            }
+        };
+
+        // Schema.fbs / Message.fbs / File.fbs constants
+        inline constexpr uint64_t METADATA_V5 = 4;
+        inline constexpr uint64_t HEADER_SCHEMA = 1;
+        inline constexpr uint64_t HEADER_RECORD_BATCH = 3;
+        inline constexpr uint8_t TYPE_INT = 2, TYPE_FLOATING_POINT = 3, TYPE_UTF8 = 5, TYPE_BOOL = 6,
+                                 TYPE_TIMESTAMP = 10;
+
+        inline size_t write_type(FlatWriter& out, ArrowType type) {
+            switch (type) {
+                case ArrowType::INT64:   return out.table({{0, 4, 64}, {1, 1, 1}});  // bitWidth, is_signed
+                case ArrowType::FLOAT64: return out.table({{0, 2, 2}});           // precision DOUBLE
+                case ArrowType::BOOL:
+                case ArrowType::UTF8:    return out.table({});
+                case ArrowType::TIMESTAMP_MS: {
+                    std::vector<size_t> slots;
+                    size_t table = out.table({{0, 2, 1}, {1, 4, 0}}, slots);  // MILLISECOND, timezone
+                    out.point(slots[1], out.string("UTC"));
+                    return table;
+                }
+            }
+            return 0;
+        }
+
+        inline uint8_t type_tag(ArrowType type) {
+            switch (type) {
+                case ArrowType::INT64:        return TYPE_INT;
+                case ArrowType::FLOAT64:      return TYPE_FLOATING_POINT;
+                case ArrowType::BOOL:         return TYPE_BOOL;
+                case ArrowType::UTF8:         return TYPE_UTF8;
+                case ArrowType::TIMESTAMP_MS: return TYPE_TIMESTAMP;
+            }
+            return 0;
+        }
+
+        inline size_t write_schema(FlatWriter& out, const std::vector<ArrowColumn>& columns) {
+            std::vector<size_t> slots;
+            size_t schema = out.table({{1, 4, 0}}, slots);  // fields
+            size_t fields = out.vector(columns.size(), 4, 4);
+            out.point(slots[0], fields);
+            for (size_t i = 0; i < columns.size(); i++) {
+                // name, nullable, type_type, type, children
+                size_t field = out.table({{0, 4, 0}, {1, 1, 0}, {2, 1, type_tag(columns[i].type())}, {3, 4, 0}, {5, 4, 0}},
+                                         slots);
+                out.point(fields + 4 + 4 * i, field);
+                std::vector<size_t> field_slots = slots;
+                out.point(field_slots[0], out.string(columns[i].name()));
+                out.point(field_slots[3], write_type(out, columns[i].type()));
+                out.point(field_slots[4], out.vector(0, 4, 4));
+            }
+            return schema;
+        }
+
+        inline size_t padded8(size_t size) {
+            return (size + 7) & ~size_t{7};
+        }
+    } // namespace arrow_detail
+
+    // Arrow IPC file format (Feather V2): what pyarrow.feather,
+    // pandas.read_feather and DuckDB's arrow reader open. The metadata is
+    // hand-written FlatBuffers, so there's no Arrow dependency, and column
+    // buffers go straight from ArrowColumn memory to the sink. Every batch
+    // must have the columns begin() was given, in the same order.
+    class ArrowFileWriter {
+    public:
+        using Sink = std::function<bool(const char* data, size_t size)>;
+
+        explicit ArrowFileWriter(Sink sink) : sink_(std::move(sink)) {}
+
+        bool begin(const std::vector<ArrowColumn>& columns) {
+            schema_.clear();
+            for (const auto& column : columns) {
+                schema_.emplace_back(column.name(), column.type());
+            }
+            arrow_detail::FlatWriter message;
+            std::vector<size_t> slots;
+            // version, header_type, header, bodyLength
+            size_t table = message.table({{0, 2, arrow_detail::METADATA_V5}, {1, 1, arrow_detail::HEADER_SCHEMA},
+                                          {2, 4, 0}, {3, 8, 0}},
+                                         slots);
+            message.root(table);
+            message.point(slots[2], arrow_detail::write_schema(message, schema_));
+            return write("ARROW1\0\0", 8) && write_message(message, 0);
+        }
+
+        bool write_batch(const std::vector<ArrowColumn>& columns) {
+            size_t rows = columns.empty() ? 0 : columns.front().length();
+            size_t buffer_count = 0;
+            for (const auto& column : columns) {
+                buffer_count += 1 + column.buffers().size();
+            }
+
+            arrow_detail::FlatWriter message;
+            std::vector<size_t> slots;
+            size_t table = message.table({{0, 2, arrow_detail::METADATA_V5}, {1, 1, arrow_detail::HEADER_RECORD_BATCH},
+                                          {2, 4, 0}, {3, 8, 0}},
+                                         slots);
+            message.root(table);
+            size_t header_slot = slots[2], body_length_slot = slots[3];
+            size_t batch = message.table({{0, 8, rows}, {1, 4, 0}, {2, 4, 0}}, slots);  // length, nodes, buffers
+            message.point(header_slot, batch);
+            size_t nodes = message.vector(columns.size(), 16, 8);
+            size_t buffers = message.vector(buffer_count, 16, 8);
+            message.point(slots[1], nodes);
+            message.point(slots[2], buffers);
+
+            int64_t offset = 0;
+            size_t buffer_index = 0;
+            auto add_buffer = [&](size_t length) {
+                size_t at = buffers + 4 + 16 * buffer_index++;
+                message.patch<int64_t>(at, offset);
+                message.patch<int64_t>(at + 8, static_cast<int64_t>(length));
+                offset += static_cast<int64_t>(arrow_detail::padded8(length));
+            };
+            for (size_t i = 0; i < columns.size(); i++) {
+                message.patch<int64_t>(nodes + 4 + 16 * i, static_cast<int64_t>(columns[i].length()));
+                message.patch<int64_t>(nodes + 4 + 16 * i + 8, 0);  // null_count
+                add_buffer(0);                                      // validity, absent
+                for (const auto& buffer : columns[i].buffers()) {
+                    add_buffer(buffer.size());
+                }
+            }
+            message.patch<int64_t>(body_length_slot, offset);
+
+            Block block;
+            if (!write_message(message, offset, &block)) {
+                return false;
+            }
+            static const char zeros[8] = {};
+            for (const auto& column : columns) {
+                for (const auto& buffer : column.buffers()) {
+                    if (!write(buffer.data(), buffer.size()) ||
+                        !write(zeros, arrow_detail::padded8(buffer.size()) - buffer.size())) {
+                        return false;
+                    }
+                }
+            }
+            batches_.push_back(block);
+            rows_ += rows;
+            return true;
+        }
+
+        // end-of-stream marker, footer, trailing magic
+        bool finish() {
+            uint32_t eos[2] = {0xFFFFFFFFu, 0};
+            if (!write(reinterpret_cast<const char*>(eos), sizeof(eos))) {
+                return false;
+            }
+            arrow_detail::FlatWriter footer;
+            std::vector<size_t> slots;
+            // version, schema, dictionaries, recordBatches
+            size_t table = footer.table({{0, 2, arrow_detail::METADATA_V5}, {1, 4, 0}, {2, 4, 0}, {3, 4, 0}}, slots);
+            footer.root(table);
+            std::vector<size_t> footer_slots = slots;
+            footer.point(footer_slots[1], arrow_detail::write_schema(footer, schema_));
+            footer.point(footer_slots[2], footer.vector(0, 24, 8));
+            size_t blocks = footer.vector(batches_.size(), 24, 8);
+            footer.point(footer_slots[3], blocks);
+            for (size_t i = 0; i < batches_.size(); i++) {
+                size_t at = blocks + 4 + 24 * i;
+                footer.patch<int64_t>(at, batches_[i].offset);
+                footer.patch<int32_t>(at + 8, batches_[i].metadata_length);
+                footer.patch<int64_t>(at + 16, batches_[i].body_length);
+            }
+            int32_t footer_length = static_cast<int32_t>(footer.buffer.size());
+            return write(footer.buffer.data(), footer.buffer.size()) &&
+                   write(reinterpret_cast<const char*>(&footer_length), sizeof(footer_length)) && write("ARROW1", 6);
+        }
+
+        uint64_t bytes_written() const {
+            return written_;
+        }
+
+        uint64_t rows_written() const {
+            return rows_;
+        }
+    private:
+        struct Block {
+            int64_t offset{0};
+            int32_t metadata_length{0};
+            int64_t body_length{0};
+        };
+
+        bool write(const char* data, size_t size) {
+            if (size == 0) {
+                return true;
+            }
+            written_ += size;
+            return sink_(data, size);
+        }
+
+        // continuation marker, metadata length, metadata padded to 8 bytes
+        bool write_message(arrow_detail::FlatWriter& message, int64_t body_length, Block* block = nullptr) {
+            message.align(8);
+            uint32_t prefix[2] = {0xFFFFFFFFu, static_cast<uint32_t>(message.buffer.size())};
+            if (block != nullptr) {
+                block->offset = static_cast<int64_t>(written_);
+                block->metadata_length = static_cast<int32_t>(sizeof(prefix) + message.buffer.size());
+                block->body_length = body_length;
+            }
+            return write(reinterpret_cast<const char*>(prefix), sizeof(prefix)) &&
+                   write(message.buffer.data(), message.buffer.size());
+        }
+
+        Sink sink_;
+        std::vector<ArrowColumn> schema_;
+        std::vector<Block> batches_;
+        uint64_t written_{0};
+        uint64_t rows_{0};
+    };
+} // namespace tinykube
@@ -0,0 +1,210 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tinykube {
+    enum class CaptureType : uint8_t {
+        REGISTER = 1,
+        HEARTBEAT = 2,
+    };
+
+    struct CaptureRecord {
+        CaptureType type{CaptureType::HEARTBEAT};
+        uint64_t offset_us{0};  // since the capture started
+        uint64_t stream{0};     // heartbeat stream the record arrived on, 0 for registrations
+        std::string tenant;
+        std::string node;
+        int64_t cpu_millis{0};  // registrations only
+        int64_t memory_mb{0};
+        int64_t client_ms{0};   // heartbeats only: the agent's clock
+    };
+
+    // Capture file layout: the magic line, then one record per message:
+    //   type:u8 offset_delta_us:varint stream:varint tenant:str node:str
+    //   then cpu_millis, memory_mb (REGISTER) or client_ms (HEARTBEAT) as zigzag varints.
+    // A str is varint(id << 1 | is_new) followed by varint length and bytes the
+    // first time a name appears, so steady-state heartbeats cost a handful of bytes.
+    inline constexpr char CAPTURE_MAGIC[] = "TKCAP1\n";
+
+    // Thread-safe recorder fed from the RPC handlers; buffers and appends in chunks.
+    class CaptureWriter {
+    public:
+        explicit CaptureWriter(const std::string& path)
+            : out_(path, std::ios::binary | std::ios::trunc), started_(std::chrono::steady_clock::now()) {
+            out_.write(CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC) - 1);
+        }
+
+        ~CaptureWriter() {
+            flush();
+        }
+
+        bool ok() const {
+            return out_.good();
+        }
+
+        void record(CaptureRecord record) {
+            uint64_t now_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - started_).count());
+            std::lock_guard<std::mutex> lock(mutex_);
+            // handlers race between taking the time and the lock, keep offsets monotonic
+            now_us = std::max(now_us, last_us_);
+            buffer_.push_back(static_cast<char>(record.type));
+            varint(now_us - last_us_);
+            last_us_ = now_us;
+            varint(record.stream);
+            name(record.tenant);
+            name(record.node);
+            if (record.type == CaptureType::REGISTER) {
+                zigzag(record.cpu_millis);
+                zigzag(record.memory_mb);
+            } else {
+                zigzag(record.client_ms);
+            }
+            records_++;
+            if (buffer_.size() > (1 << 16)) {
+                write_buffer();
+            }
+        }
+
+        void flush() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            write_buffer();
+            out_.flush();
+        }
+
+        uint64_t records() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return records_;
+        }
+    private:
+        void varint(uint64_t value) {
+            while (value >= 0x80) {
+                buffer_.push_back(static_cast<char>(value | 0x80));
+                value >>= 7;
+            }
+            buffer_.push_back(static_cast<char>(value));
+        }
+
+        void zigzag(int64_t value) {
+            varint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+        }
+
+        void name(const std::string& text) {
+            auto [it, inserted] = names_.emplace(text, names_.size());
+            varint((it->second << 1) | (inserted ? 1 : 0));
+            if (inserted) {
+                varint(text.size());
+                buffer_ += text;
+            }
+        }
+
+        void write_buffer() {
+            out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+            buffer_.clear();
+        }
+
+        std::ofstream out_;
+        std::chrono::steady_clock::time_point started_;
+        std::unordered_map<std::string, uint64_t> names_;
+        std::string buffer_;
+        uint64_t last_us_{0};
+        uint64_t records_{0};
+        mutable std::mutex mutex_;
+    };
+
+    class CaptureReader {
+    public:
+        explicit CaptureReader(const std::string& path) : in_(path, std::ios::binary) {
+            char magic[sizeof(CAPTURE_MAGIC) - 1];
+            valid_ = in_.read(magic, sizeof(magic)) && std::string(magic, sizeof(magic)) == CAPTURE_MAGIC;
+        }
+
+        bool valid() const {
+            return valid_;
+        }
+
+        // false at end of file or on a truncated/corrupt record
+        bool next(CaptureRecord& record) {
+            int type = in_.get();
+            if (!valid_ || type == EOF) {
+                return false;
+            }
+            if (type != static_cast<int>(CaptureType::REGISTER) && type != static_cast<int>(CaptureType::HEARTBEAT)) {
+                valid_ = false;
+                return false;
+            }
+            record.type = static_cast<CaptureType>(type);
+            uint64_t delta = 0;
+            if (!varint(delta) || !varint(record.stream) || !name(record.tenant) || !name(record.node)) {
+                return false;
+            }
+            offset_us_ += delta;
+            record.offset_us = offset_us_;
+            if (record.type == CaptureType::REGISTER) {
+                record.client_ms = 0;
+                return zigzag(record.cpu_millis) && zigzag(record.memory_mb);
+            }
+            record.cpu_millis = record.memory_mb = 0;
+            return zigzag(record.client_ms);
+        }
+    private:
+        bool varint(uint64_t& value) {
+            value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                int byte = in_.get();
+                if (byte == EOF) {
+                    return valid_ = false;
+                }
+                value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0) {
+                    return true;
+                }
+            }
+            return valid_ = false;
+        }
+
+        bool zigzag(int64_t& value) {
+            uint64_t raw = 0;
+            if (!varint(raw)) {
+                return false;
+            }
+            value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+            return true;
+        }
+
+        bool name(std::string& text) {
+            uint64_t tag = 0;
+            if (!varint(tag)) {
+                return false;
+            }
+            uint64_t id = tag >> 1;
+            if (tag & 1) {
+                uint64_t size = 0;
+                if (!varint(size) || id != names_.size() || size > (1 << 20)) {
+                    return valid_ = false;
+                }
+                std::string fresh(size, '\0');
+                if (!in_.read(fresh.data(), static_cast<std::streamsize>(size))) {
+                    return valid_ = false;
+                }
+                names_.push_back(std::move(fresh));
+            } else if (id >= names_.size()) {
+                return valid_ = false;
+            }
+            text = names_[id];
+            return true;
+        }
+
+        std::ifstream in_;
+        std::vector<std::string> names_;
+        uint64_t offset_us_{0};
+        bool valid_{false};
+    };
+} // namespace tinykube
@@ -0,0 +1,360 @@
+#pragma once
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace tinykube {
+    // Minimal protobuf wire-format writer, enough for the pprof schema.
+    class ProtoWriter {
+    public:
+        void varint(uint64_t value) {
+            while (value >= 0x80) {
+                out_.push_back(static_cast<char>(value | 0x80));
+                value >>= 7;
+            }
+            out_.push_back(static_cast<char>(value));
+        }
+
+        void uint_field(int field, uint64_t value) {
+            if (value != 0) {
+                varint(static_cast<uint64_t>(field) << 3);
+                varint(value);
+            }
+        }
+
+        void bytes_field(int field, const std::string& bytes) {
+            varint((static_cast<uint64_t>(field) << 3) | 2);
+            varint(bytes.size());
+            out_ += bytes;
+        }
+
+        void packed_field(int field, const std::vector<uint64_t>& values) {
+            ProtoWriter packed;
+            for (uint64_t value : values) {
+                packed.varint(value);
+            }
+            bytes_field(field, packed.str());
+        }
+
+        const std::string& str() const {
+            return out_;
+        }
+    private:
+        std::string out_;
+    };
+
+    // Sampling CPU profiler: ITIMER_PROF delivers SIGPROF to whichever thread
+    // is burning CPU, and the handler walks that thread's frame pointers into a
+    // preallocated buffer. Only code built with -fno-omit-frame-pointer yields
+    // full stacks; the walk stops at the first frame that does not look like
+    // one. One profile runs at a time per process.
+    class CpuProfiler {
+    public:
+        static constexpr size_t MAX_DEPTH = 48;
+        static constexpr int MAX_SECONDS = 60;
+        static constexpr int MAX_HZ = 1000;
+
+        static CpuProfiler& instance() {
+            static CpuProfiler profiler;
+            return profiler;
+        }
+
+        // Blocks for `seconds`, then returns a gzipped pprof profile in `out`.
+        bool profile(int seconds, int hz, std::string& out, std::string& reason) {
+            if (seconds <= 0 || seconds > MAX_SECONDS || hz <= 0 || hz > MAX_HZ) {
+                reason = "seconds must be in 1.." + std::to_string(MAX_SECONDS) + " and hz in 1.." + std::to_string(MAX_HZ);
+                return false;
+            }
+            std::unique_lock<std::mutex> busy(running_, std::try_to_lock);
+            if (!busy.owns_lock()) {
+                reason = "A profile is already running";
+                return false;
+            }
+
+            // room for twice the expected samples, since every thread's CPU time counts
+            capacity_ = static_cast<size_t>(seconds) * hz * 2 + 64;
+            samples_ = std::make_unique<Sample[]>(capacity_);
+            next_.store(0, std::memory_order_relaxed);
+            dropped_.store(0, std::memory_order_relaxed);
+
+            // The handler stays installed afterwards: a SIGPROF still pending
+            // when the timer stops must not hit the default (terminating) action.
+            struct sigaction action {};
+            action.sa_sigaction = &CpuProfiler::on_signal;
+            action.sa_flags = SA_SIGINFO | SA_RESTART;
+            sigemptyset(&action.sa_mask);
+            sigaction(SIGPROF, &action, nullptr);
+
+            auto started = std::chrono::system_clock::now();
+            active_.store(true);
+            set_timer(hz);
+            std::this_thread::sleep_for(std::chrono::seconds(seconds));
+            set_timer(0);
+            active_.store(false);
+            while (inflight_.load() != 0) {
+                std::this_thread::yield();
+            }
+
+            auto duration = std::chrono::system_clock::now() - started;
+            out = gzip(encode(hz, std::chrono::duration_cast<std::chrono::nanoseconds>(started.time_since_epoch()).count(),
+                              std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()));
+            samples_.reset();
+            return true;
+        }
+
+        size_t dropped() const {
+            return dropped_.load(std::memory_order_relaxed);
+        }
+    private:
+        struct Sample {
+            uint64_t frames[MAX_DEPTH];
+            std::atomic<uint32_t> depth{0};
+        };
+
+        struct Mapping {
+            uint64_t start;
+            uint64_t limit;
+            uint64_t offset;
+            std::string file;
+        };
+
+        static void set_timer(int hz) {
+            itimerval timer{};
+            if (hz > 0) {
+                timer.it_interval.tv_usec = 1000000 / hz;
+                timer.it_value = timer.it_interval;
+            }
+            setitimer(ITIMER_PROF, &timer, nullptr);
+        }
+
+        // reads through the kernel so a bogus frame pointer fails instead of faulting
+        static bool safe_read(uint64_t address, void* out, size_t size) {
+            iovec local{out, size};
+            iovec remote{reinterpret_cast<void*>(address), size};
+            return ::process_vm_readv(::getpid(), &local, 1, &remote, 1, 0) == static_cast<ssize_t>(size);
+        }
+
+        static void on_signal(int, siginfo_t*, void* context) {
+            int saved_errno = errno;
+            CpuProfiler& self = instance();
+            self.inflight_.fetch_add(1);
+            if (self.active_.load()) {
+                size_t index = self.next_.fetch_add(1, std::memory_order_relaxed);
+                if (index < self.capacity_) {
+                    self.capture(self.samples_[index], static_cast<ucontext_t*>(context));
+                } else {
+                    self.dropped_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            self.inflight_.fetch_sub(1);
+            errno = saved_errno;
+        }
+
+        static void capture(Sample& sample, ucontext_t* context) {
+            uint64_t pc = 0, fp = 0;
+#if defined(__x86_64__)
+            pc = static_cast<uint64_t>(context->uc_mcontext.gregs[REG_RIP]);
+            fp = static_cast<uint64_t>(context->uc_mcontext.gregs[REG_RBP]);
+#elif defined(__aarch64__)
+            pc = context->uc_mcontext.pc;
+            fp = context->uc_mcontext.regs[29];
+#else
+            (void)context;
+#endif
+            uint32_t depth = 0;
+            if (pc != 0) {
+                sample.frames[depth++] = pc;
+            }
+            // each frame holds {caller's frame pointer, return address}
+            while (depth < MAX_DEPTH && fp != 0 && fp % sizeof(uint64_t) == 0) {
+                uint64_t frame[2];
+                if (!safe_read(fp, frame, sizeof(frame)) || frame[1] == 0) {
+                    break;
+                }
+                sample.frames[depth++] = frame[1] - 1;  // inside the call, not after it
+                if (frame[0] <= fp || frame[0] - fp > (1 << 20)) {
+                    break;  // stacks grow down, so callers live at higher addresses
+                }
+                fp = frame[0];
+            }
+            sample.depth.store(depth, std::memory_order_release);
+        }
+
+        static std::vector<Mapping> read_mappings() {
+            std::vector<Mapping> mappings;
+            std::ifstream maps("/proc/self/maps");
+            std::string line;
+            while (std::getline(maps, line)) {
+                std::istringstream fields(line);
+                std::string range, perms, offset, device, inode, file;
+                fields >> range >> perms >> offset >> device >> inode >> file;
+                if (perms.size() < 3 || perms[2] != 'x') {
+                    continue;
+                }
+                auto dash = range.find('-');
+                mappings.push_back(Mapping{std::stoull(range.substr(0, dash), nullptr, 16),
+                                           std::stoull(range.substr(dash + 1), nullptr, 16),
+                                           std::stoull(offset, nullptr, 16), file});
+            }
+            return mappings;
+        }
+
+        static std::string symbolize(uint64_t address) {
+            Dl_info info{};
+            if (dladdr(reinterpret_cast<void*>(address), &info) == 0 || info.dli_sname == nullptr) {
+                return "";
+            }
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            std::string name = status == 0 && demangled != nullptr ? demangled : info.dli_sname;
+            std::free(demangled);
+            return name;
+        }
+
+        // pprof's profile.proto, field numbers as in github.com/google/pprof/proto/profile.proto
+        std::string encode(int hz, int64_t time_ns, int64_t duration_ns) {
+            std::vector<std::string> strings{""};
+            std::unordered_map<std::string, uint64_t> string_ids{{"", 0}};
+            auto intern = [&](const std::string& text) {
+                auto [it, inserted] = string_ids.emplace(text, strings.size());
+                if (inserted) {
+                    strings.push_back(text);
+                }
+                return it->second;
+            };
+
+            std::map<std::vector<uint64_t>, uint64_t> stacks;
+            size_t captured = std::min(next_.load(std::memory_order_relaxed), capacity_);
+            for (size_t i = 0; i < captured; i++) {
+                uint32_t depth = samples_[i].depth.load(std::memory_order_acquire);
+                if (depth > 0) {
+                    stacks[std::vector<uint64_t>(samples_[i].frames, samples_[i].frames + depth)]++;
+                }
+            }
+
+            auto mappings = read_mappings();
+            std::unordered_map<uint64_t, uint64_t> location_ids;
+            std::unordered_map<std::string, uint64_t> function_ids;
+            std::vector<bool> fully_symbolized(mappings.size(), true);
+            ProtoWriter locations, functions;
+
+            ProtoWriter profile;
+            int64_t period_ns = 1000000000LL / hz;
+            for (auto [type, unit] : {std::pair{"samples", "count"}, std::pair{"cpu", "nanoseconds"}}) {
+                ProtoWriter value_type;
+                value_type.uint_field(1, intern(type));
+                value_type.uint_field(2, intern(unit));
+                profile.bytes_field(1, value_type.str());
+            }
+
+            for (const auto& [stack, count] : stacks) {
+                std::vector<uint64_t> ids;
+                for (uint64_t address : stack) {
+                    auto [it, inserted] = location_ids.emplace(address, location_ids.size() + 1);
+                    ids.push_back(it->second);
+                    if (!inserted) {
+                        continue;
+                    }
+                    std::string name = symbolize(address);
+                    ProtoWriter location;
+                    location.uint_field(1, it->second);
+                    for (size_t m = 0; m < mappings.size(); m++) {
+                        if (address >= mappings[m].start && address < mappings[m].limit) {
+                            location.uint_field(2, m + 1);
+                            fully_symbolized[m] = fully_symbolized[m] && !name.empty();
+                            break;
+                        }
+                    }
+                    location.uint_field(3, address);
+                    if (!name.empty()) {
+                        auto [fn, fn_inserted] = function_ids.emplace(name, function_ids.size() + 1);
+                        if (fn_inserted) {
+                            ProtoWriter function;
+                            function.uint_field(1, fn->second);
+                            function.uint_field(2, intern(name));
+                            function.uint_field(3, intern(name));
+                            functions.bytes_field(5, function.str());
+                        }
+                        ProtoWriter line;
+                        line.uint_field(1, fn->second);
+                        location.bytes_field(4, line.str());
+                    }
+                    locations.bytes_field(4, location.str());
+                }
+                ProtoWriter sample;
+                sample.packed_field(1, ids);
+                sample.packed_field(2, {count, count * static_cast<uint64_t>(period_ns)});
+                profile.bytes_field(2, sample.str());
+            }
+
+            for (size_t m = 0; m < mappings.size(); m++) {
+                ProtoWriter mapping;
+                mapping.uint_field(1, m + 1);
+                mapping.uint_field(2, mappings[m].start);
+                mapping.uint_field(3, mappings[m].limit);
+                mapping.uint_field(4, mappings[m].offset);
+                mapping.uint_field(5, intern(mappings[m].file));
+                mapping.uint_field(7, fully_symbolized[m] ? 1 : 0);
+                profile.bytes_field(3, mapping.str());
+            }
+
+            ProtoWriter period_type;
+            period_type.uint_field(1, intern("cpu"));
+            period_type.uint_field(2, intern("nanoseconds"));
+
+            std::string body = profile.str() + locations.str() + functions.str();
+            ProtoWriter tail;
+            for (const auto& text : strings) {
+                tail.bytes_field(6, text);
+            }
+            tail.uint_field(9, static_cast<uint64_t>(time_ns));
+            tail.uint_field(10, static_cast<uint64_t>(duration_ns));
+            tail.bytes_field(11, period_type.str());
+            tail.uint_field(12, static_cast<uint64_t>(period_ns));
+            return body + tail.str();
+        }
+
+        static std::string gzip(const std::string& data) {
+            z_stream stream{};
+            deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+            std::string out(deflateBound(&stream, data.size()), '\0');
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+            stream.avail_in = static_cast<uInt>(data.size());
+            stream.next_out = reinterpret_cast<Bytef*>(out.data());
+            stream.avail_out = static_cast<uInt>(out.size());
+            deflate(&stream, Z_FINISH);
+            out.resize(stream.total_out);
+            deflateEnd(&stream);
+            return out;
+        }
+
+        std::unique_ptr<Sample[]> samples_;
+        size_t capacity_{0};
+        std::atomic<size_t> next_{0};
+        std::atomic<size_t> dropped_{0};
+        std::atomic<bool> active_{false};
+        std::atomic<int> inflight_{0};
+        std::mutex running_;
+    };
+} // namespace tinykube
@@ -0,0 +1,187 @@
+#pragma once
+#include <bitset>
+#include <cstdint>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace tinykube {
+    // days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's algorithm)
+    inline int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+        y -= m <= 2;
+        const int64_t era = (y >= 0 ? y : y - 399) / 400;
+        const unsigned yoe = static_cast<unsigned>(y - era * 400);
+        const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<int64_t>(doe) - 719468;
+    }
+
+    inline void civil_from_days(int64_t z, int64_t& y, unsigned& m, unsigned& d) {
+        z += 719468;
+        const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        const unsigned doe = static_cast<unsigned>(z - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        d = doy - (153 * mp + 2) / 5 + 1;
+        m = mp < 10 ? mp + 3 : mp - 9;
+        y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+    }
+
+    // Standard five-field cron schedule (minute hour day-of-month month
+    // day-of-week), evaluated in UTC. Fields take `*`, `a`, `a-b`, `*/n`,
+    // `a-b/n` and comma lists; day-of-week 7 is Sunday like 0.
+    class CronExpr {
+    public:
+        static std::optional<CronExpr> parse(const std::string& text) {
+            std::istringstream in(text);
+            std::vector<std::string> fields;
+            std::string field;
+            while (in >> field) {
+                fields.push_back(field);
+            }
+            if (fields.size() != 5) {
+                return std::nullopt;
+            }
+
+            CronExpr expr;
+            expr.text_ = text;
+            std::bitset<64> bits;
+            if (!parse_field(fields[0], 0, 59, bits)) return std::nullopt;
+            expr.minutes_ = bits;
+            if (!parse_field(fields[1], 0, 23, bits)) return std::nullopt;
+            expr.hours_ = bits;
+            if (!parse_field(fields[2], 1, 31, bits)) return std::nullopt;
+            expr.days_ = bits;
+            expr.any_day_ = fields[2] == "*";
+            if (!parse_field(fields[3], 1, 12, bits)) return std::nullopt;
+            expr.months_ = bits;
+            if (!parse_field(fields[4], 0, 7, bits)) return std::nullopt;
+            if (bits.test(7)) {
+                bits.set(0);
+            }
+            expr.weekdays_ = bits;
+            expr.any_weekday_ = fields[4] == "*";
+            return expr;
+        }
+
+        // first firing strictly after `after_ms`, or -1 if the expression never
+        // matches (e.g. "0 0 30 2 *")
+        int64_t next_after(int64_t after_ms) const {
+            int64_t minute = after_ms / 60000 + 1;
+            // five years of day steps covers every satisfiable day/month combination
+            for (int guard = 0; guard < 5 * 366 * 3; guard++) {
+                int64_t days = minute / 1440;
+                int64_t year;
+                unsigned month, day;
+                civil_from_days(days, year, month, day);
+
+                if (!months_.test(month)) {
+                    unsigned next_month = month == 12 ? 1 : month + 1;
+                    int64_t next_year = month == 12 ? year + 1 : year;
+                    minute = days_from_civil(next_year, next_month, 1) * 1440;
+                    continue;
+                }
+                if (!day_matches(days, day)) {
+                    minute = (days + 1) * 1440;
+                    continue;
+                }
+                int hour = static_cast<int>(minute % 1440 / 60);
+                if (!hours_.test(hour)) {
+                    int next_hour = hour + 1;
+                    while (next_hour < 24 && !hours_.test(next_hour)) {
+                        next_hour++;
+                    }
+                    minute = days * 1440 + next_hour * 60;
+                    continue;
+                }
+                int min = static_cast<int>(minute % 60);
+                while (min < 60 && !minutes_.test(min)) {
+                    min++;
+                }
+                if (min == 60) {
+                    minute = days * 1440 + (hour + 1) * 60;
+                    continue;
+                }
+                return (days * 1440 + hour * 60 + min) * 60000;
+            }
+            return -1;
+        }
+
+        const std::string& text() const {
+            return text_;
+        }
+    private:
+        bool day_matches(int64_t days, unsigned day) const {
+            int weekday = static_cast<int>(((days % 7) + 11) % 7);  // 1970-01-01 was a Thursday
+            bool dom = days_.test(day);
+            bool dow = weekdays_.test(weekday);
+            // classic cron: when both are restricted, either one matching is enough
+            if (!any_day_ && !any_weekday_) {
+                return dom || dow;
+            }
+            return dom && dow;
+        }
+
+        static bool parse_number(const std::string& text, int& value) {
+            if (text.empty() || text.size() > 2) {
+                return false;
+            }
+            value = 0;
+            for (char c : text) {
+                if (c < '0' || c > '9') {
+                    return false;
+                }
+                value = value * 10 + (c - '0');
+            }
+            return true;
+        }
+
+        static bool parse_field(const std::string& field, int low, int high, std::bitset<64>& bits) {
+            bits.reset();
+            std::istringstream in(field);
+            std::string part;
+            while (std::getline(in, part, ',')) {
+                int step = 1;
+                auto slash = part.find('/');
+                if (slash != std::string::npos) {
+                    if (!parse_number(part.substr(slash + 1), step) || step == 0) {
+                        return false;
+                    }
+                    part = part.substr(0, slash);
+                }
+
+                int first = low, last = high;
+                if (part != "*") {
+                    auto dash = part.find('-');
+                    if (dash == std::string::npos) {
+                        if (!parse_number(part, first)) {
+                            return false;
+                        }
+                        last = slash == std::string::npos ? first : high;
+                    } else if (!parse_number(part.substr(0, dash), first) ||
+                               !parse_number(part.substr(dash + 1), last)) {
+                        return false;
+                    }
+                }
+                if (first < low || last > high || first > last) {
+                    return false;
+                }
+                for (int value = first; value <= last; value += step) {
+                    bits.set(value);
+                }
+            }
+            return bits.any();
+        }
+
+        std::string text_;
+        std::bitset<64> minutes_;
+        std::bitset<64> hours_;
+        std::bitset<64> days_;
+        std::bitset<64> months_;
+        std::bitset<64> weekdays_;
+        bool any_day_{true};
+        bool any_weekday_{true};
+    };
+} // namespace tinykube
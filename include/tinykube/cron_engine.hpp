@@ -0,0 +1,393 @@
+#pragma once
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "tinykube/cron.hpp"
+#include "tinykube/time.hpp"
+#include "tinykube/timing_wheel.hpp"
+#include "tinykube/workload.hpp"
+
+namespace tinykube {
+    // a recurring (cron) or one-shot (delayed) workload trigger
+    struct CronJob {
+        std::string name;
+        std::string tenant;
+        std::string schedule;  // empty for one-shot jobs
+        Resources request;
+        int64_t next_fire_ms{0};
+    };
+
+    // Fires CronJobs from a TimingWheel on one background thread. Next-fire
+    // times are persisted in an append-only journal, so after a restart every
+    // overdue job fires exactly once (missed runs are coalesced) and then
+    // resumes its normal schedule. Overdue jobs are fired in bounded batches
+    // so catch-up never holds the lock for long, and on_fire runs with the
+    // lock released. Compaction writes a snapshot of the jobs outside the lock
+    // too, and only replaces the journal once the new one is safely on disk.
+    class CronEngine {
+    public:
+        using FireFn = std::function<void(const CronJob&, int64_t fire_ms)>;
+
+        static constexpr size_t FIRE_BATCH = 1024;
+        static constexpr int64_t COMPACT_RETRY_MS = 60'000;  // after a failed rewrite (disk full, EIO)
+
+        CronEngine(std::string journal_path, FireFn on_fire)
+            : journal_path_(std::move(journal_path)), on_fire_(std::move(on_fire)), wheel_(tinykube::now_ms()) {}
+
+        ~CronEngine() {
+            stop();
+        }
+
+        CronEngine(const CronEngine&) = delete;
+        CronEngine& operator=(const CronEngine&) = delete;
+
+        // replays the journal, then starts the firing thread
+        void start() {
+            load();
+            thread_ = std::thread([this] { run(); });
+        }
+
+        void stop() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (stopping_) {
+                    return;
+                }
+                stopping_ = true;
+            }
+            cv_.notify_all();
+            if (thread_.joinable()) {
+                thread_.join();
+            }
+        }
+
+        // adds or replaces a job; a one-shot job needs `next_fire_ms` set
+        bool put(CronJob job, std::string& reason) {
+            auto has_space = [](const std::string& text) {
+                return text.empty() || text.find_first_of(" \t\n") != std::string::npos;
+            };
+            if (has_space(job.name) || has_space(job.tenant)) {
+                reason = "Job and tenant names must be non-empty and contain no whitespace";
+                return false;
+            }
+            int64_t now = tinykube::now_ms();
+            if (!job.schedule.empty()) {
+                auto expr = CronExpr::parse(job.schedule);
+                if (!expr) {
+                    reason = "Invalid cron schedule";
+                    return false;
+                }
+                job.next_fire_ms = expr->next_after(now);
+                if (job.next_fire_ms < 0) {
+                    reason = "Schedule never fires";
+                    return false;
+                }
+            } else if (job.next_fire_ms <= 0) {
+                reason = "One-shot jobs need a fire time";
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::string job_key = key(job.tenant, job.name);
+            auto& entry = jobs_[job_key];
+            if (entry.id != 0) {
+                ids_.erase(entry.id);  // a replaced job's old wheel entry goes stale
+            }
+            entry.job = std::move(job);
+            entry.id = ++next_id_;
+            entry.expr = entry.job.schedule.empty() ? std::nullopt : CronExpr::parse(entry.job.schedule);
+            ids_[entry.id] = job_key;
+            wheel_.schedule(entry.id, entry.job.next_fire_ms);
+            journal_define(entry.job);
+            flush_journal();
+            cv_.notify_all();
+            return true;
+        }
+
+        bool remove(const std::string& tenant, const std::string& name) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = jobs_.find(key(tenant, name));
+            if (it == jobs_.end()) {
+                return false;
+            }
+            // the wheel entry goes stale and is dropped when it comes due
+            ids_.erase(it->second.id);
+            jobs_.erase(it);
+            journal_line("D " + tenant + " " + name);
+            flush_journal();
+            return true;
+        }
+
+        int64_t next_fire(const std::string& tenant, const std::string& name) const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = jobs_.find(key(tenant, name));
+            return it == jobs_.end() ? -1 : it->second.job.next_fire_ms;
+        }
+
+        size_t size() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return jobs_.size();
+        }
+    private:
+        struct Entry {
+            CronJob job;
+            std::optional<CronExpr> expr;
+            uint64_t id{0};
+        };
+
+        static std::string key(const std::string& tenant, const std::string& name) {
+            return tenant + "/" + name;
+        }
+
+        struct Firing {
+            CronJob job;
+            int64_t fire_ms;
+        };
+
+        void run() {
+            std::vector<TimingWheel::Timer> due;
+            std::vector<Firing> fired;
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!stopping_) {
+                auto wake = wheel_.next_wakeup();
+                if (wake) {
+                    int64_t delay = *wake - tinykube::now_ms();
+                    if (delay > 0) {
+                        cv_.wait_for(lock, std::chrono::milliseconds(delay));
+                    }
+                } else {
+                    cv_.wait(lock);
+                }
+                if (stopping_) {
+                    break;
+                }
+
+                due.clear();
+                wheel_.advance(tinykube::now_ms(), due);
+                for (size_t i = 0; i < due.size(); i++) {
+                    fire(due[i], fired);
+                    if ((i + 1) % FIRE_BATCH == 0 || i + 1 == due.size()) {
+                        // hand the batch over unlocked, letting RPCs adding or
+                        // removing jobs in between catch-up batches
+                        flush_journal();
+                        lock.unlock();
+                        for (const auto& firing : fired) {
+                            on_fire_(firing.job, firing.fire_ms);
+                        }
+                        fired.clear();
+                        lock.lock();
+                    }
+                }
+                flush_journal();
+                compact_if_needed(lock);
+            }
+            flush_journal();
+        }
+
+        // updates the job's bookkeeping and queues it for on_fire
+        void fire(const TimingWheel::Timer& timer, std::vector<Firing>& fired) {
+            auto id_it = ids_.find(timer.id);
+            if (id_it == ids_.end()) {
+                return;  // removed or replaced since it was scheduled
+            }
+            auto job_it = jobs_.find(id_it->second);
+            Entry& entry = job_it->second;
+            int64_t now = tinykube::now_ms();
+            fired.push_back({entry.job, entry.job.next_fire_ms});
+
+            if (!entry.expr) {
+                ids_.erase(id_it);
+                journal_line("D " + entry.job.tenant + " " + entry.job.name);
+                jobs_.erase(job_it);
+                return;
+            }
+            // computed from now, not the missed fire time, so downtime fires once
+            entry.job.next_fire_ms = entry.expr->next_after(std::max(now, entry.job.next_fire_ms));
+            wheel_.schedule(entry.id, entry.job.next_fire_ms);
+            journal_line("N " + entry.job.tenant + " " + entry.job.name + " " + std::to_string(entry.job.next_fire_ms));
+        }
+
+        // Journal records, one per line:
+        //   S <tenant> <name> <cpu_millis> <memory_mb> <next_fire_ms> [<schedule>]
+        //   N <tenant> <name> <next_fire_ms>
+        //   D <tenant> <name>
+        void journal_define(const CronJob& job) {
+            std::ostringstream line;
+            line << "S " << job.tenant << " " << job.name << " " << job.request.cpu_millis << " "
+                 << job.request.memory_mb << " " << job.next_fire_ms;
+            if (!job.schedule.empty()) {
+                line << " " << job.schedule;
+            }
+            journal_line(line.str());
+        }
+
+        void journal_line(const std::string& line) {
+            pending_journal_ += line;
+            pending_journal_ += '\n';
+            journal_records_++;
+            if (pending_journal_.size() > (1 << 16)) {
+                flush_journal();
+            }
+        }
+
+        void flush_journal() {
+            if (pending_journal_.empty() || journal_path_.empty()) {
+                pending_journal_.clear();
+                return;
+            }
+            std::ofstream out(journal_path_, std::ios::app);
+            out << pending_journal_;
+            if (compacting_) {
+                compacted_tail_ += pending_journal_;  // the journal being replaced has these; the new one needs them too
+            }
+            pending_journal_.clear();
+        }
+
+        // Rewrites the journal as one S record per job once it is mostly
+        // history. The jobs are copied under the lock and written without it;
+        // records made meanwhile go to the old journal as usual and are also
+        // kept, then appended to the new one just before it replaces the old.
+        // Any failed write leaves the old journal in place.
+        void compact_if_needed(std::unique_lock<std::mutex>& lock) {
+            if (journal_path_.empty() || journal_records_ < 2 * jobs_.size() + 1024 ||
+                tinykube::now_ms() < compact_retry_ms_) {
+                return;
+            }
+            std::vector<CronJob> jobs;
+            jobs.reserve(jobs_.size());
+            for (const auto& [_, entry] : jobs_) {
+                jobs.push_back(entry.job);
+            }
+            size_t records_before = journal_records_;
+            journal_records_ = jobs.size();
+            compacting_ = true;
+            compacted_tail_.clear();
+            lock.unlock();
+
+            std::string tmp_path = journal_path_ + ".tmp";
+            std::string text;
+            std::ostringstream line;
+            bool ok = write_file(tmp_path, "", false);
+            for (size_t i = 0; ok && i < jobs.size(); i++) {
+                const auto& job = jobs[i];
+                line.str("");
+                line << "S " << job.tenant << " " << job.name << " " << job.request.cpu_millis << " "
+                     << job.request.memory_mb << " " << job.next_fire_ms;
+                if (!job.schedule.empty()) {
+                    line << " " << job.schedule;
+                }
+                line << "\n";
+                text += line.str();
+                if (text.size() > (1 << 20) || i + 1 == jobs.size()) {
+                    ok = write_file(tmp_path, text, true);
+                    text.clear();
+                }
+            }
+
+            lock.lock();
+            flush_journal();
+            compacting_ = false;
+            ok = ok && write_file(tmp_path, compacted_tail_, true, true) &&
+                 std::rename(tmp_path.c_str(), journal_path_.c_str()) == 0;
+            compacted_tail_.clear();
+            if (!ok) {
+                ::unlink(tmp_path.c_str());
+                journal_records_ += records_before - jobs.size();
+                compact_retry_ms_ = tinykube::now_ms() + COMPACT_RETRY_MS;
+            }
+        }
+
+        // writes all of `data` (truncating unless `append`), then optionally
+        // fsyncs; false on any short write or error
+        static bool write_file(const std::string& path, std::string_view data, bool append, bool sync = false) {
+            int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0644);
+            if (fd < 0) {
+                return false;
+            }
+            bool ok = true;
+            while (ok && !data.empty()) {
+                ssize_t n = ::write(fd, data.data(), data.size());
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                ok = n > 0;
+                if (ok) {
+                    data.remove_prefix(static_cast<size_t>(n));
+                }
+            }
+            ok = ok && (!sync || ::fsync(fd) == 0);
+            return ::close(fd) == 0 && ok;
+        }
+
+        void load() {
+            if (journal_path_.empty()) {
+                return;
+            }
+            std::ifstream in(journal_path_);
+            std::string line;
+            std::lock_guard<std::mutex> lock(mutex_);
+            while (std::getline(in, line)) {
+                std::istringstream fields(line);
+                std::string type, tenant, name;
+                fields >> type >> tenant >> name;
+                std::string job_key = key(tenant, name);
+                if (type == "S") {
+                    CronJob job;
+                    job.tenant = tenant;
+                    job.name = name;
+                    fields >> job.request.cpu_millis >> job.request.memory_mb >> job.next_fire_ms;
+                    std::getline(fields >> std::ws, job.schedule);
+                    auto& entry = jobs_[job_key];
+                    entry.job = std::move(job);
+                    entry.expr = entry.job.schedule.empty() ? std::nullopt : CronExpr::parse(entry.job.schedule);
+                } else if (type == "N") {
+                    auto it = jobs_.find(job_key);
+                    if (it != jobs_.end()) {
+                        fields >> it->second.job.next_fire_ms;
+                    }
+                } else if (type == "D") {
+                    jobs_.erase(job_key);
+                }
+                journal_records_++;
+            }
+            // overdue jobs land at the wheel's cursor and fire in the first batches
+            for (auto& [job_key, entry] : jobs_) {
+                entry.id = ++next_id_;
+                ids_[entry.id] = job_key;
+                wheel_.schedule(entry.id, entry.job.next_fire_ms);
+            }
+        }
+
+        std::string journal_path_;
+        FireFn on_fire_;
+        TimingWheel wheel_;
+        std::unordered_map<std::string, Entry> jobs_;
+        std::unordered_map<uint64_t, std::string> ids_;
+        uint64_t next_id_{0};
+        std::string pending_journal_;
+        size_t journal_records_{0};
+        bool compacting_{false};
+        std::string compacted_tail_;  // records appended while a compaction writes, for the new journal
+        int64_t compact_retry_ms_{0};
+        bool stopping_{false};
+        mutable std::mutex mutex_;
+        std::condition_variable cv_;
+        std::thread thread_;
+    };
+} // namespace tinykube
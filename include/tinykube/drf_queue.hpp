@@ -0,0 +1,207 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tinykube/workload.hpp"
+
+namespace tinykube {
+    // Pending workloads, one FIFO per tenant, handed out in dominant resource
+    // fairness order: the next workload always comes from the tenant whose
+    // largest share of any cluster resource is smallest. Tenants with pending
+    // work sit in an indexed min-heap keyed by that share, so picking, charging
+    // and releasing are O(log tenants). Not thread-safe; the scheduler locks.
+    class DrfQueue {
+    public:
+        // shares are relative to the cluster total, so a capacity change reorders everyone
+        void set_capacity(const Resources& total) {
+            if (total.cpu_millis == capacity_.cpu_millis && total.memory_mb == capacity_.memory_mb) {
+                return;
+            }
+            capacity_ = total;
+            for (auto& tenant : tenants_) {
+                tenant.share = dominant_share(tenant.allocated);
+            }
+            for (size_t i = heap_.size() / 2; i-- > 0;) {
+                sift_down(i);
+            }
+        }
+
+        void push(Workload workload) {
+            size_t slot = slot_for(workload.tenant);
+            tenants_[slot].pending.push_back(std::move(workload));
+            if (tenants_[slot].heap_pos == NOT_IN_HEAP) {
+                heap_insert(slot);
+            }
+        }
+
+        // takes the next workload and charges its request to its tenant
+        std::optional<Workload> pop() {
+            if (heap_.empty()) {
+                return std::nullopt;
+            }
+            size_t slot = heap_.front();
+            auto& tenant = tenants_[slot];
+            Workload workload = std::move(tenant.pending.front());
+            tenant.pending.pop_front();
+            tenant.served = ++served_seq_;
+            charge(slot, workload.request);
+            if (tenant.pending.empty()) {
+                heap_erase(slot);
+            }
+            return workload;
+        }
+
+        // undoes a pop() whose workload could not be placed
+        void unpop(Workload workload) {
+            size_t slot = slot_for(workload.tenant);
+            Resources request = workload.request;
+            tenants_[slot].pending.push_front(std::move(workload));
+            if (tenants_[slot].heap_pos == NOT_IN_HEAP) {
+                heap_insert(slot);
+            }
+            release(tenants_[slot].name, request);
+        }
+
+        // a workload finished: its tenant's share drops and it moves up the heap
+        void release(const std::string& tenant_name, const Resources& request) {
+            auto it = index_.find(tenant_name);
+            if (it == index_.end()) {
+                return;
+            }
+            Resources negative;
+            negative -= request;
+            charge(it->second, negative);
+        }
+
+        double share(const std::string& tenant_name) const {
+            auto it = index_.find(tenant_name);
+            return it == index_.end() ? 0.0 : tenants_[it->second].share;
+        }
+
+        size_t pending() const {
+            size_t total = 0;
+            for (size_t slot : heap_) {
+                total += tenants_[slot].pending.size();
+            }
+            return total;
+        }
+
+        bool empty() const {
+            return heap_.empty();
+        }
+    private:
+        static constexpr size_t NOT_IN_HEAP = SIZE_MAX;
+
+        struct TenantState {
+            std::string name;
+            std::deque<Workload> pending;
+            Resources allocated;
+            double share{0.0};
+            uint64_t served{0};  // breaks share ties in favor of whoever waited longest
+            size_t heap_pos{NOT_IN_HEAP};
+        };
+
+        double dominant_share(const Resources& allocated) const {
+            double cpu = capacity_.cpu_millis > 0 ? static_cast<double>(allocated.cpu_millis) / capacity_.cpu_millis : 0.0;
+            double mem = capacity_.memory_mb > 0 ? static_cast<double>(allocated.memory_mb) / capacity_.memory_mb : 0.0;
+            return std::max(cpu, mem);
+        }
+
+        size_t slot_for(const std::string& tenant_name) {
+            auto [it, inserted] = index_.try_emplace(tenant_name, tenants_.size());
+            if (inserted) {
+                TenantState tenant;
+                tenant.name = tenant_name;
+                tenants_.push_back(std::move(tenant));
+            }
+            return it->second;
+        }
+
+        void charge(size_t slot, const Resources& delta) {
+            auto& tenant = tenants_[slot];
+            tenant.allocated += delta;
+            double before = tenant.share;
+            tenant.share = dominant_share(tenant.allocated);
+            if (tenant.heap_pos == NOT_IN_HEAP) {
+                return;
+            }
+            if (tenant.share < before) {
+                sift_up(tenant.heap_pos);
+            } else {
+                sift_down(tenant.heap_pos);
+            }
+        }
+
+        bool before(size_t a, size_t b) const {
+            const auto& lhs = tenants_[a];
+            const auto& rhs = tenants_[b];
+            return lhs.share < rhs.share || (lhs.share == rhs.share && lhs.served < rhs.served);
+        }
+
+        void place(size_t pos, size_t slot) {
+            heap_[pos] = slot;
+            tenants_[slot].heap_pos = pos;
+        }
+
+        void sift_up(size_t pos) {
+            size_t slot = heap_[pos];
+            while (pos > 0) {
+                size_t parent = (pos - 1) / 2;
+                if (!before(slot, heap_[parent])) {
+                    break;
+                }
+                place(pos, heap_[parent]);
+                pos = parent;
+            }
+            place(pos, slot);
+        }
+
+        void sift_down(size_t pos) {
+            size_t slot = heap_[pos];
+            while (true) {
+                size_t child = 2 * pos + 1;
+                if (child >= heap_.size()) {
+                    break;
+                }
+                if (child + 1 < heap_.size() && before(heap_[child + 1], heap_[child])) {
+                    child++;
+                }
+                if (!before(heap_[child], slot)) {
+                    break;
+                }
+                place(pos, heap_[child]);
+                pos = child;
+            }
+            place(pos, slot);
+        }
+
+        void heap_insert(size_t slot) {
+            heap_.push_back(slot);
+            tenants_[slot].heap_pos = heap_.size() - 1;
+            sift_up(heap_.size() - 1);
+        }
+
+        void heap_erase(size_t slot) {
+            size_t pos = tenants_[slot].heap_pos;
+            tenants_[slot].heap_pos = NOT_IN_HEAP;
+            size_t last = heap_.back();
+            heap_.pop_back();
+            if (pos < heap_.size()) {
+                place(pos, last);
+                sift_down(pos);
+                sift_up(tenants_[last].heap_pos);
+            }
+        }
+
+        Resources capacity_;
+        std::vector<TenantState> tenants_;
+        std::unordered_map<std::string, size_t> index_;
+        std::vector<size_t> heap_;  // tenant slots with pending work
+        uint64_t served_seq_{0};
+    };
+} // namespace tinykube
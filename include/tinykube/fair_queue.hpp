@@ -0,0 +1,98 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace tinykube {
+    // Runs control-plane work on a small worker pool, taking one task per tenant
+    // in round-robin order. A tenant flooding the queue only lengthens its own
+    // backlog; everyone else still gets a turn every pass.
+    class FairWorkQueue {
+    public:
+        FairWorkQueue(size_t workers = 2, size_t per_tenant_limit = 4096)
+            : per_tenant_limit_(per_tenant_limit) {
+            for (size_t i = 0; i < workers; i++) {
+                workers_.emplace_back([this] { run(); });
+            }
+        }
+
+        ~FairWorkQueue() {
+            stop();
+        }
+
+        FairWorkQueue(const FairWorkQueue&) = delete;
+        FairWorkQueue& operator=(const FairWorkQueue&) = delete;
+
+        // false if the tenant's backlog is full or the queue is stopping
+        bool submit(const std::string& tenant, std::function<void()> task) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (stopping_) {
+                    return false;
+                }
+                auto& queue = queues_[tenant];
+                if (queue.size() >= per_tenant_limit_) {
+                    return false;
+                }
+                if (queue.empty()) {
+                    active_.push_back(tenant);
+                }
+                queue.push_back(std::move(task));
+            }
+            cv_.notify_one();
+            return true;
+        }
+
+        // drains what's already queued, then joins the workers
+        void stop() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (stopping_) {
+                    return;
+                }
+                stopping_ = true;
+            }
+            cv_.notify_all();
+            for (auto& worker : workers_) {
+                worker.join();
+            }
+        }
+    private:
+        void run() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (true) {
+                cv_.wait(lock, [this] { return stopping_ || !active_.empty(); });
+                if (active_.empty()) {
+                    return;
+                }
+                std::string tenant = std::move(active_.front());
+                active_.pop_front();
+                auto& queue = queues_[tenant];
+                auto task = std::move(queue.front());
+                queue.pop_front();
+                if (!queue.empty()) {
+                    active_.push_back(tenant);  // back of the line until everyone else had a turn
+                } else {
+                    queues_.erase(tenant);  // idle tenants cost nothing
+                }
+
+                lock.unlock();
+                task();
+                lock.lock();
+            }
+        }
+
+        size_t per_tenant_limit_;
+        std::unordered_map<std::string, std::deque<std::function<void()>>> queues_;
+        std::deque<std::string> active_;
+        bool stopping_{false};
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::vector<std::thread> workers_;
+    };
+} // namespace tinykube
@@ -0,0 +1,186 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "control_plane.pb.h"
+
+#include "tinykube/time.hpp"
+#include "tinykube/types.hpp"
+
+namespace tinykube {
+    inline constexpr size_t NODE_STATUS_COUNT = 6;
+
+    // what the federator (and tinykubectl top) keeps per member node: enough
+    // for drill-down
+    struct MemberNode {
+        std::string tenant;
+        std::string name;
+        std::string peer;
+        NodeStatus status{NodeStatus::NOT_READY};
+        bool unschedulable{false};
+        int64_t cpu_millis{0};
+        int64_t memory_mb{0};
+        int64_t last_seen_ms{0};
+    };
+
+    // one member cluster's counts and health
+    struct ClusterSummary {
+        std::string name;
+        std::string address;
+        bool connected{false};
+        uint64_t revision{0};
+        int64_t last_event_ms{0};
+        uint64_t resyncs{0};  // full snapshots taken after the first
+        size_t nodes{0};
+        std::array<size_t, NODE_STATUS_COUNT> by_status{};
+        size_t unschedulable{0};
+        int64_t alive_cpu_millis{0};  // capacity of READY and DEGRADED nodes
+        int64_t alive_memory_mb{0};
+
+        size_t count(NodeStatus status) const {
+            auto index = static_cast<size_t>(status);
+            return index < by_status.size() ? by_status[index] : 0;
+        }
+
+        // folds another cluster in, for the global total
+        void add(const ClusterSummary& other) {
+            connected = connected && other.connected;
+            nodes += other.nodes;
+            for (size_t i = 0; i < by_status.size(); i++) {
+                by_status[i] += other.by_status[i];
+            }
+            unschedulable += other.unschedulable;
+            alive_cpu_millis += other.alive_cpu_millis;
+            alive_memory_mb += other.alive_memory_mb;
+            resyncs += other.resyncs;
+        }
+    };
+
+    // A member's registry rebuilt from its WatchNodes stream. The counters
+    // move by one per changed node, so a summary costs the same for ten
+    // nodes as for a hundred thousand; only drill-down walks the nodes.
+    class ClusterMirror {
+    public:
+        ClusterMirror(std::string name, std::string address) : name_(std::move(name)), address_(std::move(address)) {}
+
+        void apply(const NodeEvent& event) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (event.snapshot()) {
+                summary_.resyncs += snapshots_++ > 0 ? 1 : 0;
+                nodes_.clear();
+                summary_.nodes = 0;
+                summary_.by_status = {};
+                summary_.unschedulable = 0;
+                summary_.alive_cpu_millis = 0;
+                summary_.alive_memory_mb = 0;
+            }
+            for (const auto& record : event.nodes()) {
+                std::string key = record.tenant() + '\n' + record.name();
+                auto [it, inserted] = nodes_.try_emplace(std::move(key));
+                if (!inserted) {
+                    count(it->second, -1);
+                }
+                MemberNode& node = it->second;
+                node.tenant = record.tenant();
+                node.name = record.name();
+                node.peer = record.peer();
+                node.status = static_cast<NodeStatus>(record.status());
+                node.unschedulable = record.unschedulable();
+                node.cpu_millis = record.cpu_millis();
+                node.memory_mb = record.memory_mb();
+                node.last_seen_ms = record.last_seen_ms();
+                count(node, +1);
+            }
+            for (const auto& name : event.removed()) {
+                auto it = nodes_.find(event.tenant() + '\n' + name);
+                if (it != nodes_.end()) {
+                    count(it->second, -1);
+                    nodes_.erase(it);
+                }
+            }
+            summary_.revision = event.revision();
+            summary_.last_event_ms = now_ms();
+            summary_.connected = true;
+        }
+
+        void set_connected(bool connected) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            summary_.connected = connected;
+        }
+
+        ClusterSummary summary() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ClusterSummary summary = summary_;
+            summary.name = name_;
+            summary.address = address_;
+            return summary;
+        }
+
+        // nodes of `tenant` (empty for all) in `status` (RESERVED for any),
+        // at most `limit` of them; `matched` counts them all
+        std::vector<MemberNode> nodes(const std::string& tenant, NodeStatus status, size_t limit,
+                                      size_t& matched) const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::vector<MemberNode> out;
+            matched = 0;
+            for (const auto& [key, node] : nodes_) {
+                if ((!tenant.empty() && node.tenant != tenant) ||
+                    (status != NodeStatus::RESERVED && node.status != status)) {
+                    continue;
+                }
+                if (matched++ < limit) {
+                    out.push_back(node);
+                }
+            }
+            return out;
+        }
+
+        std::optional<MemberNode> get(const std::string& tenant, const std::string& name) const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = nodes_.find(tenant + '\n' + name);
+            if (it == nodes_.end()) {
+                return std::nullopt;
+            }
+            return it->second;
+        }
+
+        // visits every node under the mirror's lock, so keep `fn` short
+        template <typename Fn>
+        void for_each_node(Fn&& fn) const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& [key, node] : nodes_) {
+                fn(node);
+            }
+        }
+
+        // const, so readable without the lock
+        const std::string& name() const {
+            return name_;
+        }
+    private:
+        void count(const MemberNode& node, int delta) {
+            auto index = static_cast<size_t>(node.status);
+            summary_.nodes += delta;
+            if (index < summary_.by_status.size()) {
+                summary_.by_status[index] += delta;
+            }
+            summary_.unschedulable += node.unschedulable ? delta : 0;
+            if (node.status == NodeStatus::READY || node.status == NodeStatus::DEGRADED) {
+                summary_.alive_cpu_millis += delta * node.cpu_millis;
+                summary_.alive_memory_mb += delta * node.memory_mb;
+            }
+        }
+
+        const std::string name_;
+        const std::string address_;
+        mutable std::mutex mutex_;
+        ClusterSummary summary_;  // name and address are filled in by summary()
+        std::unordered_map<std::string, MemberNode> nodes_;
+        uint64_t snapshots_{0};
+    };
+} // namespace tinykube
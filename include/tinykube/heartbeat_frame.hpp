@@ -0,0 +1,138 @@
+#pragma once
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace tinykube {
+    inline constexpr uint32_t FRAME_MAGIC = 0x31424b54;  // "TKB1"
+
+    // Fixed-size heartbeat frame for the transports that bypass gRPC. Host
+    // byte order: agents and the control plane share an architecture.
+    struct HeartbeatFrame {
+        uint32_t magic{FRAME_MAGIC};
+        uint8_t tenant_len{0};
+        uint8_t node_len{0};
+        uint16_t reserved{0};
+        int64_t client_ms{0};
+        char tenant[48]{};
+        char node[64]{};
+
+        std::string_view tenant_name() const {
+            return {tenant, tenant_len};
+        }
+
+        std::string_view node_name() const {
+            return {node, node_len};
+        }
+
+        bool valid() const {
+            return magic == FRAME_MAGIC && tenant_len <= sizeof(tenant) && node_len > 0 && node_len <= sizeof(node);
+        }
+    };
+    static_assert(sizeof(HeartbeatFrame) == 128);
+
+    // false if a name doesn't fit
+    inline bool make_frame(const std::string& tenant, const std::string& node, int64_t client_ms,
+                           HeartbeatFrame& frame) {
+        if (tenant.size() > sizeof(frame.tenant) || node.empty() || node.size() > sizeof(frame.node)) {
+            return false;
+        }
+        frame = HeartbeatFrame{};
+        frame.tenant_len = static_cast<uint8_t>(tenant.size());
+        frame.node_len = static_cast<uint8_t>(node.size());
+        frame.client_ms = client_ms;
+        std::memcpy(frame.tenant, tenant.data(), tenant.size());
+        std::memcpy(frame.node, node.data(), node.size());
+        return true;
+    }
+
+    // "unix:/path" or "host:port". Returns a listening or connected stream
+    // socket, -1 on failure with `error` set.
+    inline int open_frame_socket(const std::string& address, bool listening, std::string& error) {
+        if (address.rfind("unix:", 0) == 0) {
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            std::string path = address.substr(5);
+            if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+                error = "bad unix socket path";
+                return -1;
+            }
+            std::memcpy(addr.sun_path, path.data(), path.size());
+            int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (listening) {
+                ::unlink(path.c_str());
+            }
+            int result = listening ? ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr))
+                                   : ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+            if (fd < 0 || result != 0 || (listening && ::listen(fd, SOMAXCONN) != 0)) {
+                error = std::strerror(errno);
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+                return -1;
+            }
+            return fd;
+        }
+
+        auto colon = address.rfind(':');
+        if (colon == std::string::npos) {
+            error = "expected host:port or unix:/path";
+            return -1;
+        }
+        std::string host = address.substr(0, colon), port = address.substr(colon + 1);
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = listening ? AI_PASSIVE : 0;
+        addrinfo* results = nullptr;
+        if (int status = ::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &results)) {
+            error = ::gai_strerror(status);
+            return -1;
+        }
+        int fd = -1;
+        error = "no usable address";
+        for (addrinfo* ai = results; ai != nullptr && fd < 0; ai = ai->ai_next) {
+            fd = ::socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+            if (fd < 0) {
+                continue;
+            }
+            int one = 1;
+            bool ok = listening
+                ? ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == 0 &&
+                  ::bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && ::listen(fd, SOMAXCONN) == 0
+                : ::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0;
+            if (!ok) {
+                error = std::strerror(errno);
+                ::close(fd);
+                fd = -1;
+            }
+        }
+        ::freeaddrinfo(results);
+        return fd;
+    }
+
+    // blocking; false once the peer is gone
+    inline bool send_frames(int fd, const HeartbeatFrame* frames, size_t count) {
+        const char* data = reinterpret_cast<const char*>(frames);
+        size_t remaining = count * sizeof(HeartbeatFrame);
+        while (remaining > 0) {
+            ssize_t sent = ::send(fd, data, remaining, MSG_NOSIGNAL);
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent <= 0) {
+                return false;
+            }
+            data += sent;
+            remaining -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+} // namespace tinykube
@@ -0,0 +1,847 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "tinykube/heartbeat_frame.hpp"
+#include "tinykube/time.hpp"
+#include "tinykube/trace.hpp"
+
+namespace tinykube {
+    // a parsed request; the views point into the connection's input buffer
+    // and are valid for the duration of the handler call
+    struct HttpRequest {
+        std::string_view method;
+        std::string_view path;
+        std::string_view query;
+        bool head{false};
+        bool has_etag{false};   // If-None-Match carried one of our revision tags
+        uint64_t etag_revision{0};
+        bool has_last_event_id{false};  // an EventSource reconnecting
+        uint64_t last_event_id{0};
+
+        std::string_view query_param(std::string_view name) const {
+            std::string_view rest = query;
+            while (!rest.empty()) {
+                auto amp = rest.find('&');
+                std::string_view pair = rest.substr(0, amp);
+                rest = amp == std::string_view::npos ? std::string_view() : rest.substr(amp + 1);
+                auto eq = pair.find('=');
+                if (pair.substr(0, eq) == name) {
+                    return eq == std::string_view::npos ? std::string_view() : pair.substr(eq + 1);
+                }
+            }
+            return {};
+        }
+
+        // the one comparison a conditional poll costs
+        bool not_modified(uint64_t revision) const {
+            return has_etag && etag_revision == revision;
+        }
+    };
+
+    // Filled in by the handler. body is the connection's own buffer, cleared
+    // before each request, so a steady stream of requests reuses its memory.
+    // Setting stream switches to chunked transfer: it is called each time the
+    // socket has drained, appends the next piece to out and returns false
+    // once that was the last one. Setting subscribe instead keeps the
+    // connection open after the body as a server-sent event stream: frames
+    // queued here go first, then every frame passed to publish().
+    struct HttpResponse {
+        int status{200};
+        const char* content_type{"application/json"};
+        bool has_etag{false};
+        uint64_t etag_revision{0};
+        std::string& body;
+        std::function<bool(std::string& out)> stream;
+        bool subscribe{false};
+        std::vector<std::shared_ptr<const std::string>> frames;
+
+        void set_etag(uint64_t revision) {
+            has_etag = true;
+            etag_revision = revision;
+        }
+    };
+
+    struct HttpServerStats {
+        uint64_t requests{0};
+        uint64_t not_modified{0};  // 304s answered from the ETag alone
+        uint64_t streamed{0};      // chunked responses
+        uint64_t bad_requests{0};
+        uint64_t connections{0};
+        uint64_t open{0};
+        uint64_t subscribers{0};   // open event streams
+        uint64_t published{0};     // frames handed to publish()
+        uint64_t overflows{0};     // backlogs dropped for a resync
+        uint64_t idle_closed{0};   // connections closed after idle_timeout_ms without progress
+        uint64_t accept_pauses{0}; // times the listener was set aside: full, or out of fds
+        uint64_t refused_streams{0};  // event streams answered 503 at max_subscribers
+    };
+
+    // Event streams are capped apart from request connections: a dashboard
+    // tab holds its stream for hours, so thousands of them must neither be
+    // turned away by nor crowd out the connections answering requests.
+    struct HttpServerLimits {
+        size_t max_connections{1024};   // open connections not streaming events
+        size_t max_subscribers{16384};  // open event streams
+        int64_t idle_timeout_ms{60'000};  // event streams get a ping well within this
+    };
+
+    // Minimal HTTP/1.1 server for read-only GET/HEAD endpoints: one thread,
+    // one level-triggered epoll, non-blocking sockets, keep-alive and
+    // pipelining (requests are answered in order, one at a time). Bodies
+    // are either built whole in the connection's buffer or streamed in
+    // chunks as the peer reads them, so a slow reader never holds more than
+    // one chunk. ETags are weak revision tags, W/"<revision>".
+    //
+    // Event stream subscribers share published frames: each one queues
+    // pointers, not copies, and is written with one sendmsg per batch. A
+    // subscriber whose backlog passes MAX_SUBSCRIBER_BACKLOG has it dropped
+    // and gets the overflow frame (a resync marker) instead; until that is
+    // written, new frames are skipped, since the client refetches anyway.
+    //
+    // At max_connections request connections, or when accept() runs out of
+    // fds, the listener is taken out of the epoll set (it is level-triggered
+    // and would otherwise spin) until a connection closes or
+    // ACCEPT_BACKOFF_MS passes. A subscription past max_subscribers is
+    // answered 503. A connection that neither reads nor gets a byte written
+    // for idle_timeout_ms is closed.
+    class HttpServer {
+    public:
+        using Handler = std::function<void(const HttpRequest& request, HttpResponse& response)>;
+
+        static constexpr size_t MAX_REQUEST_BYTES = 16 * 1024;
+        static constexpr int MAX_EVENTS = 64;
+        static constexpr size_t MAX_SUBSCRIBER_BACKLOG = 256 * 1024;
+        static constexpr int MAX_IOVECS = 64;
+        static constexpr int64_t IDLE_SWEEP_MS = 1000;
+        static constexpr int64_t ACCEPT_BACKOFF_MS = 100;
+
+        explicit HttpServer(Handler handler, HttpServerLimits limits = {})
+            : handler_(std::move(handler)), limits_(limits) {}
+
+        ~HttpServer() {
+            stop();
+        }
+
+        HttpServer(const HttpServer&) = delete;
+        HttpServer& operator=(const HttpServer&) = delete;
+
+        bool start(const std::string& address, std::string& error) {
+            listen_fd_ = open_frame_socket(address, true, error);
+            if (listen_fd_ < 0) {
+                return false;
+            }
+            ::fcntl(listen_fd_, F_SETFL, ::fcntl(listen_fd_, F_GETFL) | O_NONBLOCK);
+            epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+            wake_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            publish_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            if (epoll_fd_ < 0 || wake_fd_ < 0 || publish_fd_ < 0 || !watch(listen_fd_, EPOLLIN, EPOLL_CTL_ADD) ||
+                !watch(wake_fd_, EPOLLIN, EPOLL_CTL_ADD) || !watch(publish_fd_, EPOLLIN, EPOLL_CTL_ADD)) {
+                error = std::string("epoll: ") + std::strerror(errno);
+                release();
+                return false;
+            }
+            thread_ = std::thread([this] { run(); });
+            return true;
+        }
+
+        void stop() {
+            if (!thread_.joinable()) {
+                return;
+            }
+            uint64_t one = 1;
+            ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+            (void)written;
+            thread_.join();
+            release();
+        }
+
+        // what a subscriber gets in place of the backlog it couldn't keep up with
+        void set_overflow_frame(std::shared_ptr<const std::string> frame) {
+            overflow_frame_ = std::move(frame);
+        }
+
+        // Queues a frame for every event stream subscriber. Any thread; the
+        // server thread is woken once per batch, not per frame.
+        void publish(std::shared_ptr<const std::string> frame) {
+            bool wake;
+            {
+                std::lock_guard<std::mutex> lock(inbox_mutex_);
+                wake = inbox_.empty();
+                inbox_.push_back(std::move(frame));
+            }
+            published_.fetch_add(1, std::memory_order_relaxed);
+            if (wake) {
+                uint64_t one = 1;
+                ssize_t written = ::write(publish_fd_, &one, sizeof(one));
+                (void)written;
+            }
+        }
+
+        HttpServerStats stats() const {
+            HttpServerStats stats;
+            stats.requests = requests_.load(std::memory_order_relaxed);
+            stats.not_modified = not_modified_.load(std::memory_order_relaxed);
+            stats.streamed = streamed_.load(std::memory_order_relaxed);
+            stats.bad_requests = bad_requests_.load(std::memory_order_relaxed);
+            stats.connections = accepted_.load(std::memory_order_relaxed);
+            stats.open = open_.load(std::memory_order_relaxed);
+            stats.subscribers = subscriber_count_.load(std::memory_order_relaxed);
+            stats.published = published_.load(std::memory_order_relaxed);
+            stats.overflows = overflows_.load(std::memory_order_relaxed);
+            stats.idle_closed = idle_closed_.load(std::memory_order_relaxed);
+            stats.accept_pauses = accept_pauses_.load(std::memory_order_relaxed);
+            stats.refused_streams = refused_streams_.load(std::memory_order_relaxed);
+            return stats;
+        }
+    private:
+        struct Connection {
+            int fd{-1};
+            std::string in;
+            std::string out;
+            size_t sent{0};           // bytes of out already written
+            std::string body;
+            std::function<bool(std::string&)> stream;
+            bool chunked{false};      // stream framing: chunks, or raw until close for HTTP/1.0
+            bool keep_alive{true};
+            bool read_closed{false};  // the peer shut down its side
+            bool writing{false};      // registered for EPOLLOUT
+            bool subscribed{false};   // an event stream, fed by publish()
+            std::deque<std::shared_ptr<const std::string>> frames;
+            size_t frame_sent{0};     // bytes of frames.front() already written
+            size_t backlog{0};        // unwritten bytes in frames
+            bool resync_pending{false};
+            int64_t last_active_ms{0};  // last readiness event or write progress, for the idle timeout
+        };
+
+        // level-triggered, so a half-closed peer stops being polled for input
+        void rearm(Connection& connection) {
+            uint32_t events = connection.writing ? static_cast<uint32_t>(EPOLLOUT) : 0;
+            if (!connection.read_closed) {
+                events |= EPOLLIN | EPOLLRDHUP;
+            }
+            watch(connection.fd, events, EPOLL_CTL_MOD);
+        }
+
+        bool watch(int fd, uint32_t events, int op) {
+            epoll_event event{};
+            event.events = events;
+            event.data.fd = fd;
+            return ::epoll_ctl(epoll_fd_, op, fd, &event) == 0;
+        }
+
+        void release() {
+            for (auto& [fd, connection] : connections_) {
+                ::close(fd);
+            }
+            connections_.clear();
+            subscribers_.clear();
+            open_.store(0, std::memory_order_relaxed);
+            subscriber_count_.store(0, std::memory_order_relaxed);
+            for (int* fd : {&wake_fd_, &publish_fd_, &epoll_fd_, &listen_fd_}) {
+                if (*fd >= 0) {
+                    ::close(*fd);
+                    *fd = -1;
+                }
+            }
+        }
+
+        void run() {
+            epoll_event events[MAX_EVENTS];
+            int64_t next_sweep_ms = now_ms() + IDLE_SWEEP_MS;
+            while (true) {
+                int64_t timeout_ms = next_sweep_ms - now_ms();
+                if (accept_paused_ && accept_resume_ms_ > 0) {
+                    timeout_ms = std::min(timeout_ms, accept_resume_ms_ - now_ms());
+                }
+                int count = ::epoll_wait(epoll_fd_, events, MAX_EVENTS, static_cast<int>(std::max<int64_t>(timeout_ms, 0)));
+                if (count < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return;
+                }
+                int64_t now = now_ms();
+                for (int i = 0; i < count; i++) {
+                    int fd = events[i].data.fd;
+                    if (fd == wake_fd_) {
+                        return;
+                    }
+                    if (fd == listen_fd_) {
+                        accept_all();
+                        continue;
+                    }
+                    if (fd == publish_fd_) {
+                        fan_out();
+                        continue;
+                    }
+                    auto it = connections_.find(fd);
+                    if (it == connections_.end()) {
+                        continue;
+                    }
+                    Connection& connection = *it->second;
+                    connection.last_active_ms = now;
+                    bool alive = (events[i].events & (EPOLLERR | EPOLLHUP)) == 0 || !connection.in.empty();
+                    if (alive && (events[i].events & EPOLLIN)) {
+                        alive = receive(connection);
+                    }
+                    if (alive && (events[i].events & EPOLLOUT)) {
+                        alive = flush(connection);
+                    }
+                    if (!alive) {
+                        close(fd);
+                    }
+                }
+                if (now >= next_sweep_ms) {
+                    close_idle(now);
+                    next_sweep_ms = now + IDLE_SWEEP_MS;
+                }
+                if (accept_paused_ && request_connections() < limits_.max_connections && now >= accept_resume_ms_) {
+                    accept_paused_ = !watch(listen_fd_, EPOLLIN, EPOLL_CTL_MOD);
+                }
+            }
+        }
+
+        void close_idle(int64_t now) {
+            std::vector<int> idle;
+            for (const auto& [fd, connection] : connections_) {
+                if (now - connection->last_active_ms >= limits_.idle_timeout_ms) {
+                    idle.push_back(fd);
+                }
+            }
+            for (int fd : idle) {
+                close(fd);
+            }
+            idle_closed_.fetch_add(idle.size(), std::memory_order_relaxed);
+        }
+
+        size_t request_connections() const {
+            return connections_.size() - subscribers_.size();
+        }
+
+        // stops polling the listener until resume_ms (0: the next close)
+        void pause_accepting(int64_t resume_ms) {
+            if (!accept_paused_) {
+                watch(listen_fd_, 0, EPOLL_CTL_MOD);
+                accept_paused_ = true;
+                accept_pauses_.fetch_add(1, std::memory_order_relaxed);
+            }
+            accept_resume_ms_ = resume_ms;
+        }
+
+        void accept_all() {
+            while (true) {
+                if (request_connections() >= limits_.max_connections) {
+                    pause_accepting(0);
+                    return;
+                }
+                int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0) {
+                    if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                        pause_accepting(now_ms() + ACCEPT_BACKOFF_MS);
+                    }
+                    return;  // EAGAIN, or a connection that went away first
+                }
+                auto connection = std::make_unique<Connection>();
+                connection->fd = fd;
+                connection->last_active_ms = now_ms();
+                if (!watch(fd, EPOLLIN | EPOLLRDHUP, EPOLL_CTL_ADD)) {
+                    ::close(fd);
+                    continue;
+                }
+                connections_.emplace(fd, std::move(connection));
+                accepted_.fetch_add(1, std::memory_order_relaxed);
+                open_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        void close(int fd) {
+            auto it = connections_.find(fd);
+            if (it != connections_.end() && it->second->subscribed) {
+                subscribers_.erase(it->second.get());
+                subscriber_count_.fetch_sub(1, std::memory_order_relaxed);
+            }
+            ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+            ::close(fd);
+            connections_.erase(fd);
+            open_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        // hands the published batch to every subscriber, then writes each once
+        void fan_out() {
+            uint64_t count;
+            ssize_t got = ::read(publish_fd_, &count, sizeof(count));
+            (void)got;
+            {
+                std::lock_guard<std::mutex> lock(inbox_mutex_);
+                batch_.swap(inbox_);
+            }
+            if (batch_.empty()) {
+                return;
+            }
+            TK_TRACE_SPAN("http.fan_out");
+            std::vector<int> dead;
+            for (Connection* connection : subscribers_) {
+                for (const auto& frame : batch_) {
+                    enqueue(*connection, frame);
+                }
+                if (!connection->writing && !write_frames(*connection)) {
+                    dead.push_back(connection->fd);
+                }
+            }
+            batch_.clear();
+            for (int fd : dead) {
+                close(fd);
+            }
+        }
+
+        void enqueue(Connection& connection, const std::shared_ptr<const std::string>& frame) {
+            if (connection.resync_pending) {
+                return;
+            }
+            if (connection.backlog + frame->size() > MAX_SUBSCRIBER_BACKLOG) {
+                overflows_.fetch_add(1, std::memory_order_relaxed);
+                if (!overflow_frame_) {
+                    return;  // nothing to tell the client, the frame is just lost
+                }
+                // keep a half-written frame so the stream stays well-formed
+                size_t keep = connection.frame_sent > 0 ? 1 : 0;
+                while (connection.frames.size() > keep) {
+                    connection.backlog -= connection.frames.back()->size();
+                    connection.frames.pop_back();
+                }
+                if (keep > 0) {
+                    connection.backlog = connection.frames.front()->size() - connection.frame_sent;
+                }
+                connection.frames.push_back(overflow_frame_);
+                connection.backlog += overflow_frame_->size();
+                connection.resync_pending = true;
+                return;
+            }
+            connection.frames.push_back(frame);
+            connection.backlog += frame->size();
+        }
+
+        // false when the connection should be closed
+        bool write_frames(Connection& connection) {
+            while (!connection.frames.empty()) {
+                iovec iov[MAX_IOVECS];
+                int count = 0;
+                size_t offset = connection.frame_sent;
+                for (auto it = connection.frames.begin(); it != connection.frames.end() && count < MAX_IOVECS; ++it) {
+                    iov[count].iov_base = const_cast<char*>((*it)->data() + offset);
+                    iov[count].iov_len = (*it)->size() - offset;
+                    offset = 0;
+                    count++;
+                }
+                msghdr message{};
+                message.msg_iov = iov;
+                message.msg_iovlen = static_cast<size_t>(count);
+                ssize_t n = ::sendmsg(connection.fd, &message, MSG_NOSIGNAL);
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        if (!connection.writing) {
+                            connection.writing = true;
+                            rearm(connection);
+                        }
+                        return true;
+                    }
+                    return false;
+                }
+                auto written = static_cast<size_t>(n);
+                connection.last_active_ms = now_ms();  // SSE clients never send; progress is their sign of life
+                connection.backlog -= written;
+                while (written > 0) {
+                    size_t left = connection.frames.front()->size() - connection.frame_sent;
+                    if (written < left) {
+                        connection.frame_sent += written;
+                        break;
+                    }
+                    written -= left;
+                    if (connection.frames.front() == overflow_frame_) {
+                        connection.resync_pending = false;
+                    }
+                    connection.frames.pop_front();
+                    connection.frame_sent = 0;
+                }
+            }
+            if (connection.writing) {
+                connection.writing = false;
+                rearm(connection);
+            }
+            return true;
+        }
+
+        // false when the connection should be closed
+        bool receive(Connection& connection) {
+            char buffer[4096];
+            while (true) {
+                ssize_t n = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+                if (n > 0) {
+                    connection.in.append(buffer, static_cast<size_t>(n));
+                    if (connection.in.size() > MAX_REQUEST_BYTES) {
+                        bad_requests_.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+                    }
+                    continue;
+                }
+                if (n == 0) {
+                    if (connection.subscribed) {
+                        return false;
+                    }
+                    connection.keep_alive = false;  // answer what we have, then close
+                    connection.read_closed = true;
+                    rearm(connection);
+                    break;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    break;
+                }
+                if (errno != EINTR) {
+                    return false;
+                }
+            }
+            if (connection.subscribed) {
+                connection.in.clear();  // an event stream takes no more requests
+                return true;
+            }
+            return serve(connection);
+        }
+
+        // answers buffered requests until one is still being written
+        bool serve(Connection& connection) {
+            while (!connection.writing && !connection.subscribed) {
+                size_t end = connection.in.find("\r\n\r\n");
+                if (end == std::string::npos) {
+                    return connection.keep_alive;
+                }
+                if (!respond(connection, std::string_view(connection.in).substr(0, end + 2))) {
+                    return false;
+                }
+                connection.in.erase(0, end + 4);
+                if (!flush(connection)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool respond(Connection& connection, std::string_view head) {
+            TK_TRACE_SPAN("http.request");
+            requests_.fetch_add(1, std::memory_order_relaxed);
+            HttpRequest request;
+            bool http10 = false;
+            bool valid = parse(head, request, http10, connection.keep_alive);
+            connection.keep_alive = connection.keep_alive && !connection.read_closed;
+
+            connection.body.clear();
+            connection.out.clear();
+            connection.sent = 0;
+            HttpResponse response{200, "application/json", false, 0, connection.body, {}, false, {}};
+            if (!valid) {
+                bad_requests_.fetch_add(1, std::memory_order_relaxed);
+                connection.keep_alive = false;
+                response.status = 400;
+            } else if (request.method != "GET" && request.method != "HEAD") {
+                connection.keep_alive = false;  // we never read request bodies
+                response.status = 405;
+            } else {
+                handler_(request, response);
+            }
+            if (response.subscribe && subscribers_.size() >= limits_.max_subscribers) {
+                refused_streams_.fetch_add(1, std::memory_order_relaxed);
+                response.subscribe = false;
+                response.frames.clear();
+                response.status = 503;
+                response.content_type = "application/json";
+                connection.body.assign(R"({"error":"too many event streams"})");
+                connection.keep_alive = false;
+            }
+            if (response.status == 304) {
+                not_modified_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            bool streaming = static_cast<bool>(response.stream);
+            connection.chunked = streaming && !http10;
+            if ((streaming && http10) || response.subscribe) {
+                connection.keep_alive = false;  // the body ends when the connection does
+            }
+            write_head(connection, response, http10, streaming);
+            if (streaming && !request.head) {
+                streamed_.fetch_add(1, std::memory_order_relaxed);
+                connection.stream = std::move(response.stream);
+            } else if (!request.head && response.status != 304) {
+                connection.out += connection.body;
+            }
+            if (response.subscribe && !request.head) {
+                connection.subscribed = true;
+                subscribers_.insert(&connection);
+                subscriber_count_.fetch_add(1, std::memory_order_relaxed);
+                for (auto& frame : response.frames) {
+                    enqueue(connection, frame);
+                }
+            }
+            return true;
+        }
+
+        static bool parse(std::string_view head, HttpRequest& request, bool& http10, bool& keep_alive) {
+            size_t line_end = head.find("\r\n");
+            std::string_view line = head.substr(0, line_end);
+            size_t first = line.find(' ');
+            size_t second = first == std::string_view::npos ? first : line.find(' ', first + 1);
+            if (second == std::string_view::npos) {
+                return false;
+            }
+            request.method = line.substr(0, first);
+            std::string_view target = line.substr(first + 1, second - first - 1);
+            std::string_view version = line.substr(second + 1);
+            if (version != "HTTP/1.1" && version != "HTTP/1.0") {
+                return false;
+            }
+            http10 = version == "HTTP/1.0";
+            keep_alive = !http10;
+            request.head = request.method == "HEAD";
+            size_t mark = target.find('?');
+            request.path = target.substr(0, mark);
+            request.query = mark == std::string_view::npos ? std::string_view() : target.substr(mark + 1);
+
+            std::string_view rest = line_end == std::string_view::npos ? std::string_view() : head.substr(line_end + 2);
+            while (!rest.empty()) {
+                size_t end = rest.find("\r\n");
+                std::string_view header = rest.substr(0, end);
+                rest = end == std::string_view::npos ? std::string_view() : rest.substr(end + 2);
+                size_t colon = header.find(':');
+                if (colon == std::string_view::npos) {
+                    continue;
+                }
+                std::string_view name = header.substr(0, colon);
+                std::string_view value = trim(header.substr(colon + 1));
+                if (iequals(name, "if-none-match")) {
+                    request.has_etag = parse_etag(value, request.etag_revision);
+                } else if (iequals(name, "last-event-id")) {
+                    auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), request.last_event_id);
+                    request.has_last_event_id = ec == std::errc() && end == value.data() + value.size();
+                } else if (iequals(name, "connection")) {
+                    if (iequals(value, "close")) {
+                        keep_alive = false;
+                    } else if (iequals(value, "keep-alive")) {
+                        keep_alive = true;
+                    }
+                }
+            }
+            return true;
+        }
+
+        // W/"42" or "42"; a list or * never matches, the client just gets a 200
+        static bool parse_etag(std::string_view value, uint64_t& revision) {
+            if (value.substr(0, 2) == "W/") {
+                value.remove_prefix(2);
+            }
+            if (value.size() < 3 || value.front() != '"' || value.back() != '"') {
+                return false;
+            }
+            auto digits = value.substr(1, value.size() - 2);
+            auto [end, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), revision);
+            return ec == std::errc() && end == digits.data() + digits.size();
+        }
+
+        static std::string_view trim(std::string_view text) {
+            while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+                text.remove_prefix(1);
+            }
+            while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+                text.remove_suffix(1);
+            }
+            return text;
+        }
+
+        static bool iequals(std::string_view a, std::string_view b) {
+            if (a.size() != b.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < a.size(); i++) {
+                if (std::tolower(static_cast<unsigned char>(a[i])) != b[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        static const char* reason(int status) {
+            switch (status) {
+                case 200: return "OK";
+                case 304: return "Not Modified";
+                case 400: return "Bad Request";
+                case 404: return "Not Found";
+                case 405: return "Method Not Allowed";
+                case 503: return "Service Unavailable";
+                default:  return "Internal Server Error";
+            }
+        }
+
+        static void append_number(std::string& out, uint64_t number) {
+            char digits[24];
+            auto end = std::to_chars(digits, digits + sizeof(digits), number).ptr;
+            out.append(digits, end);
+        }
+
+        void write_head(Connection& connection, const HttpResponse& response, bool http10, bool streaming) {
+            std::string& out = connection.out;
+            out += http10 ? "HTTP/1.0 " : "HTTP/1.1 ";
+            append_number(out, static_cast<uint64_t>(response.status));
+            out += ' ';
+            out += reason(response.status);
+            out += "\r\n";
+            if (response.status != 304) {
+                out += "Content-Type: ";
+                out += response.content_type;
+                out += "\r\n";
+            }
+            if (response.has_etag) {
+                out += "ETag: W/\"";
+                append_number(out, response.etag_revision);
+                out += "\"\r\n";
+            }
+            if (response.status == 405) {
+                out += "Allow: GET, HEAD\r\n";
+            }
+            if (response.subscribe) {
+                out += "Cache-Control: no-cache\r\n";
+            }
+            if (connection.chunked) {
+                out += "Transfer-Encoding: chunked\r\n";
+            } else if (!streaming && !response.subscribe && response.status != 304) {
+                out += "Content-Length: ";
+                append_number(out, connection.body.size());
+                out += "\r\n";
+            }
+            out += connection.keep_alive ? (http10 ? "Connection: keep-alive\r\n" : "") : "Connection: close\r\n";
+            out += "\r\n";
+        }
+
+        // Writes what is pending, pulling the next chunk from the stream
+        // whenever the buffer empties. Returns false to close.
+        bool flush(Connection& connection) {
+            while (true) {
+                while (connection.sent < connection.out.size()) {
+                    ssize_t n = ::send(connection.fd, connection.out.data() + connection.sent,
+                                       connection.out.size() - connection.sent, MSG_NOSIGNAL);
+                    if (n > 0) {
+                        connection.sent += static_cast<size_t>(n);
+                        connection.last_active_ms = now_ms();
+                        continue;
+                    }
+                    if (n < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                        if (!connection.writing) {
+                            connection.writing = true;
+                            rearm(connection);
+                        }
+                        return true;
+                    }
+                    return false;
+                }
+                connection.out.clear();
+                connection.sent = 0;
+                if (!connection.stream) {
+                    break;
+                }
+                next_chunk(connection);
+            }
+            if (connection.subscribed) {
+                return write_frames(connection);
+            }
+
+            if (connection.writing) {
+                connection.writing = false;
+                rearm(connection);
+            }
+            if (!connection.keep_alive) {
+                return false;
+            }
+            return serve(connection);  // a pipelined request may be waiting
+        }
+
+        // the size line is a fixed-width placeholder patched after the piece
+        // is encoded in place (leading zeros are legal in a chunk size)
+        void next_chunk(Connection& connection) {
+            std::string& out = connection.out;
+            if (connection.chunked) {
+                out += "00000000\r\n";
+            }
+            bool more = connection.stream(out);
+            if (connection.chunked) {
+                size_t size = out.size() - 10;
+                static constexpr char HEX[] = "0123456789abcdef";
+                for (int i = 7; i >= 0; i--, size >>= 4) {
+                    out[static_cast<size_t>(i)] = HEX[size & 15];
+                }
+                if (out.size() == 10) {
+                    out.clear();  // an empty piece would read as the last chunk
+                } else {
+                    out += "\r\n";
+                }
+            }
+            if (!more) {
+                connection.stream = nullptr;
+                if (connection.chunked) {
+                    out += "0\r\n\r\n";
+                }
+            }
+        }
+
+        Handler handler_;
+        const HttpServerLimits limits_;
+        std::unordered_map<int, std::unique_ptr<Connection>> connections_;
+        bool accept_paused_{false};    // listener out of the epoll set
+        int64_t accept_resume_ms_{0};  // when to try again after running out of fds
+        int listen_fd_{-1};
+        int epoll_fd_{-1};
+        int wake_fd_{-1};
+        int publish_fd_{-1};
+        std::thread thread_;
+        std::unordered_set<Connection*> subscribers_;
+        std::shared_ptr<const std::string> overflow_frame_;
+        std::mutex inbox_mutex_;
+        std::vector<std::shared_ptr<const std::string>> inbox_;
+        std::vector<std::shared_ptr<const std::string>> batch_;  // server thread only
+        std::atomic<uint64_t> requests_{0};
+        std::atomic<uint64_t> not_modified_{0};
+        std::atomic<uint64_t> streamed_{0};
+        std::atomic<uint64_t> bad_requests_{0};
+        std::atomic<uint64_t> accepted_{0};
+        std::atomic<uint64_t> open_{0};
+        std::atomic<uint64_t> subscriber_count_{0};
+        std::atomic<uint64_t> published_{0};
+        std::atomic<uint64_t> overflows_{0};
+        std::atomic<uint64_t> idle_closed_{0};
+        std::atomic<uint64_t> accept_pauses_{0};
+        std::atomic<uint64_t> refused_streams_{0};
+    };
+} // namespace tinykube
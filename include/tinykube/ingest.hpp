@@ -0,0 +1,226 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tinykube/affinity.hpp"
+#include "tinykube/lock_profile.hpp"
+#include "tinykube/tenant_registry.hpp"
+#include "tinykube/trace.hpp"
+
+namespace tinykube {
+    inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    // Bounded multi-producer queue (Vyukov's sequence-numbered ring): one CAS
+    // per push, no locks. The slots are allocated once, up front; a T that owns
+    // heap memory (IngestRecord's node name, past the small-string size) still
+    // allocates when the caller builds it.
+    template <typename T>
+    class BoundedQueue {
+    public:
+        explicit BoundedQueue(size_t capacity_pow2)
+            : mask_(capacity_pow2 - 1), slots_(std::make_unique<Slot[]>(capacity_pow2)) {
+            for (size_t i = 0; i < capacity_pow2; i++) {
+                slots_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        bool try_push(T&& value) {
+            size_t position = tail_.load(std::memory_order_relaxed);
+            for (;;) {
+                Slot& slot = slots_[position & mask_];
+                size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+                if (diff == 0) {
+                    if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        slot.value = std::move(value);
+                        slot.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;  // full
+                } else {
+                    position = tail_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // single consumer
+        bool try_pop(T& value) {
+            Slot& slot = slots_[head_ & mask_];
+            if (slot.sequence.load(std::memory_order_acquire) != head_ + 1) {
+                return false;
+            }
+            value = std::move(slot.value);
+            slot.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+            head_++;
+            return true;
+        }
+    private:
+        struct Slot {
+            std::atomic<size_t> sequence{0};
+            T value;
+        };
+
+        const size_t mask_;
+        std::unique_ptr<Slot[]> slots_;
+        alignas(64) std::atomic<size_t> tail_{0};
+        alignas(64) size_t head_{0};
+    };
+
+    struct IngestRecord {
+        TenantPartition* partition{nullptr};
+        std::string node;
+        int64_t at_ms{0};
+        uint64_t enqueued_ns{0};
+    };
+
+    struct IngestStats {
+        uint64_t ingested{0};
+        uint64_t unknown{0};   // heartbeats for nodes that aren't registered
+        uint64_t overflow{0};  // queue full, applied inline by the producer instead
+        lockprof::HistogramSummary latency;  // enqueue -> applied to the registry, ns
+    };
+
+    // Dedicated heartbeat ingestion core. RPC threads push heartbeats into a
+    // lock-free ring; one thread pinned to `cpu` busy-polls it and applies
+    // whole batches with one registry lock per tenant. The thread never
+    // sleeps, so the core should be isolated (isolcpus/nohz_full) and kept
+    // out of the other affinity masks.
+    class HeartbeatIngest {
+    public:
+        static constexpr size_t QUEUE_CAPACITY = 1 << 16;
+        static constexpr size_t MAX_BATCH = 512;
+
+        explicit HeartbeatIngest(int cpu) : cpu_(cpu), queue_(QUEUE_CAPACITY) {}
+
+        ~HeartbeatIngest() {
+            stop();
+        }
+
+        HeartbeatIngest(const HeartbeatIngest&) = delete;
+        HeartbeatIngest& operator=(const HeartbeatIngest&) = delete;
+
+        // false (with `error`) if the thread could not be pinned to its core;
+        // it has exited by then and submit() applies heartbeats inline
+        bool start(std::string& error) {
+            std::promise<bool> pinned;
+            auto result = pinned.get_future();
+            thread_ = std::thread([this, pinned = std::move(pinned)]() mutable {
+                bool ok = pin_current_thread({cpu_});
+                pinned.set_value(ok);
+                if (ok) {
+                    run();
+                }
+            });
+            if (!result.get()) {
+                stop();
+                error = "could not pin heartbeat ingestion to CPU " + std::to_string(cpu_);
+                return false;
+            }
+            return true;
+        }
+
+        // drains what was queued, then joins
+        void stop() {
+            if (stopping_.exchange(true)) {
+                return;
+            }
+            if (thread_.joinable()) {
+                thread_.join();
+            }
+        }
+
+        void submit(TenantPartition& partition, const std::string& node, int64_t at_ms) {
+            // Producers announce themselves before looking at stopping_ (both
+            // seq_cst), and the consumer only exits once it has seen stopping_
+            // with no producer in flight, so a push can't land after its last pop.
+            producers_.fetch_add(1);
+            if (!stopping_.load() && queue_.try_push(IngestRecord{&partition, node, at_ms, trace::now_ns()})) {
+                producers_.fetch_sub(1);
+                return;
+            }
+            producers_.fetch_sub(1);
+            // never drop a heartbeat: a full or stopped ring degrades to the inline path
+            overflow_.fetch_add(1, std::memory_order_relaxed);
+            if (!partition.nodes.touch(node, at_ms)) {
+                unknown_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        IngestStats stats() const {
+            IngestStats stats;
+            stats.ingested = ingested_.load(std::memory_order_relaxed);
+            stats.unknown = unknown_.load(std::memory_order_relaxed);
+            stats.overflow = overflow_.load(std::memory_order_relaxed);
+            stats.latency.add(latency_);
+            return stats;
+        }
+
+        int cpu() const {
+            return cpu_;
+        }
+    private:
+        void run() {
+            std::vector<IngestRecord> batch;
+            batch.reserve(MAX_BATCH);
+            std::unordered_map<TenantPartition*, std::vector<std::pair<std::string, int64_t>>> by_partition;
+
+            while (true) {
+                bool stopping = stopping_.load() && producers_.load() == 0;
+                IngestRecord record;
+                while (batch.size() < MAX_BATCH && queue_.try_pop(record)) {
+                    batch.push_back(std::move(record));
+                }
+                if (batch.empty()) {
+                    if (stopping) {
+                        break;  // checked before the pop, so nothing pushed before it is lost
+                    }
+                    cpu_relax();
+                    continue;
+                }
+
+                TK_TRACE_SPAN("ingest.batch");
+                for (auto& queued : batch) {
+                    by_partition[queued.partition].emplace_back(std::move(queued.node), queued.at_ms);
+                }
+                size_t found = 0;
+                for (auto& [partition, heartbeats] : by_partition) {
+                    if (!heartbeats.empty()) {
+                        found += partition->nodes.touch_batch(heartbeats);
+                        heartbeats.clear();
+                    }
+                }
+                uint64_t applied_ns = trace::now_ns();
+                for (const auto& queued : batch) {
+                    latency_.record(applied_ns - queued.enqueued_ns);
+                }
+                ingested_.fetch_add(batch.size(), std::memory_order_relaxed);
+                unknown_.fetch_add(batch.size() - found, std::memory_order_relaxed);
+                batch.clear();
+            }
+        }
+
+        const int cpu_;
+        BoundedQueue<IngestRecord> queue_;
+        std::atomic<bool> stopping_{false};
+        std::atomic<size_t> producers_{0};  // submit() calls between announcing and pushing
+        std::atomic<uint64_t> ingested_{0};
+        std::atomic<uint64_t> unknown_{0};
+        std::atomic<uint64_t> overflow_{0};
+        lockprof::LogHistogram latency_;
+        std::thread thread_;
+    };
+} // namespace tinykube
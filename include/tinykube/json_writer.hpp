@@ -0,0 +1,160 @@
+#pragma once
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace tinykube {
+    // Streaming JSON encoder appending to a caller-owned buffer. Commas are
+    // tracked in a bit per nesting level (up to 64), numbers go through
+    // to_chars, so once the buffer has grown, encoding allocates nothing.
+    class JsonWriter {
+    public:
+        explicit JsonWriter(std::string& out) : out_(out) {}
+
+        JsonWriter& begin_object() {
+            value_prefix();
+            out_ += '{';
+            push();
+            return *this;
+        }
+
+        JsonWriter& end_object() {
+            depth_--;
+            out_ += '}';
+            return *this;
+        }
+
+        JsonWriter& begin_array() {
+            value_prefix();
+            out_ += '[';
+            push();
+            return *this;
+        }
+
+        JsonWriter& end_array() {
+            depth_--;
+            out_ += ']';
+            return *this;
+        }
+
+        JsonWriter& key(std::string_view name) {
+            separator();
+            quoted(name);
+            out_ += ':';
+            after_key_ = true;
+            return *this;
+        }
+
+        JsonWriter& value(std::string_view text) {
+            value_prefix();
+            quoted(text);
+            return *this;
+        }
+
+        JsonWriter& value(const char* text) {
+            return value(std::string_view(text));
+        }
+
+        JsonWriter& value(bool flag) {
+            value_prefix();
+            out_ += flag ? "true" : "false";
+            return *this;
+        }
+
+        template <typename Integer>
+            requires std::is_integral_v<Integer> && (!std::is_same_v<Integer, bool>)
+        JsonWriter& value(Integer number) {
+            value_prefix();
+            char digits[24];
+            auto end = std::to_chars(digits, digits + sizeof(digits), number).ptr;
+            out_.append(digits, end);
+            return *this;
+        }
+
+        // JSON has no NaN or infinity; those become null
+        JsonWriter& value(double number) {
+            value_prefix();
+            if (!std::isfinite(number)) {
+                out_ += "null";
+                return *this;
+            }
+            char digits[32];
+            auto end = std::to_chars(digits, digits + sizeof(digits), number).ptr;
+            out_.append(digits, end);
+            return *this;
+        }
+
+        template <typename T>
+        JsonWriter& field(std::string_view name, T&& v) {
+            key(name);
+            return value(std::forward<T>(v));
+        }
+
+        // picks up inside an array another writer opened, so a long list can
+        // be encoded a piece at a time; empty if no element was written yet
+        void resume_array(bool empty) {
+            push();
+            if (!empty) {
+                first_ &= ~(uint64_t{1} << (depth_ - 1));
+            }
+        }
+    private:
+        void push() {
+            first_ |= uint64_t{1} << depth_;
+            depth_++;
+        }
+
+        void separator() {
+            uint64_t bit = uint64_t{1} << (depth_ - 1);
+            if (!(first_ & bit)) {
+                out_ += ',';
+            }
+            first_ &= ~bit;
+        }
+
+        void value_prefix() {
+            if (after_key_) {
+                after_key_ = false;
+            } else if (depth_ > 0) {
+                separator();
+            }
+        }
+
+        void quoted(std::string_view text) {
+            static constexpr char HEX[] = "0123456789abcdef";
+            out_ += '"';
+            size_t run = 0;  // plain characters are copied in runs
+            for (size_t i = 0; i < text.size(); i++) {
+                auto c = static_cast<unsigned char>(text[i]);
+                if (c >= 0x20 && c != '"' && c != '\\') {
+                    continue;
+                }
+                out_.append(text.data() + run, i - run);
+                run = i + 1;
+                out_ += '\\';
+                switch (c) {
+                    case '"':  out_ += '"'; break;
+                    case '\\': out_ += '\\'; break;
+                    case '\n': out_ += 'n'; break;
+                    case '\r': out_ += 'r'; break;
+                    case '\t': out_ += 't'; break;
+                    default:
+                        out_ += "u00";
+                        out_ += HEX[c >> 4];
+                        out_ += HEX[c & 15];
+                }
+            }
+            out_.append(text.data() + run, text.size() - run);
+            out_ += '"';
+        }
+
+        std::string& out_;
+        uint64_t first_{0};  // bit d set: nothing written yet at depth d
+        int depth_{0};
+        bool after_key_{false};
+    };
+} // namespace tinykube
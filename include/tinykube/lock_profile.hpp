@@ -0,0 +1,336 @@
+#pragma once
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "tinykube/trace.hpp"
+
+namespace tinykube::lockprof {
+    // True when built with -DTINYKUBE_LOCK_PROFILING. Without it ProfiledLock
+    // only emits the trace spans and takes no timestamps of its own.
+#ifdef TINYKUBE_LOCK_PROFILING
+    inline constexpr bool ENABLED = true;
+#else
+    inline constexpr bool ENABLED = false;
+#endif
+
+    inline constexpr size_t MAX_SITES = 64;
+
+    // Power-of-two nanosecond buckets: bucket i holds durations in [2^(i-1), 2^i).
+    // Written by one thread, read by the dumper, hence the relaxed atomics.
+    class LogHistogram {
+    public:
+        static constexpr size_t BUCKETS = 48;
+
+        void record(uint64_t ns) {
+            size_t bucket = std::min<size_t>(std::bit_width(ns), BUCKETS - 1);
+            buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+            count_.fetch_add(1, std::memory_order_relaxed);
+            total_ns_.fetch_add(ns, std::memory_order_relaxed);
+            if (ns > max_ns_.load(std::memory_order_relaxed)) {
+                max_ns_.store(ns, std::memory_order_relaxed);
+            }
+        }
+
+        // adds a quiescent histogram's counts into this one
+        void merge(const LogHistogram& other) {
+            for (size_t i = 0; i < BUCKETS; i++) {
+                buckets_[i].fetch_add(other.bucket(i), std::memory_order_relaxed);
+            }
+            count_.fetch_add(other.count(), std::memory_order_relaxed);
+            total_ns_.fetch_add(other.total_ns(), std::memory_order_relaxed);
+            if (other.max_ns() > max_ns_.load(std::memory_order_relaxed)) {
+                max_ns_.store(other.max_ns(), std::memory_order_relaxed);
+            }
+        }
+
+        void reset() {
+            for (auto& bucket : buckets_) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            count_.store(0, std::memory_order_relaxed);
+            total_ns_.store(0, std::memory_order_relaxed);
+            max_ns_.store(0, std::memory_order_relaxed);
+        }
+
+        uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+        uint64_t total_ns() const { return total_ns_.load(std::memory_order_relaxed); }
+        uint64_t max_ns() const { return max_ns_.load(std::memory_order_relaxed); }
+        uint64_t bucket(size_t i) const { return buckets_[i].load(std::memory_order_relaxed); }
+    private:
+        std::atomic<uint64_t> buckets_[BUCKETS]{};
+        std::atomic<uint64_t> count_{0};
+        std::atomic<uint64_t> total_ns_{0};
+        std::atomic<uint64_t> max_ns_{0};
+    };
+
+    // plain copy of one or more LogHistograms, used when aggregating a dump
+    struct HistogramSummary {
+        uint64_t buckets[LogHistogram::BUCKETS]{};
+        uint64_t count{0};
+        uint64_t total_ns{0};
+        uint64_t max_ns{0};
+
+        void add(const LogHistogram& histogram) {
+            for (size_t i = 0; i < LogHistogram::BUCKETS; i++) {
+                buckets[i] += histogram.bucket(i);
+            }
+            count += histogram.count();
+            total_ns += histogram.total_ns();
+            max_ns = std::max(max_ns, histogram.max_ns());
+        }
+
+        // upper bound of the bucket holding the q-th quantile
+        uint64_t quantile_ns(double q) const {
+            if (count == 0) {
+                return 0;
+            }
+            uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count - 1)) + 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < LogHistogram::BUCKETS; i++) {
+                seen += buckets[i];
+                if (seen >= rank) {
+                    return std::min(max_ns, i == 0 ? 0 : (uint64_t{1} << i) - 1);
+                }
+            }
+            return max_ns;
+        }
+    };
+
+    struct SiteStats {
+        LogHistogram wait;
+        LogHistogram hold;
+    };
+
+    inline constexpr long EXITED_TID = -1;  // the row that exited threads are folded into
+
+    struct ThreadStats {
+        explicit ThreadStats(long os_tid) : tid(os_tid) {}
+
+        long tid;  // set under the profiler's mutex
+        SiteStats sites[MAX_SITES];
+    };
+
+    struct SiteReport {
+        std::string site;
+        long tid{0};  // 0 for the all-threads rollup, EXITED_TID for threads gone
+        HistogramSummary wait;
+        HistogramSummary hold;
+    };
+
+    // Owns site names and every thread's stats. An exiting thread's counts are
+    // folded into one "exited" row, so short-lived RPC threads still show up
+    // in the dump, and its ThreadStats is reset and reused by the next new
+    // thread: memory stays at the most threads ever alive at once.
+    class Profiler {
+    public:
+        static Profiler& instance() {
+            static Profiler profiler;
+            return profiler;
+        }
+
+        size_t register_site(const std::string& name) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = std::find(sites_.begin(), sites_.end(), name);
+            if (it != sites_.end()) {
+                return static_cast<size_t>(it - sites_.begin());
+            }
+            if (sites_.size() == MAX_SITES) {
+                return MAX_SITES - 1;  // overflow sites share the last slot
+            }
+            sites_.push_back(name);
+            return sites_.size() - 1;
+        }
+
+        ThreadStats* acquire_thread() {
+            long tid = static_cast<long>(::syscall(SYS_gettid));
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_.empty()) {
+                ThreadStats* stats = free_.back();
+                free_.pop_back();
+                stats->tid = tid;
+                active_.push_back(stats);
+                return stats;
+            }
+            threads_.push_back(std::make_unique<ThreadStats>(tid));
+            active_.push_back(threads_.back().get());
+            return threads_.back().get();
+        }
+
+        void release_thread(ThreadStats* stats) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t site = 0; site < MAX_SITES; site++) {
+                exited_.sites[site].wait.merge(stats->sites[site].wait);
+                exited_.sites[site].hold.merge(stats->sites[site].hold);
+                stats->sites[site].wait.reset();
+                stats->sites[site].hold.reset();
+            }
+            active_.erase(std::find(active_.begin(), active_.end(), stats));
+            free_.push_back(stats);
+        }
+
+        // one rollup per site, followed by per-thread rows when `per_thread` is set
+        std::vector<SiteReport> report(bool per_thread) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::vector<SiteReport> reports;
+            for (size_t site = 0; site < sites_.size(); site++) {
+                SiteReport total{sites_[site], 0, {}, {}};
+                std::vector<SiteReport> rows;
+                for (const ThreadStats* thread : rows_of_threads()) {
+                    const SiteStats& stats = thread->sites[site];
+                    if (stats.wait.count() == 0) {
+                        continue;
+                    }
+                    total.wait.add(stats.wait);
+                    total.hold.add(stats.hold);
+                    if (per_thread) {
+                        SiteReport row{sites_[site], thread->tid, {}, {}};
+                        row.wait.add(stats.wait);
+                        row.hold.add(stats.hold);
+                        rows.push_back(std::move(row));
+                    }
+                }
+                if (total.wait.count == 0) {
+                    continue;
+                }
+                reports.push_back(std::move(total));
+                std::sort(rows.begin(), rows.end(), [](const SiteReport& a, const SiteReport& b) {
+                    return a.wait.total_ns > b.wait.total_ns;
+                });
+                reports.insert(reports.end(), std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+            }
+            return reports;
+        }
+
+        // Counters are reset in place; a lock released concurrently may land
+        // on either side of the reset.
+        void reset() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (ThreadStats* thread : rows_of_threads()) {
+                for (auto& stats : thread->sites) {
+                    stats.wait.reset();
+                    stats.hold.reset();
+                }
+            }
+        }
+    private:
+        // the live threads plus the exited rollup; mutex_ held
+        std::vector<ThreadStats*> rows_of_threads() {
+            std::vector<ThreadStats*> rows = active_;
+            rows.push_back(&exited_);
+            return rows;
+        }
+
+        std::vector<std::string> sites_;
+        std::vector<std::unique_ptr<ThreadStats>> threads_;
+        std::vector<ThreadStats*> active_;  // held by a live thread
+        std::vector<ThreadStats*> free_;    // reset, waiting for the next new thread
+        ThreadStats exited_{EXITED_TID};
+        std::mutex mutex_;
+    };
+
+    // a thread's stats, folded into the exited row when the thread exits
+    class LocalStats {
+    public:
+        LocalStats() : stats_(Profiler::instance().acquire_thread()) {}
+
+        ~LocalStats() {
+            Profiler::instance().release_thread(stats_);
+        }
+
+        ThreadStats& get() {
+            return *stats_;
+        }
+    private:
+        ThreadStats* stats_;
+    };
+
+    inline ThreadStats& local_stats() {
+        thread_local LocalStats stats;
+        return stats.get();
+    }
+
+    // A named acquisition point, declared as a function-local static next to
+    // the lock it describes. Also supplies the trace span names.
+    class LockSite {
+    public:
+        explicit LockSite(const std::string& name)
+            : wait_name_(name + ".wait"), hold_name_(name + ".hold"),
+              id_(ENABLED ? Profiler::instance().register_site(name) : 0) {}
+
+        const char* wait_name() const { return wait_name_.c_str(); }
+        const char* hold_name() const { return hold_name_.c_str(); }
+        size_t id() const { return id_; }
+    private:
+        const std::string wait_name_;
+        const std::string hold_name_;
+        const size_t id_;
+    };
+
+    // Scoped lock recording wait and hold time for its site on the calling
+    // thread, plus the matching trace spans.
+    template <typename Mutex>
+    class ProfiledLock {
+    public:
+        ProfiledLock(Mutex& mutex, const LockSite& site)
+            : mutex_(mutex), site_(site), acquired_ns_(acquire(mutex, site)), hold_(site.hold_name()) {}
+
+        ~ProfiledLock() {
+            hold_.end();
+            if constexpr (ENABLED) {
+                local_stats().sites[site_.id()].hold.record(trace::now_ns() - acquired_ns_);
+            }
+            mutex_.unlock();
+        }
+
+        ProfiledLock(const ProfiledLock&) = delete;
+        ProfiledLock& operator=(const ProfiledLock&) = delete;
+    private:
+        // locks the mutex, returning when it was acquired (0 when not profiling)
+        static uint64_t acquire(Mutex& mutex, const LockSite& site) {
+            trace::Span wait(site.wait_name());
+            if constexpr (ENABLED) {
+                uint64_t start = trace::now_ns();
+                mutex.lock();
+                uint64_t acquired = trace::now_ns();
+                local_stats().sites[site.id()].wait.record(acquired - start);
+                return acquired;
+            } else {
+                mutex.lock();
+                return 0;
+            }
+        }
+
+        Mutex& mutex_;
+        const LockSite& site_;
+        const uint64_t acquired_ns_;
+        trace::Span hold_;
+    };
+
+    inline void write_text(std::ostream& out, const std::vector<SiteReport>& reports) {
+        out << std::left << std::setw(34) << "SITE" << std::right << std::setw(8) << "TID"
+            << std::setw(12) << "LOCKS" << std::setw(12) << "WAIT p50" << std::setw(12) << "WAIT p99"
+            << std::setw(12) << "WAIT max" << std::setw(14) << "WAIT total" << std::setw(12) << "HOLD p50"
+            << std::setw(12) << "HOLD p99" << std::setw(12) << "HOLD max" << "\n";
+        for (const auto& row : reports) {
+            out << std::left << std::setw(34) << (row.tid == 0 ? row.site : "  " + row.site) << std::right
+                << std::setw(8)
+                << (row.tid == 0 ? std::string("all") : row.tid == EXITED_TID ? "exited" : std::to_string(row.tid))
+                << std::setw(12) << row.wait.count
+                << std::setw(12) << row.wait.quantile_ns(0.50) << std::setw(12) << row.wait.quantile_ns(0.99)
+                << std::setw(12) << row.wait.max_ns << std::setw(14) << row.wait.total_ns
+                << std::setw(12) << row.hold.quantile_ns(0.50) << std::setw(12) << row.hold.quantile_ns(0.99)
+                << std::setw(12) << row.hold.max_ns << "\n";
+        }
+    }
+} // namespace tinykube::lockprof
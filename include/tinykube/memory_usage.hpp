@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+namespace tinykube {
+    // Estimated heap footprint of a registry, from container sizes and the
+    // libstdc++ node layouts. Allocator overhead (about 16 bytes per
+    // allocation with glibc malloc) is not included.
+    struct MemoryUsage {
+        size_t nodes{0};
+        size_t node_bytes{0};          // NodeState entries, hash nodes and bucket arrays
+        size_t string_bytes{0};        // heap buffers of names, tenants and peers
+        size_t label_bytes{0};         // label tree nodes and their strings
+        size_t availability_bytes{0};  // per-node SLO windows
+
+        size_t total() const {
+            return node_bytes + string_bytes + label_bytes + availability_bytes;
+        }
+
+        MemoryUsage& operator+=(const MemoryUsage& other) {
+            nodes += other.nodes;
+            node_bytes += other.node_bytes;
+            string_bytes += other.string_bytes;
+            label_bytes += other.label_bytes;
+            availability_bytes += other.availability_bytes;
+            return *this;
+        }
+    };
+
+    // 0 for strings held in the small-string buffer inside the object itself
+    inline size_t heap_bytes(const std::string& text) {
+        const char* object = reinterpret_cast<const char*>(&text);
+        bool inline_buffer = text.data() >= object && text.data() < object + sizeof(std::string);
+        return inline_buffer ? 0 : text.capacity() + 1;
+    }
+
+    // a hash node holds the next pointer, the value and the cached hash
+    template <typename Key, typename Value>
+    size_t container_bytes(const std::unordered_map<Key, Value>& map) {
+        return map.size() * (sizeof(void*) + sizeof(std::pair<const Key, Value>) + sizeof(size_t)) +
+               map.bucket_count() * sizeof(void*);
+    }
+
+    // a red-black tree node is a color plus three pointers ahead of the value
+    template <typename Key, typename Value>
+    size_t container_bytes(const std::map<Key, Value>& map) {
+        return map.size() * (4 * sizeof(void*) + sizeof(std::pair<const Key, Value>));
+    }
+} // namespace tinykube
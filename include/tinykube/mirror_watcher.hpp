@@ -0,0 +1,121 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <grpcpp/grpcpp.h>
+
+#include "control_plane.grpc.pb.h"
+
+#include "tinykube/federation.hpp"
+
+namespace tinykube {
+    inline constexpr auto MIRROR_WATCH_MIN_BACKOFF = std::chrono::milliseconds(250);
+
+    // Keeps exactly one WatchNodes stream open to one control plane, feeding
+    // a ClusterMirror and reconnecting with doubling backoff. Every
+    // (re)connect starts from a snapshot: a restarted control plane numbers
+    // its revisions from 1 again, so resuming from our last revision could
+    // wait forever. Shared by the federator's members and tinykubectl top;
+    // `log` prints connects and losses, which top can't have on its screen.
+    class MirrorWatcher {
+    public:
+        MirrorWatcher(const std::string& name, const std::string& address, std::shared_ptr<grpc::Channel> channel,
+                      std::chrono::milliseconds max_backoff, bool log)
+            : mirror_(name, address),
+              stub_(ControlPlane::NewStub(std::move(channel))),
+              max_backoff_(max_backoff),
+              log_(log) {}
+
+        ~MirrorWatcher() {
+            stop();
+        }
+
+        void start() {
+            thread_ = std::thread([this] { run(); });
+        }
+
+        void stop() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                running_ = false;
+                if (context_ != nullptr) {
+                    context_->TryCancel();
+                }
+            }
+            cv_.notify_all();
+            if (thread_.joinable()) {
+                thread_.join();
+            }
+        }
+
+        const ClusterMirror& mirror() const {
+            return mirror_;
+        }
+
+        // why the last stream ended, empty until one has
+        std::string error() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return error_;
+        }
+    private:
+        void run() {
+            auto backoff = MIRROR_WATCH_MIN_BACKOFF;
+            while (true) {
+                grpc::ClientContext context;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (!running_) {
+                        return;
+                    }
+                    context_ = &context;
+                }
+                WatchRequest request;
+                auto reader = stub_->WatchNodes(&context, request);
+                NodeEvent event;
+                bool received = false;
+                while (reader->Read(&event)) {
+                    if (!received) {
+                        if (log_) {
+                            std::cout << "🔗 Watching " << mirror_.name() << " from revision " << event.revision()
+                                      << std::endl;
+                        }
+                        received = true;
+                        backoff = MIRROR_WATCH_MIN_BACKOFF;
+                    }
+                    mirror_.apply(event);
+                }
+                grpc::Status status = reader->Finish();
+                mirror_.set_connected(false);
+
+                std::unique_lock<std::mutex> lock(mutex_);
+                context_ = nullptr;
+                error_ = status.error_message();
+                if (!running_) {
+                    return;
+                }
+                if (log_) {
+                    std::cout << "💔 Lost " << mirror_.name() << ": " << error_ << ", retrying in "
+                              << backoff.count() << "ms" << std::endl;
+                }
+                cv_.wait_for(lock, backoff, [this] { return !running_; });
+                backoff = std::min(backoff * 2, max_backoff_);
+            }
+        }
+
+        ClusterMirror mirror_;
+        std::unique_ptr<ControlPlane::Stub> stub_;
+        std::chrono::milliseconds max_backoff_;
+        bool log_;
+        mutable std::mutex mutex_;
+        std::condition_variable cv_;
+        bool running_{true};
+        grpc::ClientContext* context_{nullptr};
+        std::string error_;
+        std::thread thread_;
+    };
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "tinykube/arrow_ipc.hpp"
+#include "tinykube/node_registry.hpp"
+#include "tinykube/slo.hpp"
+#include "tinykube/types.hpp"
+
+namespace tinykube {
+    // A registry snapshot in Arrow layout, one row per node. Labels are one
+    // "k=v,k=v" string. The 1h/1d/30d availability ratios are optional: they
+    // cost a report per node, several times the rest of the row.
+    class NodeColumns {
+    public:
+        enum : size_t {
+            TENANT, NAME, PEER, STATUS, LAST_SEEN, UNSCHEDULABLE, CPU_MILLIS, MEMORY_MB, JITTER_SCORE, LABELS,
+            AVAILABILITY_1H, AVAILABILITY_1D, AVAILABILITY_30D
+        };
+
+        explicit NodeColumns(bool availability = false) {
+            if (availability) {
+                columns.emplace_back("availability_1h", ArrowType::FLOAT64);
+                columns.emplace_back("availability_1d", ArrowType::FLOAT64);
+                columns.emplace_back("availability_30d", ArrowType::FLOAT64);
+            }
+        }
+
+        std::vector<ArrowColumn> columns{
+            {"tenant", ArrowType::UTF8},
+            {"name", ArrowType::UTF8},
+            {"peer", ArrowType::UTF8},
+            {"status", ArrowType::UTF8},
+            {"last_seen", ArrowType::TIMESTAMP_MS},
+            {"unschedulable", ArrowType::BOOL},
+            {"cpu_millis", ArrowType::INT64},
+            {"memory_mb", ArrowType::INT64},
+            {"jitter_score", ArrowType::FLOAT64},
+            {"labels", ArrowType::UTF8},
+        };
+
+        bool has_availability() const {
+            return columns.size() > AVAILABILITY_1H;
+        }
+
+        void append(const NodeState& node) {
+            columns[TENANT].append_utf8(node.tenant);
+            columns[NAME].append_utf8(node.name);
+            columns[PEER].append_utf8(node.peer);
+            columns[STATUS].append_utf8(status_name(node.status));
+            columns[LAST_SEEN].append_int64(node.last_seen_ms);
+            columns[UNSCHEDULABLE].append_bool(node.unschedulable);
+            columns[CPU_MILLIS].append_int64(node.capacity.cpu_millis);
+            columns[MEMORY_MB].append_int64(node.capacity.memory_mb);
+            columns[JITTER_SCORE].append_double(node.jitter.score());
+            labels_.clear();
+            for (const auto& [key, value] : node.labels) {
+                if (!labels_.empty()) {
+                    labels_ += ',';
+                }
+                labels_ += key;
+                labels_ += '=';
+                labels_ += value;
+            }
+            columns[LABELS].append_utf8(labels_);
+        }
+
+        void append(const NodeState& node, const SloReport& availability) {
+            append(node);
+            columns[AVAILABILITY_1H].append_double(availability.hour.ratio());
+            columns[AVAILABILITY_1D].append_double(availability.day.ratio());
+            columns[AVAILABILITY_30D].append_double(availability.month.ratio());
+        }
+
+        void reserve(size_t rows) {
+            for (auto& column : columns) {
+                column.reserve(rows);
+            }
+        }
+
+        void clear() {
+            for (auto& column : columns) {
+                column.clear();
+            }
+        }
+
+        size_t rows() const {
+            return columns.front().length();
+        }
+    private:
+        std::string labels_;
+    };
+
+    // appends every node of `registry` straight into the columns under one
+    // lock hold: no NodeState copies, no protobuf. Returns the rows added.
+    inline size_t append_columns(const NodeRegistry& registry, NodeColumns& out, int64_t now_ms) {
+        size_t before = out.rows();
+        out.reserve(before + registry.size());
+        if (out.has_availability()) {
+            registry.for_each_node(now_ms, [&](const NodeState& node, const SloReport& availability) {
+                out.append(node, availability);
+            });
+        } else {
+            registry.for_each_node([&](const NodeState& node) { out.append(node); });
+        }
+        return out.rows() - before;
+    }
+} // namespace tinykube
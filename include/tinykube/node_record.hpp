@@ -0,0 +1,53 @@
+#pragma once
+#include "control_plane.pb.h"
+
+#include "tinykube/node_registry.hpp"
+#include "tinykube/types.hpp"
+
+namespace tinykube {
+    // conversions between registry state and the wire messages
+    inline void to_record(const NodeState& node, NodeRecord* record) {
+        record->set_name(node.name);
+        record->set_tenant(node.tenant);
+        record->set_peer(node.peer);
+        record->set_last_seen_ms(node.last_seen_ms);
+        record->set_status(static_cast<uint32_t>(node.status));
+        record->mutable_labels()->insert(node.labels.begin(), node.labels.end());
+        record->set_unschedulable(node.unschedulable);
+        record->set_cpu_millis(node.capacity.cpu_millis);
+        record->set_memory_mb(node.capacity.memory_mb);
+        record->set_jitter_score(node.jitter.score());
+    }
+
+    inline NodeState from_record(const NodeRecord& record) {
+        NodeState node;
+        node.name = record.name();
+        node.tenant = record.tenant();
+        node.peer = record.peer();
+        node.last_seen_ms = record.last_seen_ms();
+        node.status = static_cast<NodeStatus>(record.status());
+        node.labels.insert(record.labels().begin(), record.labels().end());
+        node.unschedulable = record.unschedulable();
+        node.capacity.cpu_millis = record.cpu_millis();
+        node.capacity.memory_mb = record.memory_mb();
+        return node;
+    }
+
+    inline NodeSelector from_spec(const NodeSelectorSpec& spec) {
+        NodeSelector selector;
+        selector.names.assign(spec.names().begin(), spec.names().end());
+        selector.match_labels.insert(spec.match_labels().begin(), spec.match_labels().end());
+        return selector;
+    }
+
+    inline void to_event(const WatchEvent& event, NodeEvent* out) {
+        out->set_revision(event.revision);
+        out->set_tenant(event.tenant);
+        for (const auto& node : event.nodes) {
+            to_record(node, out->add_nodes());
+        }
+        for (const auto& name : event.removed) {
+            out->add_removed(name);
+        }
+    }
+} // namespace tinykube
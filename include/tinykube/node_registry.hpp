@@ -1,65 +1,372 @@
 #pragma once
+#include <algorithm>
 #include <unordered_map>
+#include <limits>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <string>
 #include <vector>
 
+#include "tinykube/lock_profile.hpp"
+#include "tinykube/memory_usage.hpp"
+#include "tinykube/slo.hpp"
 #include "tinykube/types.hpp"
+#include "tinykube/watch.hpp"
 
 namespace tinykube {
+    // picks nodes for bulk operations: an explicit name list, a label match, or both
+    struct NodeSelector {
+        std::vector<std::string> names;
+        std::map<std::string, std::string> match_labels;
+
+        bool matches_labels(const NodeState& node) const {
+            for (const auto& [key, value] : match_labels) {
+                auto it = node.labels.find(key);
+                if (it == node.labels.end() || it->second != value) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    struct BulkResult {
+        size_t matched{0};
+        size_t changed{0};
+        uint64_t revision{0};
+    };
+
     class NodeRegistry {
     public:
-        void upsert(const NodeState& node) {
+        explicit NodeRegistry(std::shared_ptr<WatchHub> hub = std::make_shared<WatchHub>(),
+                              std::string tenant = "")
+            : hub_(std::move(hub)), tenant_(std::move(tenant)) {}
+
+        // false if `node` is new and the registry already holds `max_nodes`
+        bool upsert(const NodeState& node, size_t max_nodes = std::numeric_limits<size_t>::max()) {
             // this acts as a lock/unlock with RAII
-            std::lock_guard<std::mutex> lock(mutex_);
-            nodes_[node.name] = node;
+            static const lockprof::LockSite site("registry.upsert");
+            lockprof::ProfiledLock<std::mutex> lock(mutex_, site);
+            if (nodes_.size() >= max_nodes && !nodes_.contains(node.name)) {
+                return false;
+            }
+            auto [it, inserted] = nodes_.try_emplace(node.name, node);
+            if (!inserted) {
+                // a re-registering agent must not undo what operators set on the node
+                NodeState merged = node;
+                merged.unschedulable = it->second.unschedulable;
+                for (const auto& [key, value] : it->second.labels) {
+                    merged.labels.try_emplace(key, value);
+                }
+                it->second = std::move(merged);
+            }
+            track(node.name, it->second.status, it->second.last_seen_ms);
+            hub_->publish(tenant_, {it->second});
+            return true;
         }
 
-        void touch(const std::string& node_name, int64_t now_ms) {
-            std::lock_guard<std::mutex> lock(mutex_);
-            if (nodes_.contains(node_name)) {
-                nodes_[node_name].last_seen_ms = now_ms;
-                nodes_[node_name].status = NodeStatus::READY;
+        // false if the node isn't registered
+        bool touch(const std::string& node_name, int64_t now_ms) {
+            static const lockprof::LockSite site("registry.touch");
+            lockprof::ProfiledLock<std::mutex> lock(mutex_, site);
+            std::vector<NodeState> changed;
+            bool found = touch_locked(node_name, now_ms, changed);
+            if (!changed.empty()) {
+                hub_->publish(tenant_, std::move(changed));
             }
+            return found;
+        }
+
+        // many heartbeats under one lock and at most one watch event; returns
+        // how many named a registered node
+        size_t touch_batch(const std::vector<std::pair<std::string, int64_t>>& heartbeats) {
+            static const lockprof::LockSite site("registry.touch_batch");
+            lockprof::ProfiledLock<std::mutex> lock(mutex_, site);
+            std::vector<NodeState> changed;
+            size_t found = 0;
+            for (const auto& [node_name, now_ms] : heartbeats) {
+                found += touch_locked(node_name, now_ms, changed) ? 1 : 0;
+            }
+            if (!changed.empty()) {
+                hub_->publish(tenant_, std::move(changed));
+            }
+            return found;
         }
 
         void sweep(int64_t now_ms, int64_t suspect_timeout_ms = 30000, int64_t not_ready_timeout_ms = 10000) {
-            std::lock_guard<std::mutex> lock(mutex_);
+            static const lockprof::LockSite site("registry.sweep");
+            lockprof::ProfiledLock<std::mutex> lock(mutex_, site);
+            std::vector<NodeState> changed;
             for (auto& [name, state] : nodes_) {
+                NodeStatus before = state.status;
                 if (state.is_not_ready(now_ms, not_ready_timeout_ms)) {
                     state.status = NodeStatus::NOT_READY;
                 }
                 else if (state.is_suspect(now_ms, suspect_timeout_ms)) {
                     state.status = NodeStatus::SUSPECT;
                 }
+                if (state.status != before) {
+                    track(name, state.status, now_ms);
+                    changed.push_back(state);
+                }
+            }
+            // fold every open interval into the rings so they never span more than one sweep
+            for (auto& [name, availability] : availability_) {
+                checkpoint(availability, now_ms);
+            }
+            if (!changed.empty()) {
+                hub_->publish(tenant_, std::move(changed));
             }
         }
 
         bool remove(const std::string& node_name) {
-            std::lock_guard<std::mutex> lock(mutex_);
-            return nodes_.erase(node_name) > 0;
+            static const lockprof::LockSite site("registry.remove");
+            lockprof::ProfiledLock<std::mutex> lock(mutex_, site);
+            if (nodes_.erase(node_name) == 0) {
+                return false;
+            }
+            auto tracked = availability_.find(node_name);
+            if (tracked != availability_.end()) {
+                close(tracked->second, latest_ms_);
+                availability_.erase(tracked);
+            }
+            hub_->publish(tenant_, {}, {node_name});
+            return true;
+        }
+
+        // Applies `fn` to every selected node in one transaction: one lock
+        // acquisition, one revision bump and one watch event for the whole batch.
+        // `fn` returns true if it changed the node.
+        template <typename Fn>
+        BulkResult mutate(const NodeSelector& selector, Fn&& fn) {
+            static const lockprof::LockSite site("registry.mutate");
+            lockprof::ProfiledLock<std::mutex> lock(mutex_, site);
+            BulkResult result;
+            std::vector<NodeState> changed;
+            auto apply = [&](NodeState& state) {
+                if (!selector.matches_labels(state)) {
+                    return;
+                }
+                result.matched++;
+                if (fn(state)) {
+                    changed.push_back(state);
+                }
+            };
+            if (!selector.names.empty()) {
+                for (const auto& name : selector.names) {
+                    auto it = nodes_.find(name);
+                    if (it != nodes_.end()) {
+                        apply(it->second);
+                    }
+                }
+            } else {
+                for (auto& [_, state] : nodes_) {
+                    apply(state);
+                }
+            }
+            result.changed = changed.size();
+            result.revision = changed.empty() ? hub_->revision() : hub_->publish(tenant_, std::move(changed));
+            return result;
+        }
+
+        BulkResult set_unschedulable(const NodeSelector& selector, bool unschedulable) {
+            return mutate(selector, [&](NodeState& state) {
+                if (state.unschedulable == unschedulable) {
+                    return false;
+                }
+                state.unschedulable = unschedulable;
+                return true;
+            });
+        }
+
+        BulkResult update_labels(const NodeSelector& selector,
+                                 const std::map<std::string, std::string>& set_labels,
+                                 const std::vector<std::string>& remove_labels) {
+            return mutate(selector, [&](NodeState& state) {
+                bool changed = false;
+                for (const auto& key : remove_labels) {
+                    changed |= state.labels.erase(key) > 0;
+                }
+                for (const auto& [key, value] : set_labels) {
+                    auto [it, inserted] = state.labels.try_emplace(key, value);
+                    if (!inserted && it->second != value) {
+                        it->second = value;
+                        inserted = true;
+                    }
+                    changed |= inserted;
+                }
+                return changed;
+            });
         }
 
         bool exists(const std::string& node_name) const {
-            std::lock_guard<std::mutex> lock(mutex_);
+            static const lockprof::LockSite site("registry.exists");
+            lockprof::ProfiledLock<std::mutex> lock(mutex_, site);
             return nodes_.contains(node_name);
         }
 
+        std::optional<NodeState> get(const std::string& node_name) const {
+            static const lockprof::LockSite site("registry.get");
+            lockprof::ProfiledLock<std::mutex> lock(mutex_, site);
+            auto it = nodes_.find(node_name);
+            if (it == nodes_.end()) {
+                return std::nullopt;
+            }
+            return it->second;
+        }
+
+        // fn(const NodeState&) for every node under one lock hold; it must not
+        // call back into the registry
+        template <typename Fn>
+        void for_each_node(Fn&& fn) const {
+            static const lockprof::LockSite site("registry.for_each_node");
+            lockprof::ProfiledLock<std::mutex> lock(mutex_, site);
+            for (const auto& [_, state] : nodes_) {
+                fn(state);
+            }
+        }
+
+        // fn(const NodeState&, const SloReport&) with each node's 1h/1d/30d
+        // availability (all zero if untracked), under one lock hold
+        template <typename Fn>
+        void for_each_node(int64_t now_ms, Fn&& fn) const {
+            static const lockprof::LockSite site("registry.for_each_node");
+            lockprof::ProfiledLock<std::mutex> lock(mutex_, site);
+            static const SloReport untracked{};
+            for (const auto& [name, state] : nodes_) {
+                auto it = availability_.find(name);
+                fn(state, it != availability_.end() ? node_report(it->second, now_ms) : untracked);
+            }
+        }
+
         size_t size() const {
-            std::lock_guard<std::mutex> lock(mutex_);
+            static const lockprof::LockSite site("registry.size");
+            lockprof::ProfiledLock<std::mutex> lock(mutex_, site);
             return nodes_.size();
         }
 
         std::vector<NodeState> snapshot() {
-            std::lock_guard<std::mutex> lock(mutex_);
+            uint64_t revision;
+            return snapshot(revision);
+        }
+
+        // snapshot plus the revision it reflects, so a watcher can resume from it
+        std::vector<NodeState> snapshot(uint64_t& revision) {
+            static const lockprof::LockSite site("registry.snapshot");
+            lockprof::ProfiledLock<std::mutex> lock(mutex_, site);
             std::vector<NodeState> snapshot;
             snapshot.reserve(nodes_.size());
             for (const auto& [_, state] : nodes_) {
                 snapshot.push_back(state);
             }
+            revision = hub_->revision();
             return snapshot;
         }
+
+        uint64_t revision() const {
+            return hub_->revision();
+        }
+
+
+        // 1h/1d/30d availability of one node, nullopt if it isn't registered
+        std::optional<SloReport> availability(const std::string& node_name, int64_t now_ms) const {
+            static const lockprof::LockSite site("registry.availability");
+            lockprof::ProfiledLock<std::mutex> lock(mutex_, site);
+            auto it = availability_.find(node_name);
+            if (it == availability_.end()) {
+                return std::nullopt;
+            }
+            return node_report(it->second, now_ms);
+        }
+
+        // summed node-time across every node in this registry
+        SloReport fleet_availability(int64_t now_ms) const {
+            static const lockprof::LockSite site("registry.fleet_availability");
+            lockprof::ProfiledLock<std::mutex> lock(mutex_, site);
+            return fleet_.report(now_ms);
+        }
+
+        // walks every node, so meant for periodic reporting rather than hot paths
+        MemoryUsage memory_usage() const {
+            static const lockprof::LockSite site("registry.memory_usage");
+            lockprof::ProfiledLock<std::mutex> lock(mutex_, site);
+            MemoryUsage usage;
+            usage.nodes = nodes_.size();
+            usage.node_bytes = container_bytes(nodes_);
+            for (const auto& [name, state] : nodes_) {
+                usage.string_bytes += heap_bytes(name) + heap_bytes(state.name) + heap_bytes(state.tenant) +
+                                      heap_bytes(state.peer);
+                usage.label_bytes += container_bytes(state.labels);
+                for (const auto& [key, value] : state.labels) {
+                    usage.label_bytes += heap_bytes(key) + heap_bytes(value);
+                }
+            }
+            usage.availability_bytes = container_bytes(availability_);
+            for (const auto& [name, _] : availability_) {
+                usage.string_bytes += heap_bytes(name);
+            }
+            return usage;
+        }
+
+        WatchHub& watch_hub() {
+            return *hub_;
+        }
     private:
+        bool touch_locked(const std::string& node_name, int64_t now_ms, std::vector<NodeState>& changed) {
+            auto it = nodes_.find(node_name);
+            if (it == nodes_.end()) {
+                return false;
+            }
+            auto& state = it->second;
+            state.jitter.observe(now_ms - state.last_seen_ms);
+            state.last_seen_ms = now_ms;
+            NodeStatus status = state.is_degraded() ? NodeStatus::DEGRADED : NodeStatus::READY;
+            if (state.status != status) {
+                state.status = status;
+                track(node_name, status, now_ms);
+                changed.push_back(state);
+            }
+            return true;
+        }
+
+        // called under mutex_ whenever a node's status may have changed
+        void track(const std::string& node_name, NodeStatus status, int64_t at_ms) {
+            latest_ms_ = std::max(latest_ms_, at_ms);
+            bool up = counts_as_up(status);
+            auto [it, inserted] = availability_.try_emplace(node_name);
+            auto& availability = it->second;
+            if (!inserted) {
+                if (availability.up == up) {
+                    return;
+                }
+                close(availability, at_ms);
+            }
+            availability.up = up;
+            availability.since_ms = at_ms;
+            fleet_.open(up, at_ms);
+        }
+
+        void close(NodeAvailability& availability, int64_t at_ms) {
+            int64_t until = std::max(availability.since_ms, at_ms);
+            availability.windows.add(availability.since_ms, until, availability.up);
+            fleet_.close(availability.up, availability.since_ms, until);
+        }
+
+        void checkpoint(NodeAvailability& availability, int64_t at_ms) {
+            latest_ms_ = std::max(latest_ms_, at_ms);
+            close(availability, at_ms);
+            availability.since_ms = std::max(availability.since_ms, at_ms);
+            fleet_.open(availability.up, availability.since_ms);
+        }
+
         std::unordered_map<std::string, NodeState> nodes_;
+        std::unordered_map<std::string, NodeAvailability> availability_;
+        FleetAvailability fleet_;
+        int64_t latest_ms_{0};  // newest time seen, closes intervals of removed nodes
+        std::shared_ptr<WatchHub> hub_;
+        std::string tenant_;
         mutable std::mutex mutex_;
     };
 } // namespace tinykube
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+
+namespace tinykube {
+    // classic token bucket: `rate_per_sec` refill, up to `burst` tokens banked
+    class TokenBucket {
+    public:
+        TokenBucket(double rate_per_sec, double burst)
+            : rate_per_ms_(rate_per_sec / 1000.0), burst_(burst), tokens_(burst) {}
+
+        bool try_acquire(int64_t now_ms, double tokens = 1.0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            refill(now_ms);
+            if (tokens_ < tokens) {
+                return false;
+            }
+            tokens_ -= tokens;
+            return true;
+        }
+
+        void configure(double rate_per_sec, double burst) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            rate_per_ms_ = rate_per_sec / 1000.0;
+            burst_ = burst;
+            tokens_ = std::min(tokens_, burst_);
+        }
+    private:
+        void refill(int64_t now_ms) {
+            if (last_refill_ms_ == 0) {
+                last_refill_ms_ = now_ms;
+                return;
+            }
+            if (now_ms > last_refill_ms_) {
+                tokens_ = std::min(burst_, tokens_ + (now_ms - last_refill_ms_) * rate_per_ms_);
+                last_refill_ms_ = now_ms;
+            }
+        }
+
+        double rate_per_ms_;
+        double burst_;
+        double tokens_;
+        int64_t last_refill_ms_{0};
+        std::mutex mutex_;
+    };
+} // namespace tinykube
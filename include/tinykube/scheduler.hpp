@@ -0,0 +1,174 @@
+#pragma once
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tinykube/drf_queue.hpp"
+#include "tinykube/types.hpp"
+#include "tinykube/workload.hpp"
+
+namespace tinykube {
+    struct SchedulerStats {
+        size_t pending{0};
+        size_t running{0};
+        size_t parked{0};  // pending, but larger than every live node
+        size_t bound_last_pass{0};
+    };
+
+    // Binds pending workloads to live (READY or DEGRADED), uncordoned nodes. Which workload goes
+    // next is the DrfQueue's call; where it goes is the node with the most room
+    // left for it. A workload no live node could hold even empty is parked
+    // instead, so it can't stall the queue behind it; parked work is offered
+    // again on every pass in case a big enough node has joined.
+    class Scheduler {
+    public:
+        // false (with `reason`) if the workload can never run, is a duplicate or
+        // would take its tenant past `limits`, which it counts against until completed
+        bool submit(Workload workload, const WorkloadLimits& limits, std::string& reason) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (workload.request.cpu_millis < 0 || workload.request.memory_mb < 0) {
+                reason = "Resource requests must not be negative";
+                return false;
+            }
+            auto& usage = usage_[workload.tenant];
+            // room left rather than usage + request, which could overflow
+            Resources room = limits.max_requested - usage.requested;
+            if (usage.workloads >= limits.max_workloads || !workload.request.fits_in(room)) {
+                if (usage.workloads == 0) {
+                    usage_.erase(workload.tenant);
+                }
+                reason = "Tenant workload quota exceeded";
+                return false;
+            }
+            auto [it, inserted] = workloads_.try_emplace(key(workload.tenant, workload.name), workload);
+            if (!inserted) {
+                if (usage.workloads == 0) {
+                    usage_.erase(workload.tenant);
+                }
+                reason = "Workload already exists";
+                return false;
+            }
+            usage.workloads++;
+            usage.requested += workload.request;
+            queue_.push(std::move(workload));
+            return true;
+        }
+
+        // marks a running workload done and gives its resources back
+        bool complete(const std::string& tenant, const std::string& name) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = workloads_.find(key(tenant, name));
+            if (it == workloads_.end() || it->second.phase != WorkloadPhase::RUNNING) {
+                return false;
+            }
+            node_allocated_[it->second.node] -= it->second.request;
+            queue_.release(tenant, it->second.request);
+            auto usage = usage_.find(tenant);
+            usage->second.requested -= it->second.request;
+            if (--usage->second.workloads == 0) {
+                usage_.erase(usage);
+            }
+            workloads_.erase(it);
+            running_--;
+            return true;
+        }
+
+        // one scheduling pass over the current node set
+        size_t schedule(const std::vector<NodeState>& nodes) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::vector<const NodeState*> candidates;
+            Resources total;
+            for (const auto& node : nodes) {
+                if (node.is_alive() && !node.unschedulable) {
+                    candidates.push_back(&node);
+                    total += node.capacity;
+                }
+            }
+            queue_.set_capacity(total);
+            for (auto& workload : parked_) {
+                queue_.push(std::move(workload));
+            }
+            parked_.clear();
+
+            size_t bound = 0;
+            while (auto workload = queue_.pop()) {
+                const NodeState* target = pick_node(candidates, workload->request);
+                if (target == nullptr) {
+                    if (!fits_any(candidates, workload->request)) {
+                        queue_.release(workload->tenant, workload->request);
+                        parked_.push_back(std::move(*workload));
+                        continue;
+                    }
+                    // strict DRF order: the fairest next workload waits for room
+                    queue_.unpop(std::move(*workload));
+                    break;
+                }
+                auto& stored = workloads_[key(workload->tenant, workload->name)];
+                stored.node = key(target->tenant, target->name);
+                stored.phase = WorkloadPhase::RUNNING;
+                node_allocated_[stored.node] += workload->request;
+                running_++;
+                bound++;
+            }
+            bound_last_pass_ = bound;
+            return bound;
+        }
+
+        SchedulerStats stats() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return SchedulerStats{workloads_.size() - running_, running_, parked_.size(), bound_last_pass_};
+        }
+    private:
+        struct TenantUsage {
+            size_t workloads{0};
+            Resources requested;
+        };
+
+        static std::string key(const std::string& tenant, const std::string& name) {
+            return tenant + "/" + name;
+        }
+
+        static bool fits_any(const std::vector<const NodeState*>& candidates, const Resources& request) {
+            return std::any_of(candidates.begin(), candidates.end(),
+                               [&](const NodeState* node) { return request.fits_in(node->capacity); });
+        }
+
+        const NodeState* pick_node(const std::vector<const NodeState*>& candidates, const Resources& request) {
+            const NodeState* best = nullptr;
+            double best_room = -1.0;
+            for (const auto* node : candidates) {
+                Resources free = node->capacity;
+                auto it = node_allocated_.find(key(node->tenant, node->name));
+                if (it != node_allocated_.end()) {
+                    free -= it->second;
+                }
+                if (!request.fits_in(free)) {
+                    continue;
+                }
+                // fraction of the node's scarcer resource still free after placing
+                Resources left = free - request;
+                double room = std::min(
+                    node->capacity.cpu_millis > 0 ? static_cast<double>(left.cpu_millis) / node->capacity.cpu_millis : 0.0,
+                    node->capacity.memory_mb > 0 ? static_cast<double>(left.memory_mb) / node->capacity.memory_mb : 0.0);
+                // shaky heartbeats make a node look fuller than it is
+                room /= 1.0 + node->jitter.score();
+                if (room > best_room) {
+                    best = node;
+                    best_room = room;
+                }
+            }
+            return best;
+        }
+
+        DrfQueue queue_;
+        std::vector<Workload> parked_;
+        std::unordered_map<std::string, TenantUsage> usage_;
+        std::unordered_map<std::string, Workload> workloads_;
+        std::unordered_map<std::string, Resources> node_allocated_;
+        size_t running_{0};
+        size_t bound_last_pass_{0};
+        mutable std::mutex mutex_;
+    };
+} // namespace tinykube
@@ -0,0 +1,488 @@
+#pragma once
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tinykube/heartbeat_frame.hpp"
+#include "tinykube/ingest.hpp"
+#include "tinykube/time.hpp"
+#include "tinykube/trace.hpp"
+
+namespace tinykube {
+    inline constexpr uint32_t SHM_RING_MAGIC = 0x31524b54;  // "TKR1"
+
+    // Start of a shared-memory ring; HeartbeatFrame slots follow it. The
+    // producer owns tail, the consumer owns head, and `consumer_idle` is set
+    // by the consumer just before it sleeps on the eventfd.
+    struct ShmRingHeader {
+        uint32_t magic{SHM_RING_MAGIC};
+        uint32_t capacity{0};  // slots, a power of two
+        alignas(64) std::atomic<uint64_t> tail{0};
+        alignas(64) std::atomic<uint64_t> head{0};
+        alignas(64) std::atomic<uint32_t> consumer_idle{0};
+    };
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring indexes are shared between processes");
+    static_assert(sizeof(ShmRingHeader) % sizeof(HeartbeatFrame) == 0);
+
+    inline size_t shm_ring_bytes(uint32_t capacity) {
+        return sizeof(ShmRingHeader) + static_cast<size_t>(capacity) * sizeof(HeartbeatFrame);
+    }
+
+    // One producer's side of a ring, for an agent or a relay on the same host
+    // as the control plane. Pushing is a copy into shared memory and a store;
+    // the only syscall is an eventfd write when the consumer went to sleep.
+    class ShmHeartbeatProducer {
+    public:
+        ShmHeartbeatProducer() = default;
+
+        ~ShmHeartbeatProducer() {
+            close();
+        }
+
+        ShmHeartbeatProducer(const ShmHeartbeatProducer&) = delete;
+        ShmHeartbeatProducer& operator=(const ShmHeartbeatProducer&) = delete;
+
+        // `path` is the control plane's --shm socket
+        bool connect(const std::string& path, std::string& error) {
+            socket_fd_ = open_frame_socket("unix:" + path, false, error);
+            if (socket_fd_ < 0) {
+                return false;
+            }
+            int fds[2] = {-1, -1};
+            char byte = 0;
+            iovec iov{&byte, 1};
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))];
+            msghdr message{};
+            message.msg_iov = &iov;
+            message.msg_iovlen = 1;
+            message.msg_control = control;
+            message.msg_controllen = sizeof(control);
+            cmsghdr* cmsg = nullptr;
+            if (::recvmsg(socket_fd_, &message, MSG_CMSG_CLOEXEC) != 1 || (cmsg = CMSG_FIRSTHDR(&message)) == nullptr ||
+                cmsg->cmsg_type != SCM_RIGHTS || cmsg->cmsg_len != CMSG_LEN(sizeof(fds))) {
+                error = "control plane did not hand over a ring";
+                close();
+                return false;
+            }
+            std::memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+            wake_fd_ = fds[1];
+
+            uint32_t prefix[2] = {0, 0};  // magic, capacity
+            bool sized = ::pread(fds[0], prefix, sizeof(prefix), 0) == sizeof(prefix);
+            if (sized && prefix[0] == SHM_RING_MAGIC && prefix[1] > 0 && (prefix[1] & (prefix[1] - 1)) == 0) {
+                bytes_ = shm_ring_bytes(prefix[1]);
+                void* mapping = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fds[0], 0);
+                ring_ = mapping == MAP_FAILED ? nullptr : static_cast<ShmRingHeader*>(mapping);
+            }
+            ::close(fds[0]);
+            if (ring_ == nullptr) {
+                error = "could not map the ring";
+                close();
+                return false;
+            }
+            slots_ = reinterpret_cast<HeartbeatFrame*>(ring_ + 1);
+            mask_ = ring_->capacity - 1;
+            tail_ = ring_->tail.load(std::memory_order_relaxed);
+            return true;
+        }
+
+        // copies as many frames as fit; the rest is the caller's to retry
+        size_t push(const HeartbeatFrame* frames, size_t count) {
+            uint64_t head = ring_->head.load(std::memory_order_acquire);
+            size_t space = ring_->capacity - static_cast<size_t>(tail_ - head);
+            count = std::min(count, space);
+            for (size_t i = 0; i < count; i++) {
+                slots_[(tail_ + i) & mask_] = frames[i];
+            }
+            if (count == 0) {
+                return 0;
+            }
+            tail_ += count;
+            ring_->tail.store(tail_, std::memory_order_release);
+            // pairs with the consumer's fence between setting idle and rechecking tail
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (ring_->consumer_idle.load(std::memory_order_relaxed)) {
+                uint64_t one = 1;
+                ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+                (void)written;
+                wakeups_++;
+            }
+            return count;
+        }
+
+        // blocks while the ring is full; false if the control plane went away
+        bool push_all(const HeartbeatFrame* frames, size_t count) {
+            while (count > 0) {
+                size_t pushed = push(frames, count);
+                frames += pushed;
+                count -= pushed;
+                if (pushed == 0) {
+                    pollfd peer{socket_fd_, POLLRDHUP, 0};
+                    if (::poll(&peer, 1, 0) != 0) {
+                        return false;
+                    }
+                    std::this_thread::yield();
+                }
+            }
+            return true;
+        }
+
+        uint64_t wakeups() const {
+            return wakeups_;
+        }
+
+        void close() {
+            if (ring_ != nullptr) {
+                ::munmap(ring_, bytes_);
+                ring_ = nullptr;
+            }
+            for (int* fd : {&wake_fd_, &socket_fd_}) {
+                if (*fd >= 0) {
+                    ::close(*fd);
+                    *fd = -1;
+                }
+            }
+        }
+    private:
+        int socket_fd_{-1};
+        int wake_fd_{-1};
+        ShmRingHeader* ring_{nullptr};
+        HeartbeatFrame* slots_{nullptr};
+        size_t bytes_{0};
+        uint64_t mask_{0};
+        uint64_t tail_{0};
+        uint64_t wakeups_{0};
+    };
+
+    struct ShmServerStats {
+        uint64_t frames{0};
+        uint64_t bad_frames{0};
+        uint64_t producers{0};  // currently attached
+        uint64_t refused{0};    // producers turned away at MAX_PRODUCERS
+        uint64_t sleeps{0};     // times the consumer went idle and blocked
+    };
+
+    // Consumer side: producers connect to a unix socket and get a fresh ring
+    // (a memfd) plus the consumer's eventfd. One thread drains every ring in
+    // batches, spins briefly when all are empty, then sleeps until a producer
+    // that saw `consumer_idle` writes the eventfd.
+    class ShmHeartbeatServer {
+    public:
+        using BatchSink = std::function<void(const HeartbeatFrame* frames, size_t count, int64_t now_ms)>;
+
+        static constexpr uint32_t RING_CAPACITY = 1 << 14;
+        static constexpr size_t MAX_BATCH = 256;
+        static constexpr int IDLE_SPINS = 1000;
+        static constexpr uint32_t HANGUP_CHECK_PASSES = 1 << 16;  // reap dead producers even when never idle
+        static constexpr size_t MAX_PRODUCERS = 64;  // each ring is a 2 MiB memfd
+
+        explicit ShmHeartbeatServer(BatchSink sink) : sink_(std::move(sink)) {}
+
+        ~ShmHeartbeatServer() {
+            stop();
+        }
+
+        ShmHeartbeatServer(const ShmHeartbeatServer&) = delete;
+        ShmHeartbeatServer& operator=(const ShmHeartbeatServer&) = delete;
+
+        bool start(const std::string& path, std::string& error) {
+            listen_fd_ = open_frame_socket("unix:" + path, true, error);
+            if (listen_fd_ < 0) {
+                return false;
+            }
+            path_ = path;
+            wake_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            if (wake_fd_ < 0) {
+                error = std::string("eventfd: ") + std::strerror(errno);
+                ::close(listen_fd_);
+                ::unlink(path_.c_str());
+                return false;
+            }
+            consumer_ = std::thread([this] { consume(); });
+            acceptor_ = std::thread([this] { accept_producers(); });
+            return true;
+        }
+
+        void stop() {
+            if (stopping_.exchange(true) || !consumer_.joinable()) {
+                return;
+            }
+            ::shutdown(listen_fd_, SHUT_RDWR);  // wakes accept()
+            acceptor_.join();
+            wake();
+            consumer_.join();
+            // one last pass for whatever producers published before the stop
+            adopt_pending();
+            int64_t now = now_ms();
+            for (auto& ring : rings_) {
+                drain(*ring, now);
+            }
+            ::close(listen_fd_);
+            ::close(wake_fd_);
+            ::unlink(path_.c_str());
+        }
+
+        ShmServerStats stats() const {
+            ShmServerStats stats;
+            stats.frames = frames_.load(std::memory_order_relaxed);
+            stats.bad_frames = bad_frames_.load(std::memory_order_relaxed);
+            stats.producers = producers_.load(std::memory_order_relaxed);
+            stats.refused = refused_.load(std::memory_order_relaxed);
+            stats.sleeps = sleeps_.load(std::memory_order_relaxed);
+            return stats;
+        }
+    private:
+        struct Ring {
+            int socket_fd{-1};  // hangs up when the producer exits
+            ShmRingHeader* header{nullptr};
+            const HeartbeatFrame* slots{nullptr};
+            uint32_t capacity{0};  // our copies: the producer can write the shared header
+            uint64_t head{0};
+            bool closing{false};
+
+            ~Ring() {
+                if (header != nullptr) {
+                    ::munmap(header, shm_ring_bytes(capacity));
+                }
+                if (socket_fd >= 0) {
+                    ::close(socket_fd);
+                }
+            }
+        };
+
+        void wake() {
+            uint64_t one = 1;
+            ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+            (void)written;
+        }
+
+        void accept_producers() {
+            while (!stopping_.load()) {
+                int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+                if (fd < 0) {
+                    if (errno == EINTR || errno == ECONNABORTED) {
+                        continue;
+                    }
+                    return;
+                }
+                if (attached_.load() >= MAX_PRODUCERS) {
+                    ::close(fd);  // the producer's handshake fails and it can fall back to another transport
+                    refused_.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                auto ring = attach(fd);
+                if (ring) {
+                    attached_.fetch_add(1);
+                    std::lock_guard<std::mutex> lock(pending_mutex_);
+                    pending_.push_back(std::move(ring));
+                    has_pending_.store(true, std::memory_order_release);
+                }
+                wake();
+            }
+        }
+
+        // creates the ring and hands it to the producer with the eventfd
+        std::unique_ptr<Ring> attach(int fd) {
+            auto ring = std::make_unique<Ring>();
+            ring->socket_fd = fd;
+            int memory_fd = ::memfd_create("tinykube-heartbeats", MFD_CLOEXEC);
+            size_t bytes = shm_ring_bytes(RING_CAPACITY);
+            if (memory_fd < 0 || ::ftruncate(memory_fd, static_cast<off_t>(bytes)) != 0) {
+                if (memory_fd >= 0) {
+                    ::close(memory_fd);
+                }
+                return nullptr;
+            }
+            void* mapping = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, memory_fd, 0);
+            if (mapping == MAP_FAILED) {
+                ::close(memory_fd);
+                return nullptr;
+            }
+            ring->header = new (mapping) ShmRingHeader();
+            ring->header->capacity = ring->capacity = RING_CAPACITY;
+            ring->slots = reinterpret_cast<const HeartbeatFrame*>(ring->header + 1);
+
+            int fds[2] = {memory_fd, wake_fd_};
+            char byte = 0;
+            iovec iov{&byte, 1};
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))] = {};
+            msghdr message{};
+            message.msg_iov = &iov;
+            message.msg_iovlen = 1;
+            message.msg_control = control;
+            message.msg_controllen = sizeof(control);
+            cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+            std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+            bool sent = ::sendmsg(fd, &message, MSG_NOSIGNAL) == 1;
+            ::close(memory_fd);
+            return sent ? std::move(ring) : nullptr;
+        }
+
+        // copies out of shared memory before validating, so a producer can't
+        // change a frame between the check and the use
+        size_t drain(Ring& ring, int64_t now) {
+            ShmRingHeader& header = *ring.header;
+            uint64_t head = ring.head;
+            uint64_t tail = header.tail.load(std::memory_order_acquire);
+            if (tail - head > ring.capacity) {
+                ring.closing = true;  // corrupted by the producer
+                return 0;
+            }
+            size_t total = 0;
+            while (head != tail) {
+                size_t count = std::min<size_t>(tail - head, MAX_BATCH);
+                for (size_t i = 0; i < count; i++) {
+                    batch_[i] = ring.slots[(head + i) & (ring.capacity - 1)];
+                }
+                head += count;
+                ring.head = head;
+                header.head.store(head, std::memory_order_release);
+
+                size_t valid = 0;
+                for (size_t i = 0; i < count; i++) {
+                    if (batch_[i].valid()) {
+                        batch_[valid++] = batch_[i];
+                    }
+                }
+                bad_frames_.fetch_add(count - valid, std::memory_order_relaxed);
+                frames_.fetch_add(valid, std::memory_order_relaxed);
+                if (valid > 0) {
+                    sink_(batch_, valid, now);
+                }
+                total += count;
+            }
+            return total;
+        }
+
+        void adopt_pending() {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            for (auto& ring : pending_) {
+                rings_.push_back(std::move(ring));
+            }
+            pending_.clear();
+            has_pending_.store(false, std::memory_order_relaxed);
+            producers_.store(rings_.size(), std::memory_order_relaxed);
+        }
+
+        void consume() {
+            int idle_passes = 0;
+            uint32_t passes = 0;
+            while (!stopping_.load(std::memory_order_relaxed)) {
+                if (has_pending_.load(std::memory_order_acquire)) {
+                    adopt_pending();
+                }
+                if (++passes % HANGUP_CHECK_PASSES == 0) {
+                    wait_for_work(0);
+                }
+                size_t drained = 0;
+                int64_t now = now_ms();
+                for (auto& ring : rings_) {
+                    drained += drain(*ring, now);
+                }
+                if (drained > 0) {
+                    idle_passes = 0;
+                    continue;
+                }
+                if (++idle_passes < IDLE_SPINS) {
+                    cpu_relax();
+                    continue;
+                }
+                idle_passes = 0;
+                sleep();
+            }
+        }
+
+        // announce idleness, recheck, and only then block
+        void sleep() {
+            for (auto& ring : rings_) {
+                ring->header->consumer_idle.store(1, std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool empty = !has_pending_.load(std::memory_order_relaxed);
+            for (auto& ring : rings_) {
+                empty = empty && ring->header->tail.load(std::memory_order_relaxed) == ring->head;
+            }
+
+            if (empty) {
+                sleeps_.fetch_add(1, std::memory_order_relaxed);
+                wait_for_work(-1);
+            }
+            for (auto& ring : rings_) {
+                ring->header->consumer_idle.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        // polls the eventfd and every producer's socket, then retires the
+        // rings whose producer hung up once they are drained
+        void wait_for_work(int timeout_ms) {
+            poll_fds_.assign(1, pollfd{wake_fd_, POLLIN, 0});
+            for (auto& ring : rings_) {
+                poll_fds_.push_back({ring->socket_fd, POLLRDHUP, 0});
+            }
+            if (::poll(poll_fds_.data(), poll_fds_.size(), timeout_ms) <= 0) {
+                return;
+            }
+            uint64_t value;
+            ssize_t got = ::read(wake_fd_, &value, sizeof(value));
+            (void)got;
+            for (size_t i = 1; i < poll_fds_.size(); i++) {
+                rings_[i - 1]->closing = rings_[i - 1]->closing || poll_fds_[i].revents != 0;
+            }
+
+            int64_t now = now_ms();
+            for (auto& ring : rings_) {
+                if (ring->closing) {
+                    drain(*ring, now);
+                }
+            }
+            size_t before = rings_.size();
+            rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const auto& ring) { return ring->closing; }),
+                         rings_.end());
+            if (rings_.size() != before) {
+                attached_.fetch_sub(before - rings_.size());
+                producers_.store(rings_.size(), std::memory_order_relaxed);
+            }
+        }
+
+        BatchSink sink_;
+        std::string path_;
+        int listen_fd_{-1};
+        int wake_fd_{-1};
+        std::atomic<bool> stopping_{false};
+        std::thread acceptor_;
+        std::thread consumer_;
+
+        std::mutex pending_mutex_;
+        std::vector<std::unique_ptr<Ring>> pending_;
+        std::atomic<bool> has_pending_{false};
+        std::atomic<size_t> attached_{0};  // pending plus adopted, for the producer cap
+        std::vector<std::unique_ptr<Ring>> rings_;  // consumer thread only
+        std::vector<pollfd> poll_fds_;
+        HeartbeatFrame batch_[MAX_BATCH];
+
+        std::atomic<uint64_t> frames_{0};
+        std::atomic<uint64_t> bad_frames_{0};
+        std::atomic<uint64_t> producers_{0};
+        std::atomic<uint64_t> refused_{0};
+        std::atomic<uint64_t> sleeps_{0};
+    };
+} // namespace tinykube
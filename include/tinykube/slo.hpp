@@ -0,0 +1,176 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "tinykube/types.hpp"
+
+namespace tinykube {
+    struct Availability {
+        int64_t up_ms{0};
+        int64_t observed_ms{0};
+
+        double ratio() const {
+            return observed_ms > 0 ? static_cast<double>(up_ms) / observed_ms : 1.0;
+        }
+
+        Availability& operator+=(const Availability& other) {
+            up_ms += other.up_ms;
+            observed_ms += other.observed_ms;
+            return *this;
+        }
+    };
+
+    struct SloReport {
+        Availability hour;
+        Availability day;
+        Availability month;  // 30 days
+
+        SloReport& operator+=(const SloReport& other) {
+            hour += other.hour;
+            day += other.day;
+            month += other.month;
+            return *this;
+        }
+    };
+
+    // READY and DEGRADED count as available; anything else is time out of rotation
+    inline bool counts_as_up(NodeStatus status) {
+        return status == NodeStatus::READY || status == NodeStatus::DEGRADED;
+    }
+
+    // Sliding window of N buckets, each BucketMs wide. Buckets are recycled as
+    // time moves forward, so memory is fixed and adding an interval touches at
+    // most the buckets it overlaps (one or two for the short intervals the
+    // registry feeds in).
+    template <int64_t BucketMs, size_t N, typename Counter>
+    class BucketRing {
+    public:
+        void add(int64_t from_ms, int64_t to_ms, bool up) {
+            from_ms = std::max(from_ms, to_ms - BucketMs * static_cast<int64_t>(N));
+            while (from_ms < to_ms) {
+                int64_t index = from_ms / BucketMs;
+                int64_t end = std::min(to_ms, (index + 1) * BucketMs);
+                if (index > head_) {
+                    roll(index);
+                }
+                if (index > head_ - static_cast<int64_t>(N)) {
+                    size_t slot = static_cast<size_t>(index % static_cast<int64_t>(N));
+                    observed_[slot] += static_cast<Counter>(end - from_ms);
+                    if (up) {
+                        up_[slot] += static_cast<Counter>(end - from_ms);
+                    }
+                }
+                from_ms = end;
+            }
+        }
+
+        Availability sum(int64_t now_ms) const {
+            Availability total;
+            int64_t newest = now_ms / BucketMs;
+            int64_t first = std::max(head_ - static_cast<int64_t>(N) + 1, newest - static_cast<int64_t>(N) + 1);
+            if (first > head_) {
+                return total;
+            }
+            // one modulo, then walk the ring: this runs per node in exports
+            size_t slot = static_cast<size_t>(first % static_cast<int64_t>(N));
+            for (int64_t index = first; index <= head_; index++) {
+                total.up_ms += up_[slot];
+                total.observed_ms += observed_[slot];
+                slot = slot + 1 == N ? 0 : slot + 1;
+            }
+            return total;
+        }
+    private:
+        void roll(int64_t index) {
+            int64_t first = std::max(head_ + 1, index - static_cast<int64_t>(N) + 1);
+            for (int64_t i = first; i <= index; i++) {
+                size_t slot = static_cast<size_t>(i % static_cast<int64_t>(N));
+                up_[slot] = 0;
+                observed_[slot] = 0;
+            }
+            head_ = index;
+        }
+
+        std::array<Counter, N> up_{};
+        std::array<Counter, N> observed_{};
+        int64_t head_{-1};
+    };
+
+    // 1h in 5 minute buckets, 1d in hours, 30d in days
+    template <typename Counter>
+    struct SloWindows {
+        BucketRing<300000, 12, Counter> hour;
+        BucketRing<3600000, 24, Counter> day;
+        BucketRing<86400000, 30, Counter> month;
+
+        void add(int64_t from_ms, int64_t to_ms, bool up) {
+            hour.add(from_ms, to_ms, up);
+            day.add(from_ms, to_ms, up);
+            month.add(from_ms, to_ms, up);
+        }
+
+        SloReport report(int64_t now_ms) const {
+            return SloReport{hour.sum(now_ms), day.sum(now_ms), month.sum(now_ms)};
+        }
+    };
+
+    // per-node state: closed intervals live in the rings, the current one is open
+    struct NodeAvailability {
+        SloWindows<uint32_t> windows;  // a bucket never exceeds a day of ms
+        bool up{false};
+        int64_t since_ms{0};
+    };
+
+    // Fleet-wide rollup fed by the same intervals as the per-node trackers.
+    // The open intervals of all nodes are folded in from running sums, so a
+    // fleet query never walks the nodes.
+    class FleetAvailability {
+    public:
+        void open(bool up, int64_t since_ms) {
+            if (epoch_ms_ < 0) {
+                epoch_ms_ = since_ms;
+            }
+            (up ? up_nodes_ : down_nodes_)++;
+            (up ? up_since_sum_ : down_since_sum_) += since_ms - epoch_ms_;
+        }
+
+        void close(bool up, int64_t since_ms, int64_t until_ms) {
+            (up ? up_nodes_ : down_nodes_)--;
+            (up ? up_since_sum_ : down_since_sum_) -= since_ms - epoch_ms_;
+            windows_.add(since_ms, until_ms, up);
+        }
+
+        SloReport report(int64_t now_ms) const {
+            SloReport report = windows_.report(now_ms);
+            int64_t now = now_ms - std::max<int64_t>(epoch_ms_, 0);
+            int64_t open_up = up_nodes_ * now - up_since_sum_;
+            int64_t open_down = down_nodes_ * now - down_since_sum_;
+            for (auto* window : {&report.hour, &report.day, &report.month}) {
+                window->up_ms += open_up;
+                window->observed_ms += open_up + open_down;
+            }
+            return report;
+        }
+    private:
+        SloWindows<int64_t> windows_;
+        int64_t epoch_ms_{-1};  // since sums are kept relative to this so they can't overflow
+        int64_t up_nodes_{0};
+        int64_t down_nodes_{0};
+        int64_t up_since_sum_{0};
+        int64_t down_since_sum_{0};
+    };
+
+    inline SloReport node_report(const NodeAvailability& node, int64_t now_ms) {
+        SloReport report = node.windows.report(now_ms);
+        int64_t open = std::max<int64_t>(0, now_ms - node.since_ms);
+        for (auto* window : {&report.hour, &report.day, &report.month}) {
+            window->observed_ms += open;
+            if (node.up) {
+                window->up_ms += open;
+            }
+        }
+        return report;
+    }
+} // namespace tinykube
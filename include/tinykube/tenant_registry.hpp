@@ -0,0 +1,201 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tinykube/node_registry.hpp"
+#include "tinykube/rate_limiter.hpp"
+#include "tinykube/watch.hpp"
+#include "tinykube/workload.hpp"
+
+namespace tinykube {
+    inline const std::string DEFAULT_TENANT = "default";
+    inline constexpr size_t DEFAULT_MAX_TENANTS = 1024;
+
+    struct TenantQuota {
+        size_t max_nodes{100000};
+        double registrations_per_sec{200.0};
+        double registration_burst{1000.0};
+        double heartbeats_per_sec{20000.0};
+        double heartbeat_burst{40000.0};
+        WorkloadLimits workloads;
+    };
+
+    // one tenant's slice of the cluster: its own registry (and lock) plus quotas
+    struct TenantPartition {
+        TenantPartition(const std::string& tenant, const TenantQuota& quota, std::shared_ptr<WatchHub> hub)
+            : name(tenant),
+              nodes(std::move(hub), tenant),
+              registrations(quota.registrations_per_sec, quota.registration_burst),
+              heartbeats(quota.heartbeats_per_sec, quota.heartbeat_burst),
+              max_nodes(quota.max_nodes),
+              max_workloads(quota.workloads.max_workloads),
+              max_workload_cpu_millis(quota.workloads.max_requested.cpu_millis),
+              max_workload_memory_mb(quota.workloads.max_requested.memory_mb) {}
+
+        void apply_quota(const TenantQuota& quota) {
+            registrations.configure(quota.registrations_per_sec, quota.registration_burst);
+            heartbeats.configure(quota.heartbeats_per_sec, quota.heartbeat_burst);
+            max_nodes.store(quota.max_nodes, std::memory_order_relaxed);
+            max_workloads.store(quota.workloads.max_workloads, std::memory_order_relaxed);
+            max_workload_cpu_millis.store(quota.workloads.max_requested.cpu_millis, std::memory_order_relaxed);
+            max_workload_memory_mb.store(quota.workloads.max_requested.memory_mb, std::memory_order_relaxed);
+        }
+
+        WorkloadLimits workload_limits() const {
+            return WorkloadLimits{max_workloads.load(std::memory_order_relaxed),
+                                  Resources{max_workload_cpu_millis.load(std::memory_order_relaxed),
+                                            max_workload_memory_mb.load(std::memory_order_relaxed)}};
+        }
+
+        const std::string name;
+        NodeRegistry nodes;
+        TokenBucket registrations;
+        TokenBucket heartbeats;
+        std::atomic<size_t> max_nodes;
+        std::atomic<size_t> max_workloads;
+        std::atomic<int64_t> max_workload_cpu_millis;
+        std::atomic<int64_t> max_workload_memory_mb;
+    };
+
+    // Registry split by tenant. Partitions are created on first use and never
+    // destroyed, so references handed out stay valid for the process lifetime.
+    // That is why tenant names from clients go through admit(), which stops
+    // creating partitions at max_tenants: past that only tenants with a
+    // configured quota get one, so inventing names neither grows memory
+    // without bound nor mints fresh quotas forever.
+    // All partitions share one WatchHub, giving a single cluster-wide revision.
+    class TenantRegistry {
+    public:
+        explicit TenantRegistry(TenantQuota default_quota = {}, size_t max_tenants = DEFAULT_MAX_TENANTS)
+            : default_quota_(default_quota), max_tenants_(max_tenants), hub_(std::make_shared<WatchHub>()) {}
+
+        // the tenant's partition, or nullptr if it has none and the registry
+        // is full of tenants nobody configured
+        TenantPartition* admit(const std::string& tenant) {
+            const std::string& key = tenant.empty() ? DEFAULT_TENANT : tenant;
+            if (auto* existing = find(key)) {
+                return existing;
+            }
+            return create(key, true);
+        }
+
+        // creates unconditionally: for configured tenants and in-process callers
+        TenantPartition& partition(const std::string& tenant) {
+            const std::string& key = tenant.empty() ? DEFAULT_TENANT : tenant;
+            if (auto* existing = find(key)) {
+                return *existing;
+            }
+            return *create(key, false);
+        }
+
+        TenantPartition* find(const std::string& tenant) {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = partitions_.find(tenant.empty() ? DEFAULT_TENANT : tenant);
+            return it != partitions_.end() ? it->second.get() : nullptr;
+        }
+
+        void set_quota(const std::string& tenant, const TenantQuota& quota) {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            quotas_[tenant] = quota;
+            auto it = partitions_.find(tenant);
+            if (it != partitions_.end()) {
+                it->second->apply_quota(quota);
+            }
+        }
+
+        template <typename Fn>
+        void for_each(Fn&& fn) {
+            std::vector<TenantPartition*> partitions;
+            {
+                std::shared_lock<std::shared_mutex> lock(mutex_);
+                partitions.reserve(partitions_.size());
+                for (const auto& [_, partition] : partitions_) {
+                    partitions.push_back(partition.get());
+                }
+            }
+            for (auto* partition : partitions) {
+                fn(*partition);
+            }
+        }
+
+        void sweep(int64_t now_ms, int64_t suspect_timeout_ms, int64_t not_ready_timeout_ms) {
+            for_each([&](TenantPartition& partition) {
+                partition.nodes.sweep(now_ms, suspect_timeout_ms, not_ready_timeout_ms);
+            });
+        }
+
+        // Partitions are copied one at a time, so the result is not a single
+        // point in time. The revision is read first: replaying events after it is
+        // idempotent since they carry whole node states.
+        std::vector<NodeState> snapshot(uint64_t& revision) {
+            revision = hub_->revision();
+            std::vector<NodeState> nodes;
+            for_each([&](TenantPartition& partition) {
+                auto part = partition.nodes.snapshot();
+                nodes.insert(nodes.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+            });
+            return nodes;
+        }
+
+        std::vector<NodeState> snapshot() {
+            uint64_t revision;
+            return snapshot(revision);
+        }
+
+        size_t size() {
+            size_t total = 0;
+            for_each([&](TenantPartition& partition) { total += partition.nodes.size(); });
+            return total;
+        }
+
+        uint64_t revision() const {
+            return hub_->revision();
+        }
+
+        SloReport fleet_availability(int64_t now_ms) {
+            SloReport total;
+            for_each([&](TenantPartition& partition) { total += partition.nodes.fleet_availability(now_ms); });
+            return total;
+        }
+
+        MemoryUsage memory_usage() {
+            MemoryUsage total;
+            for_each([&](TenantPartition& partition) { total += partition.nodes.memory_usage(); });
+            return total;
+        }
+
+        WatchHub& watch_hub() {
+            return *hub_;
+        }
+    private:
+        // The cap is checked under the same unique lock that inserts, so
+        // racing registrations of new tenants can't all pass it and overshoot.
+        TenantPartition* create(const std::string& key, bool capped) {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            auto it = partitions_.find(key);
+            if (it != partitions_.end()) {
+                return it->second.get();
+            }
+            auto quota_it = quotas_.find(key);
+            if (capped && partitions_.size() >= max_tenants_ && key != DEFAULT_TENANT && quota_it == quotas_.end()) {
+                return nullptr;
+            }
+            auto& slot = partitions_[key];
+            slot = std::make_unique<TenantPartition>(
+                key, quota_it != quotas_.end() ? quota_it->second : default_quota_, hub_);
+            return slot.get();
+        }
+
+        TenantQuota default_quota_;
+        size_t max_tenants_;
+        std::unordered_map<std::string, TenantQuota> quotas_;
+        std::unordered_map<std::string, std::unique_ptr<TenantPartition>> partitions_;
+        std::shared_ptr<WatchHub> hub_;
+        mutable std::shared_mutex mutex_;
+    };
+} // namespace tinykube
@@ -0,0 +1,154 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace tinykube {
+    // Hierarchical timing wheel with 1 ms ticks: 7 levels of 64 slots, so level
+    // l slot s holds timers whose deadline digit l (6 bits each) is s and whose
+    // higher digits match the cursor. Inserting is O(1); advancing jumps straight
+    // to the next occupied slot via per-level bitmaps, so idle time costs
+    // nothing no matter how many timers are parked far in the future.
+    class TimingWheel {
+    public:
+        struct Timer {
+            uint64_t id;
+            int64_t deadline_ms;
+        };
+
+        explicit TimingWheel(int64_t start_ms = 0) : now_(start_ms) {}
+
+        // deadlines in the past fire on the next advance()
+        void schedule(uint64_t id, int64_t deadline_ms) {
+            place(Timer{id, deadline_ms < now_ ? now_ : deadline_ms});
+            size_++;
+        }
+
+        // moves the cursor to `target_ms`, appending every timer that came due
+        void advance(int64_t target_ms, std::vector<Timer>& expired) {
+            while (now_ <= target_ms) {
+                auto next = next_event();
+                if (!next || next->at > target_ms) {
+                    now_ = target_ms + 1;
+                    cascade();
+                    return;
+                }
+                now_ = next->at;
+                if (next->level == 0) {
+                    auto& slot = levels_[0][digit(now_, 0)];
+                    occupied_[0] &= ~(uint64_t{1} << digit(now_, 0));
+                    std::vector<Timer> due;
+                    due.swap(slot);
+                    size_ -= due.size();
+                    expired.insert(expired.end(), due.begin(), due.end());
+                    now_++;
+                } else if (next->level == LEVELS) {
+                    std::vector<Timer> parked;
+                    parked.swap(overflow_);
+                    for (const auto& timer : parked) {
+                        place(timer);
+                    }
+                }
+                cascade();
+            }
+        }
+
+        // earliest time anything can happen in the wheel: an expiry or a cascade
+        std::optional<int64_t> next_wakeup() const {
+            auto next = next_event();
+            if (!next) {
+                return std::nullopt;
+            }
+            return next->at;
+        }
+
+        size_t size() const {
+            return size_;
+        }
+
+        int64_t now() const {
+            return now_;
+        }
+    private:
+        static constexpr int LEVELS = 7;
+        static constexpr int BITS = 6;
+        static constexpr int SLOTS = 1 << BITS;
+
+        struct Event {
+            int64_t at;
+            int level;
+        };
+
+        static int digit(int64_t time, int level) {
+            return static_cast<int>((static_cast<uint64_t>(time) >> (BITS * level)) & (SLOTS - 1));
+        }
+
+        static uint64_t prefix(int64_t time, int level) {
+            return static_cast<uint64_t>(time) >> (BITS * (level + 1));
+        }
+
+        void place(const Timer& timer) {
+            int64_t deadline = timer.deadline_ms;
+            int level = 0;
+            while (level < LEVELS - 1 && prefix(deadline, level) != prefix(now_, level)) {
+                level++;
+            }
+            if (prefix(deadline, level) != prefix(now_, level)) {
+                // beyond the top level's range, re-placed once the cursor gets there
+                overflow_.push_back(timer);
+                return;
+            }
+            int slot = digit(deadline, level);
+            levels_[level][slot].push_back(timer);
+            occupied_[level] |= uint64_t{1} << slot;
+        }
+
+        std::optional<Event> next_event() const {
+            for (int level = 0; level < LEVELS; level++) {
+                int current = digit(now_, level);
+                // slots at the cursor's digit above level 0 were cascaded on entry
+                int from = level == 0 ? current : current + 1;
+                if (from >= SLOTS) {
+                    continue;
+                }
+                uint64_t mask = occupied_[level] & (~uint64_t{0} << from);
+                if (mask == 0) {
+                    continue;
+                }
+                int slot = std::countr_zero(mask);
+                uint64_t base = prefix(now_, level) << BITS | static_cast<uint64_t>(slot);
+                return Event{static_cast<int64_t>(base << (BITS * level)), level};
+            }
+            if (!overflow_.empty()) {
+                return Event{static_cast<int64_t>((prefix(now_, LEVELS - 1) + 1) << (BITS * LEVELS)), LEVELS};
+            }
+            return std::nullopt;
+        }
+
+        // After the cursor moves, the slot it entered on each upper level holds
+        // timers that now belong lower down. Top-down, so a timer can fall
+        // through several levels in one pass.
+        void cascade() {
+            for (int level = LEVELS - 1; level > 0; level--) {
+                int current = digit(now_, level);
+                if ((occupied_[level] & (uint64_t{1} << current)) == 0) {
+                    continue;
+                }
+                occupied_[level] &= ~(uint64_t{1} << current);
+                std::vector<Timer> moved;
+                moved.swap(levels_[level][current]);
+                for (const auto& timer : moved) {
+                    place(timer);
+                }
+            }
+        }
+
+        std::array<std::array<std::vector<Timer>, SLOTS>, LEVELS> levels_;
+        std::array<uint64_t, LEVELS> occupied_{};
+        std::vector<Timer> overflow_;
+        int64_t now_;
+        size_t size_{0};
+    };
+} // namespace tinykube
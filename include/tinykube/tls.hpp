@@ -0,0 +1,143 @@
+#pragma once
+#include <sys/stat.h>
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <grpc/grpc_security.h>
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/security/credentials.h>
+#include <grpcpp/security/server_credentials.h>
+
+namespace tinykube {
+    // Mutual TLS material shared by every binary's --tls-ca/--tls-cert/--tls-key.
+    // All empty means plaintext; scripts/gen-certs.sh makes a test set.
+    struct TlsFiles {
+        std::string ca;
+        std::string cert;
+        std::string key;
+        std::string server_name;  // expected in the server certificate, if not the dialed host
+
+        bool enabled() const {
+            return !ca.empty() || !cert.empty() || !key.empty();
+        }
+
+        bool complete(std::string& error) const {
+            if (ca.empty() || cert.empty() || key.empty()) {
+                error = "TLS needs --tls-ca, --tls-cert and --tls-key together";
+                return false;
+            }
+            return true;
+        }
+    };
+
+    inline bool read_pem(const std::string& path, std::string& pem, std::string& error) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            error = "cannot read " + path;
+            return false;
+        }
+        std::ostringstream contents;
+        contents << in.rdbuf();
+        pem = contents.str();
+        return true;
+    }
+
+    struct TlsPems {
+        std::string ca;
+        std::string cert;
+        std::string key;
+    };
+
+    inline bool load_tls(const TlsFiles& files, TlsPems& pems, std::string& error) {
+        return files.complete(error) && read_pem(files.ca, pems.ca, error) && read_pem(files.cert, pems.cert, error) &&
+               read_pem(files.key, pems.key, error);
+    }
+
+    // identifies the current contents of the three files, so a rotated
+    // certificate gets fresh credentials
+    inline std::string tls_version(const TlsFiles& files) {
+        std::ostringstream version;
+        for (const auto* path : {&files.ca, &files.cert, &files.key}) {
+            struct stat info{};
+            ::stat(path->c_str(), &info);
+            version << *path << '@' << info.st_mtim.tv_sec << '.' << info.st_mtim.tv_nsec << ';';
+        }
+        return version.str();
+    }
+
+    // clients must present a certificate signed by the same CA
+    inline std::shared_ptr<grpc::ServerCredentials> server_credentials(const TlsFiles& files, std::string& error) {
+        if (!files.enabled()) {
+            return grpc::InsecureServerCredentials();
+        }
+        TlsPems pems;
+        if (!load_tls(files, pems, error)) {
+            return nullptr;
+        }
+        grpc::SslServerCredentialsOptions options(GRPC_SSL_REQUEST_AND_REQUIRE_CLIENT_CERTIFICATE_AND_VERIFY);
+        options.pem_root_certs = pems.ca;
+        options.pem_key_cert_pairs.push_back({pems.key, pems.cert});
+        return grpc::SslServerCredentials(options);
+    }
+
+    // Cached per set of files: thousands of channels (a simulated fleet, a
+    // federator's upstreams) share one parsed key and certificate chain
+    // instead of reading and parsing the PEMs for each. A rotated file
+    // replaces its entry rather than adding one.
+    inline std::shared_ptr<grpc::ChannelCredentials> channel_credentials(const TlsFiles& files, std::string& error) {
+        if (!files.enabled()) {
+            return grpc::InsecureChannelCredentials();
+        }
+        struct Cached {
+            std::string version;
+            std::shared_ptr<grpc::ChannelCredentials> credentials;
+        };
+        static std::mutex mutex;
+        static std::map<std::string, Cached> cache;  // keyed by the three paths
+        std::string version = tls_version(files);
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& cached = cache[files.ca + '\n' + files.cert + '\n' + files.key];
+        if (!cached.credentials || cached.version != version) {
+            TlsPems pems;
+            if (!load_tls(files, pems, error)) {
+                return nullptr;  // keep whatever worked last time for the other callers
+            }
+            grpc::SslCredentialsOptions options;
+            options.pem_root_certs = pems.ca;
+            options.pem_private_key = pems.key;
+            options.pem_cert_chain = pems.cert;
+            cached = Cached{version, grpc::SslCredentials(options)};
+        }
+        return cached.credentials;
+    }
+
+    // One process-wide TLS session cache: a reconnecting channel resumes its
+    // session from a ticket (an abbreviated handshake, no certificate
+    // exchange or signature) instead of paying for a full handshake.
+    inline void enable_session_resumption(grpc::ChannelArguments& args, size_t capacity = 4096) {
+        static grpc_ssl_session_cache* cache = grpc_ssl_session_cache_create_lru(capacity);
+        grpc_arg arg = grpc_ssl_session_cache_create_channel_arg(cache);
+        args.SetPointerWithVtable(arg.key, arg.value.pointer.p, arg.value.pointer.vtable);
+    }
+
+    // what every binary dials with: TLS per `files`, resumption on, and the
+    // name override when the certificate doesn't carry the dialed host
+    inline std::shared_ptr<grpc::Channel> create_channel(const std::string& address, const TlsFiles& files,
+                                                         grpc::ChannelArguments args, std::string& error) {
+        auto credentials = channel_credentials(files, error);
+        if (!credentials) {
+            return nullptr;
+        }
+        if (files.enabled()) {
+            enable_session_resumption(args);
+            if (!files.server_name.empty()) {
+                args.SetSslTargetNameOverride(files.server_name);
+            }
+        }
+        return grpc::CreateCustomChannel(address, credentials, args);
+    }
+} // namespace tinykube
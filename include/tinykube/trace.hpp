@@ -0,0 +1,183 @@
+#pragma once
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace tinykube::trace {
+    // Span tracing into per-thread ring buffers. With tracing off, a span costs
+    // one relaxed load and a branch that is almost never taken. Names must be
+    // string literals: only the pointer is stored.
+    inline std::atomic<bool> g_enabled{false};
+
+    inline bool enabled() {
+        return __builtin_expect(g_enabled.load(std::memory_order_relaxed), 0);
+    }
+
+    inline void set_enabled(bool on) {
+        g_enabled.store(on, std::memory_order_relaxed);
+    }
+
+    inline uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Single-writer ring; the dumper may read concurrently, so slots are relaxed
+    // atomics. A dump racing a wrap-around can see a slot from either lap, which
+    // only costs an unmatched begin/end in the output.
+    class ThreadBuffer {
+    public:
+        static constexpr size_t CAPACITY = 16384;  // events, must be a power of two
+
+        explicit ThreadBuffer(uint32_t tid) : tid_(tid) {}
+
+        void record(const char* name, bool begin, uint64_t ts_ns) {
+            uint64_t index = head_.load(std::memory_order_relaxed);
+            auto& slot = slots_[index & (CAPACITY - 1)];
+            slot.name.store(name, std::memory_order_relaxed);
+            slot.stamp.store((ts_ns << 1) | (begin ? 1 : 0), std::memory_order_relaxed);
+            head_.store(index + 1, std::memory_order_release);
+        }
+
+        template <typename Fn>
+        void for_each(Fn&& fn) const {
+            uint64_t head = head_.load(std::memory_order_acquire);
+            uint64_t first = head > CAPACITY ? head - CAPACITY : 0;
+            for (uint64_t i = first; i < head; i++) {
+                const auto& slot = slots_[i & (CAPACITY - 1)];
+                uint64_t stamp = slot.stamp.load(std::memory_order_relaxed);
+                fn(slot.name.load(std::memory_order_relaxed), (stamp & 1) != 0, stamp >> 1);
+            }
+        }
+
+        uint32_t tid() const {
+            return tid_;
+        }
+    private:
+        struct Slot {
+            std::atomic<const char*> name{nullptr};
+            std::atomic<uint64_t> stamp{0};  // timestamp << 1 | is_begin
+        };
+
+        uint32_t tid_;
+        std::atomic<uint64_t> head_{0};
+        Slot slots_[CAPACITY];
+    };
+
+    // Owns every thread's buffer so events survive the threads that wrote
+    // them. An exiting thread hands its buffer back and the next new thread
+    // reuses it, tid and all, so the gRPC server's thread churn costs no more
+    // buffers than it ever had threads alive at once; a reused buffer's old
+    // events are overwritten as the new thread records.
+    class Registry {
+    public:
+        static Registry& instance() {
+            static Registry registry;
+            return registry;
+        }
+
+        ThreadBuffer* acquire() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_.empty()) {
+                ThreadBuffer* buffer = free_.back();
+                free_.pop_back();
+                return buffer;
+            }
+            buffers_.push_back(std::make_unique<ThreadBuffer>(static_cast<uint32_t>(buffers_.size() + 1)));
+            return buffers_.back().get();
+        }
+
+        void release(ThreadBuffer* buffer) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_.push_back(buffer);
+        }
+
+        size_t buffers() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return buffers_.size();
+        }
+
+        // Chrome trace event format, loadable in chrome://tracing and Perfetto
+        size_t write_chrome_json(std::ostream& out) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            size_t events = 0;
+            int pid = static_cast<int>(::getpid());
+            out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+            for (const auto& buffer : buffers_) {
+                buffer->for_each([&](const char* name, bool begin, uint64_t ts_ns) {
+                    if (name == nullptr) {
+                        return;
+                    }
+                    out << (events++ == 0 ? "\n" : ",\n")
+                        << "{\"name\":\"" << name << "\",\"ph\":\"" << (begin ? 'B' : 'E')
+                        << "\",\"ts\":" << ts_ns / 1000 << "." << (ts_ns % 1000) / 100 << (ts_ns % 100) / 10 << ts_ns % 10
+                        << ",\"pid\":" << pid << ",\"tid\":" << buffer->tid() << "}";
+                });
+            }
+            out << "\n]}\n";
+            return events;
+        }
+    private:
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+        std::vector<ThreadBuffer*> free_;  // owned by buffers_, not held by a live thread
+        std::mutex mutex_;
+    };
+
+    // a thread's buffer, given back to the registry when the thread exits
+    class LocalBuffer {
+    public:
+        LocalBuffer() : buffer_(Registry::instance().acquire()) {}
+
+        ~LocalBuffer() {
+            Registry::instance().release(buffer_);
+        }
+
+        ThreadBuffer& get() {
+            return *buffer_;
+        }
+    private:
+        ThreadBuffer* buffer_;
+    };
+
+    inline ThreadBuffer& local_buffer() {
+        thread_local LocalBuffer buffer;
+        return buffer.get();
+    }
+
+    // RAII span; the end event is written whenever the begin was, even if
+    // tracing is switched off in between
+    class Span {
+    public:
+        explicit Span(const char* name) : name_(enabled() ? name : nullptr) {
+            if (name_ != nullptr) {
+                local_buffer().record(name_, true, now_ns());
+            }
+        }
+
+        ~Span() {
+            end();
+        }
+
+        void end() {
+            if (name_ != nullptr) {
+                local_buffer().record(name_, false, now_ns());
+                name_ = nullptr;
+            }
+        }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+    private:
+        const char* name_;
+    };
+} // namespace tinykube::trace
+
+#define TK_TRACE_CONCAT_INNER(a, b) a##b
+#define TK_TRACE_CONCAT(a, b) TK_TRACE_CONCAT_INNER(a, b)
+#define TK_TRACE_SPAN(name) ::tinykube::trace::Span TK_TRACE_CONCAT(tk_trace_span_, __LINE__)(name)
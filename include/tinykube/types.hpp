@@ -1,26 +1,92 @@
 #pragma once
+#include <cmath>
 #include <cstdint>
+#include <map>
 #include <string>
 
+#include "tinykube/workload.hpp"
+
 namespace tinykube {
     enum class NodeStatus : uint8_t {
         RESERVED = 0,    // good practice
         READY = 1,       // healthy
         NOT_READY = 2,   // node exists but not ready (starting up)
         SUSPECT = 3,     // missed some heartbeats
-        UNKNOWN = 4
+        UNKNOWN = 4,
+        DEGRADED = 5     // heartbeating, but with erratic timing
+    };
+
+    // the one spelling of a status, shared by logs, JSON, Arrow export and the CLI
+    inline const char* status_name(NodeStatus status) {
+        switch (status) {
+            case NodeStatus::RESERVED:  return "RESERVED";
+            case NodeStatus::READY:     return "READY";
+            case NodeStatus::NOT_READY: return "NOT_READY";
+            case NodeStatus::SUSPECT:   return "SUSPECT";
+            case NodeStatus::UNKNOWN:   return "UNKNOWN";
+            case NodeStatus::DEGRADED:  return "DEGRADED";
+            default:                    return "INVALID";
+        }
+    }
+
+    // EWMA of heartbeat inter-arrival time and its variance (Jacobson-style,
+    // gain 1/8), updated in constant space on every heartbeat
+    struct HeartbeatJitter {
+        static constexpr double GAIN = 0.125;
+        static constexpr uint32_t MIN_SAMPLES = 8;
+        static constexpr double DEGRADED_ENTER = 0.5;   // coefficient of variation
+        static constexpr double DEGRADED_EXIT = 0.35;   // hysteresis so nodes don't flap
+
+        double mean_ms{0.0};
+        double variance_ms2{0.0};
+        uint32_t samples{0};
+
+        void observe(int64_t interval_ms) {
+            double sample = static_cast<double>(interval_ms);
+            if (samples++ == 0) {
+                mean_ms = sample;
+                return;
+            }
+            double diff = sample - mean_ms;
+            mean_ms += GAIN * diff;
+            variance_ms2 = (1.0 - GAIN) * (variance_ms2 + GAIN * diff * diff);
+        }
+
+        // stddev / mean of the inter-arrival time; 0 until there's enough history
+        double score() const {
+            if (samples < MIN_SAMPLES || mean_ms <= 0.0) {
+                return 0.0;
+            }
+            return std::sqrt(variance_ms2) / mean_ms;
+        }
     };
 
     struct NodeState {
         std::string name;
+        std::string tenant;
         std::string peer;
         int64_t last_seen_ms;
         NodeStatus status{NodeStatus::NOT_READY};
+        std::map<std::string, std::string> labels;
+        bool unschedulable{false};  // cordoned by an operator
+        Resources capacity;
+        HeartbeatJitter jitter;
 
         bool is_healthy() const {
             return status == NodeStatus::READY;
         }
 
+        // alive and schedulable, even if its heartbeats look shaky
+        bool is_alive() const {
+            return status == NodeStatus::READY || status == NodeStatus::DEGRADED;
+        }
+
+        bool is_degraded() const {
+            double threshold = status == NodeStatus::DEGRADED ? HeartbeatJitter::DEGRADED_EXIT
+                                                                : HeartbeatJitter::DEGRADED_ENTER;
+            return jitter.score() > threshold;
+        }
+
         bool is_suspect(int64_t current_time_ms, int64_t timeout_ms = 30000) const {
             return (current_time_ms - last_seen_ms) > timeout_ms;
         }
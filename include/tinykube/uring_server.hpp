@@ -0,0 +1,457 @@
+#pragma once
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "tinykube/heartbeat_frame.hpp"
+#include "tinykube/time.hpp"
+#include "tinykube/trace.hpp"
+
+namespace tinykube {
+    struct UringServerStats {
+        uint64_t frames{0};
+        uint64_t bad_frames{0};    // connections dropped for a malformed frame
+        uint64_t connections{0};   // accepted so far
+        uint64_t open{0};          // currently connected
+        uint64_t enters{0};        // io_uring_enter calls, the only syscall in the steady state
+        uint64_t completions{0};
+        uint64_t no_buffers{0};    // recvs that ran out of provided buffers and were re-armed
+        uint64_t accept_errors{0}; // failed accepts (EMFILE and friends), each followed by a pause
+    };
+
+    // Heartbeat listener for fixed-size frames over TCP or a unix socket,
+    // driven by one io_uring: a multishot accept, a multishot recv per
+    // connection reading into a provided buffer ring, and one
+    // io_uring_enter per batch of completions. Frames are parsed in place
+    // from the ring's buffers, which go straight back to the kernel, and each
+    // batch of completions reaches the sink as one array.
+    // Talks to the kernel through the raw syscalls; needs Linux 6.0+.
+    class UringHeartbeatServer {
+    public:
+        using FrameSink = std::function<void(const HeartbeatFrame* frames, size_t count, int64_t now_ms)>;
+
+        static constexpr unsigned RING_ENTRIES = 1024;
+        static constexpr int64_t ACCEPT_BACKOFF_MS = 100;  // after a failed accept, e.g. out of fds
+        static constexpr unsigned BUFFER_COUNT = 512;  // power of two
+        static constexpr unsigned BUFFER_SIZE = 32 * sizeof(HeartbeatFrame);  // one page
+        static constexpr uint16_t BUFFER_GROUP = 0;
+
+        explicit UringHeartbeatServer(FrameSink sink) : sink_(std::move(sink)) {}
+
+        ~UringHeartbeatServer() {
+            stop();
+        }
+
+        UringHeartbeatServer(const UringHeartbeatServer&) = delete;
+        UringHeartbeatServer& operator=(const UringHeartbeatServer&) = delete;
+
+        bool start(const std::string& address, std::string& error) {
+            listen_fd_ = open_frame_socket(address, true, error);
+            if (listen_fd_ < 0 || !setup_ring(error) || !setup_buffers(error)) {
+                release();
+                return false;
+            }
+            wake_fd_ = ::eventfd(0, EFD_CLOEXEC);
+            if (wake_fd_ < 0) {
+                error = std::string("eventfd: ") + std::strerror(errno);
+                release();
+                return false;
+            }
+            batch_.reserve(BUFFER_COUNT);
+            arm_accept();
+            arm_wake();
+            thread_ = std::thread([this] { run(); });
+            return true;
+        }
+
+        void stop() {
+            if (!thread_.joinable()) {
+                return;
+            }
+            uint64_t one = 1;
+            ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+            (void)written;
+            thread_.join();
+            release();
+        }
+
+        UringServerStats stats() const {
+            UringServerStats stats;
+            stats.frames = frames_.load(std::memory_order_relaxed);
+            stats.bad_frames = bad_frames_.load(std::memory_order_relaxed);
+            stats.connections = accepted_.load(std::memory_order_relaxed);
+            stats.open = open_.load(std::memory_order_relaxed);
+            stats.enters = enters_.load(std::memory_order_relaxed);
+            stats.completions = completions_.load(std::memory_order_relaxed);
+            stats.no_buffers = no_buffers_.load(std::memory_order_relaxed);
+            stats.accept_errors = accept_errors_.load(std::memory_order_relaxed);
+            return stats;
+        }
+    private:
+        enum Op : uint64_t { ACCEPT = 1, RECV = 2, WAKE = 3, ACCEPT_RETRY = 4 };
+
+        // a frame split across two recvs is reassembled here
+        struct Connection {
+            HeartbeatFrame partial;
+            size_t partial_len{0};
+            bool closing{false};  // shut down for a bad frame; completions already queued are ignored
+        };
+
+        static uint64_t user_data(Op op, int fd) {
+            return op << 32 | static_cast<uint32_t>(fd);
+        }
+
+        bool setup_ring(std::string& error) {
+            io_uring_params params{};
+            params.flags = IORING_SETUP_COOP_TASKRUN;
+            ring_fd_ = static_cast<int>(::syscall(SYS_io_uring_setup, RING_ENTRIES, &params));
+            if (ring_fd_ < 0 && errno == EINVAL) {
+                params = io_uring_params{};  // kernels before 5.19
+                ring_fd_ = static_cast<int>(::syscall(SYS_io_uring_setup, RING_ENTRIES, &params));
+            }
+            if (ring_fd_ < 0) {
+                error = std::string("io_uring_setup: ") + std::strerror(errno);
+                return false;
+            }
+            if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+                error = "io_uring without IORING_FEAT_SINGLE_MMAP is not supported";
+                return false;
+            }
+
+            ring_size_ = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                                  params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+            ring_ = ::mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                           IORING_OFF_SQ_RING);
+            sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+            void* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                                IORING_OFF_SQES);
+            if (ring_ == MAP_FAILED || sqes == MAP_FAILED) {
+                error = std::string("io_uring mmap: ") + std::strerror(errno);
+                ring_ = ring_ == MAP_FAILED ? nullptr : ring_;
+                sqes_ = sqes == MAP_FAILED ? nullptr : static_cast<io_uring_sqe*>(sqes);
+                return false;
+            }
+            sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+            auto* base = static_cast<char*>(ring_);
+            sq_head_ = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+            sq_tail_ = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+            sq_mask_ = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+            sq_entries_ = params.sq_entries;
+            auto* array = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+            for (unsigned i = 0; i < sq_entries_; i++) {
+                array[i] = i;  // slot i always holds sqe i
+            }
+            cq_head_ = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+            cq_tail_ = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+            cq_mask_ = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+            cqes_ = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+            local_sq_tail_ = *sq_tail_;
+            return true;
+        }
+
+        bool setup_buffers(std::string& error) {
+            buffer_ring_size_ = BUFFER_COUNT * sizeof(io_uring_buf);
+            void* ring = ::mmap(nullptr, buffer_ring_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            void* buffers = ::mmap(nullptr, BUFFER_COUNT * BUFFER_SIZE, PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+            buffer_ring_ = ring == MAP_FAILED ? nullptr : static_cast<io_uring_buf*>(ring);
+            buffers_ = buffers == MAP_FAILED ? nullptr : static_cast<char*>(buffers);
+            if (buffer_ring_ == nullptr || buffers_ == nullptr) {
+                error = std::string("buffer mmap: ") + std::strerror(errno);
+                return false;
+            }
+
+            io_uring_buf_reg reg{};
+            reg.ring_addr = reinterpret_cast<uint64_t>(buffer_ring_);
+            reg.ring_entries = BUFFER_COUNT;
+            reg.bgid = BUFFER_GROUP;
+            if (::syscall(SYS_io_uring_register, ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+                error = std::string("provided buffer ring: ") + std::strerror(errno);
+                return false;
+            }
+            // the ring's tail lives in the first entry's reserved field
+            buffer_tail_ = &buffer_ring_[0].resv;
+            for (uint16_t id = 0; id < BUFFER_COUNT; id++) {
+                recycle(id);
+            }
+            publish_buffers();
+            return true;
+        }
+
+        void release() {
+            for (auto& [fd, connection] : peers_) {
+                ::close(fd);
+            }
+            peers_.clear();
+            open_.store(0, std::memory_order_relaxed);
+            for (int* fd : {&wake_fd_, &listen_fd_, &ring_fd_}) {
+                if (*fd >= 0) {
+                    ::close(*fd);
+                    *fd = -1;
+                }
+            }
+            if (ring_ != nullptr) {
+                ::munmap(ring_, ring_size_);
+                ring_ = nullptr;
+            }
+            if (sqes_ != nullptr) {
+                ::munmap(sqes_, sqes_size_);
+                sqes_ = nullptr;
+            }
+            if (buffer_ring_ != nullptr) {
+                ::munmap(buffer_ring_, buffer_ring_size_);
+                buffer_ring_ = nullptr;
+            }
+            if (buffers_ != nullptr) {
+                ::munmap(buffers_, BUFFER_COUNT * BUFFER_SIZE);
+                buffers_ = nullptr;
+            }
+        }
+
+        io_uring_sqe* next_sqe() {
+            unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+            if (local_sq_tail_ - head >= sq_entries_) {
+                enter(0);  // full: hand what we have to the kernel first
+            }
+            io_uring_sqe* sqe = &sqes_[local_sq_tail_ & sq_mask_];
+            std::memset(sqe, 0, sizeof(*sqe));
+            local_sq_tail_++;
+            return sqe;
+        }
+
+        void arm_accept() {
+            io_uring_sqe* sqe = next_sqe();
+            sqe->opcode = IORING_OP_ACCEPT;
+            sqe->fd = listen_fd_;
+            sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+            sqe->accept_flags = SOCK_CLOEXEC;
+            sqe->user_data = user_data(ACCEPT, listen_fd_);
+        }
+
+        // a failed accept ends the multishot; re-arming at once would spin on
+        // EMFILE, so wait a little for fds to free up
+        void arm_accept_retry() {
+            io_uring_sqe* sqe = next_sqe();
+            sqe->opcode = IORING_OP_TIMEOUT;
+            sqe->addr = reinterpret_cast<uint64_t>(&accept_backoff_);
+            sqe->len = 1;
+            sqe->user_data = user_data(ACCEPT_RETRY, listen_fd_);
+        }
+
+        void arm_recv(int fd) {
+            io_uring_sqe* sqe = next_sqe();
+            sqe->opcode = IORING_OP_RECV;
+            sqe->fd = fd;
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = BUFFER_GROUP;
+            sqe->user_data = user_data(RECV, fd);
+        }
+
+        void arm_wake() {
+            io_uring_sqe* sqe = next_sqe();
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = wake_fd_;
+            sqe->addr = reinterpret_cast<uint64_t>(&wake_value_);
+            sqe->len = sizeof(wake_value_);
+            sqe->user_data = user_data(WAKE, wake_fd_);
+        }
+
+        // submits everything queued and, with wait set, blocks for a completion
+        void enter(unsigned wait) {
+            unsigned submit = local_sq_tail_ - *sq_tail_;
+            __atomic_store_n(sq_tail_, local_sq_tail_, __ATOMIC_RELEASE);
+            enters_.fetch_add(1, std::memory_order_relaxed);
+            ::syscall(SYS_io_uring_enter, ring_fd_, submit, wait, wait > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+        }
+
+        void recycle(uint16_t id) {
+            io_uring_buf& slot = buffer_ring_[buffer_tail_local_ & (BUFFER_COUNT - 1)];
+            slot.addr = reinterpret_cast<uint64_t>(buffers_ + static_cast<size_t>(id) * BUFFER_SIZE);
+            slot.len = BUFFER_SIZE;
+            slot.bid = id;
+            buffer_tail_local_++;
+        }
+
+        void publish_buffers() {
+            __atomic_store_n(buffer_tail_, buffer_tail_local_, __ATOMIC_RELEASE);
+        }
+
+        void run() {
+            bool running = true;
+            while (running) {
+                enter(1);
+                unsigned head = *cq_head_;
+                unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+                if (head == tail) {
+                    continue;  // EINTR
+                }
+                TK_TRACE_SPAN("uring.batch");
+                int64_t now = now_ms();
+                for (; head != tail; head++) {
+                    const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+                    running = handle(cqe) && running;
+                }
+                // frames were copied out of the buffers, so they can go back first
+                __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+                publish_buffers();
+                if (!batch_.empty()) {
+                    frames_.fetch_add(batch_.size(), std::memory_order_relaxed);
+                    sink_(batch_.data(), batch_.size(), now);
+                    batch_.clear();
+                }
+            }
+        }
+
+        // false once stop() has woken the loop
+        bool handle(const io_uring_cqe& cqe) {
+            auto op = static_cast<Op>(cqe.user_data >> 32);
+            int fd = static_cast<int>(cqe.user_data & 0xffffffff);
+            bool more = cqe.flags & IORING_CQE_F_MORE;
+            completions_.fetch_add(1, std::memory_order_relaxed);
+
+            if (op == WAKE) {
+                return false;
+            }
+            if (op == ACCEPT_RETRY) {
+                arm_accept();
+                return true;
+            }
+            if (op == ACCEPT) {
+                if (cqe.res >= 0) {
+                    peers_.emplace(cqe.res, Connection{});
+                    accepted_.fetch_add(1, std::memory_order_relaxed);
+                    open_.fetch_add(1, std::memory_order_relaxed);
+                    arm_recv(cqe.res);
+                } else {
+                    accept_errors_.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (!more) {
+                    if (cqe.res < 0) {
+                        arm_accept_retry();
+                    } else {
+                        arm_accept();
+                    }
+                }
+                return true;
+            }
+
+            if (cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER)) {
+                auto id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                auto it = peers_.find(fd);
+                if (it != peers_.end() && !it->second.closing &&
+                    !consume(it->second, buffers_ + static_cast<size_t>(id) * BUFFER_SIZE,
+                             static_cast<size_t>(cqe.res))) {
+                    bad_frames_.fetch_add(1, std::memory_order_relaxed);
+                    it->second.closing = true;
+                    ::shutdown(fd, SHUT_RDWR);  // the recv then ends with EOF and we close below
+                }
+                recycle(id);
+            }
+            if (!more) {
+                if (cqe.res == -ENOBUFS) {
+                    no_buffers_.fetch_add(1, std::memory_order_relaxed);
+                    arm_recv(fd);
+                } else if (cqe.res > 0) {
+                    arm_recv(fd);  // the kernel may end a multishot recv at any time
+                } else {
+                    peers_.erase(fd);
+                    open_.fetch_sub(1, std::memory_order_relaxed);
+                    ::close(fd);
+                }
+            }
+            return true;
+        }
+
+        // parses whole frames into batch_; false on a malformed one
+        bool consume(Connection& connection, const char* data, size_t length) {
+            if (connection.partial_len > 0) {
+                size_t take = std::min(length, sizeof(HeartbeatFrame) - connection.partial_len);
+                std::memcpy(reinterpret_cast<char*>(&connection.partial) + connection.partial_len, data, take);
+                connection.partial_len += take;
+                data += take;
+                length -= take;
+                if (connection.partial_len < sizeof(HeartbeatFrame)) {
+                    return true;
+                }
+                connection.partial_len = 0;
+                if (!deliver(connection.partial)) {
+                    return false;
+                }
+            }
+            for (; length >= sizeof(HeartbeatFrame); data += sizeof(HeartbeatFrame), length -= sizeof(HeartbeatFrame)) {
+                // frames after a partial one are unaligned; the copy compiles to plain loads
+                HeartbeatFrame frame;
+                std::memcpy(&frame, data, sizeof(frame));
+                if (!deliver(frame)) {
+                    return false;
+                }
+            }
+            std::memcpy(&connection.partial, data, length);
+            connection.partial_len = length;
+            return true;
+        }
+
+        bool deliver(const HeartbeatFrame& frame) {
+            if (!frame.valid()) {
+                return false;
+            }
+            batch_.push_back(frame);
+            return true;
+        }
+
+        FrameSink sink_;
+        std::vector<HeartbeatFrame> batch_;  // frames from one batch of completions
+        __kernel_timespec accept_backoff_{0, ACCEPT_BACKOFF_MS * 1000000};  // read by the kernel, so it stays put
+        int listen_fd_{-1};
+        int ring_fd_{-1};
+        int wake_fd_{-1};
+        uint64_t wake_value_{0};
+
+        void* ring_{nullptr};
+        size_t ring_size_{0};
+        io_uring_sqe* sqes_{nullptr};
+        size_t sqes_size_{0};
+        unsigned* sq_head_{nullptr};
+        unsigned* sq_tail_{nullptr};
+        unsigned sq_mask_{0};
+        unsigned sq_entries_{0};
+        unsigned local_sq_tail_{0};
+        unsigned* cq_head_{nullptr};
+        unsigned* cq_tail_{nullptr};
+        unsigned cq_mask_{0};
+        io_uring_cqe* cqes_{nullptr};
+
+        io_uring_buf* buffer_ring_{nullptr};
+        size_t buffer_ring_size_{0};
+        uint16_t* buffer_tail_{nullptr};
+        uint16_t buffer_tail_local_{0};
+        char* buffers_{nullptr};
+
+        std::unordered_map<int, Connection> peers_;
+        std::atomic<uint64_t> frames_{0};
+        std::atomic<uint64_t> bad_frames_{0};
+        std::atomic<uint64_t> accepted_{0};
+        std::atomic<uint64_t> open_{0};
+        std::atomic<uint64_t> enters_{0};
+        std::atomic<uint64_t> completions_{0};
+        std::atomic<uint64_t> no_buffers_{0};
+        std::atomic<uint64_t> accept_errors_{0};
+        std::thread thread_;
+    };
+} // namespace tinykube
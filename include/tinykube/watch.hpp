@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "tinykube/types.hpp"
+
+namespace tinykube {
+    // one registry transaction: every node it changed and every node it removed,
+    // stamped with the revision the transaction produced
+    struct WatchEvent {
+        uint64_t revision{0};
+        std::string tenant;
+        std::vector<NodeState> nodes;
+        std::vector<std::string> removed;
+    };
+
+    // Fan-out point for registry changes. Keeps a bounded history so a watcher
+    // that falls behind can catch up from its last revision, or is told to resync
+    // once that revision has been dropped.
+    class WatchHub {
+    public:
+        explicit WatchHub(size_t history_limit = 1024) : history_limit_(history_limit) {}
+
+        // callers publish while holding their own registry lock so revisions are
+        // handed out in the same order the mutations were applied
+        uint64_t publish(const std::string& tenant, std::vector<NodeState> nodes,
+                         std::vector<std::string> removed = {}) {
+            auto event = std::make_shared<WatchEvent>();
+            event->tenant = tenant;
+            event->nodes = std::move(nodes);
+            event->removed = std::move(removed);
+            uint64_t revision;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                revision = event->revision = revision_.load(std::memory_order_relaxed) + 1;
+                history_.push_back(std::move(event));
+                if (history_.size() > history_limit_) {
+                    history_.pop_front();
+                }
+                revision_.store(revision, std::memory_order_release);
+            }
+            cv_.notify_all();
+            return revision;
+        }
+
+        uint64_t revision() const {
+            return revision_.load(std::memory_order_acquire);
+        }
+
+        // Collects every retained event newer than `since`, waiting up to `timeout`
+        // for one to show up. Returns false with `resync` set if `since` is older
+        // than the retained history; the caller must then take a fresh snapshot.
+        bool wait_events(uint64_t since, std::vector<std::shared_ptr<const WatchEvent>>& out,
+                         std::chrono::milliseconds timeout, bool& resync) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            resync = false;
+            cv_.wait_for(lock, timeout, [&] { return closed_ || revision_.load(std::memory_order_relaxed) > since; });
+            if (revision_.load(std::memory_order_relaxed) <= since) {
+                return false;
+            }
+            if (history_.empty() || history_.front()->revision > since + 1) {
+                resync = true;
+                return false;
+            }
+            for (const auto& event : history_) {
+                if (event->revision > since) {
+                    out.push_back(event);
+                }
+            }
+            return !out.empty();
+        }
+
+        // wakes every waiter, used on shutdown
+        void close() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                closed_ = true;
+            }
+            cv_.notify_all();
+        }
+
+        bool closed() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return closed_;
+        }
+    private:
+        size_t history_limit_;
+        std::atomic<uint64_t> revision_{0};
+        std::deque<std::shared_ptr<const WatchEvent>> history_;
+        bool closed_{false};
+        mutable std::mutex mutex_;
+        std::condition_variable cv_;
+    };
+} // namespace tinykube
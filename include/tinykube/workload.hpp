@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace tinykube {
+    struct Resources {
+        int64_t cpu_millis{0};
+        int64_t memory_mb{0};
+
+        bool fits_in(const Resources& free) const {
+            return cpu_millis <= free.cpu_millis && memory_mb <= free.memory_mb;
+        }
+
+        Resources& operator+=(const Resources& other) {
+            cpu_millis += other.cpu_millis;
+            memory_mb += other.memory_mb;
+            return *this;
+        }
+
+        Resources& operator-=(const Resources& other) {
+            cpu_millis -= other.cpu_millis;
+            memory_mb -= other.memory_mb;
+            return *this;
+        }
+
+        friend Resources operator-(Resources lhs, const Resources& rhs) {
+            return lhs -= rhs;
+        }
+    };
+
+    // what one tenant may have submitted and not yet completed, pending or running
+    struct WorkloadLimits {
+        size_t max_workloads{10000};
+        Resources max_requested{INT64_MAX, INT64_MAX};
+    };
+
+    enum class WorkloadPhase : uint8_t {
+        PENDING = 0,
+        RUNNING = 1,
+        SUCCEEDED = 2
+    };
+
+    struct Workload {
+        std::string name;
+        std::string tenant;
+        Resources request;
+        std::string node;  // set once bound
+        WorkloadPhase phase{WorkloadPhase::PENDING};
+        int64_t submitted_ms{0};
+    };
+} // namespace tinykube
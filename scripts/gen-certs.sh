@@ -0,0 +1,45 @@
+#!/usr/bin/env bash
+# Local test PKI for mutual TLS between tinykube_control, agents and tinykubectl.
+#
+#   scripts/gen-certs.sh [out-dir] [extra server SAN, e.g. DNS:cp.example or IP:10.0.0.5]
+#
+# Writes ca.pem, server.pem/server.key and client.pem/client.key. ECDSA P-256
+# keeps handshakes cheap; the CA key stays next to them, so this is for tests
+# and labs, not production.
+set -euo pipefail
+
+out="${1:-certs}"
+extra_san="${2:-}"
+days=825
+mkdir -p "$out"
+cd "$out"
+
+key() {
+    openssl genpkey -algorithm EC -pkeyopt ec_paramgen_curve:P-256 -out "$1" 2>/dev/null
+    chmod 600 "$1"
+}
+
+key ca.key
+openssl req -x509 -new -key ca.key -sha256 -days "$days" -subj "/CN=tinykube test CA" \
+    -addext "basicConstraints=critical,CA:TRUE" -addext "keyUsage=critical,keyCertSign,cRLSign" -out ca.pem
+
+san="DNS:localhost,IP:127.0.0.1,IP:::1"
+[ -n "$extra_san" ] && san="$san,$extra_san"
+
+issue() {
+    local name="$1" cn="$2" usage="$3" alt="$4"
+    key "$name.key"
+    openssl req -new -key "$name.key" -subj "/CN=$cn" -out "$name.csr"
+    printf 'basicConstraints=CA:FALSE\nkeyUsage=critical,digitalSignature\nextendedKeyUsage=%s\n%s' \
+        "$usage" "${alt:+subjectAltName=$alt}" > "$name.ext"
+    openssl x509 -req -in "$name.csr" -CA ca.pem -CAkey ca.key -CAcreateserial -sha256 -days "$days" \
+        -extfile "$name.ext" -out "$name.pem" 2>/dev/null
+    rm -f "$name.csr" "$name.ext"
+}
+
+issue server "tinykube-control" serverAuth "$san"
+issue client "tinykube-agent" clientAuth ""
+
+echo "🔐 Wrote CA, server and client certificates to $(pwd)"
+echo "   tinykube_control --tls-ca ca.pem --tls-cert server.pem --tls-key server.key"
+echo "   tinykube_agent   --tls-ca ca.pem --tls-cert client.pem --tls-key client.key -n worker-1"
@@ -5,39 +5,79 @@
 #include <chrono>
 #include <atomic>
 #include <csignal>
+#include <fstream>
+#include <unistd.h>
 #include <grpcpp/grpcpp.h>
 #include "control_plane.grpc.pb.h"
 #include "control_plane.pb.h"
 
+#include "tinykube/cpu_profiler.hpp"
+#include "tinykube/heartbeat_frame.hpp"
+#include "tinykube/node_auth.hpp"
+#include "tinykube/shm_channel.hpp"
+#include "tinykube/tls.hpp"
+
 using grpc::Channel;
 using grpc::ClientContext;
 using grpc::ClientWriter;
 using grpc::Status;
 
+// Signal handlers only flip these lock-free flags; the main thread polls them
+// and does the logging and the work, which a handler may not.
 std::atomic<bool> g_running{true};
+std::atomic<bool> g_profile_requested{false};
+std::atomic<int> g_stop_signal{0};
+static_assert(std::atomic<bool>::is_always_lock_free && std::atomic<int>::is_always_lock_free);
 
-std::mutex shutdown_mutex;
-std::condition_variable shutdown_cv;
+const auto SIGNAL_POLL_INTERVAL = std::chrono::milliseconds(100);
 
 void signal_handler(int signal) {
-    std::cout << "\n🛑 Received signal " << signal << ", shutting down gracefully..." << std::endl;
+    g_stop_signal.store(signal, std::memory_order_relaxed);
     g_running.store(false, std::memory_order_relaxed);
-    
-    shutdown_cv.notify_all();
+}
+
+void profile_signal_handler(int) {
+    g_profile_requested.store(true, std::memory_order_relaxed);
+}
+
+// SIGUSR2: sample this agent's CPU for 10s and write a pprof file next to it
+void write_cpu_profile(const std::string& node_name) {
+    std::string path = "tinykube-agent-" + node_name + "-" + std::to_string(::getpid()) + ".pprof";
+    std::cout << "🔥 Profiling CPU for 10s into " << path << std::endl;
+
+    std::string pprof, reason;
+    if (!tinykube::CpuProfiler::instance().profile(10, 99, pprof, reason)) {
+        std::cout << "❌ Profile failed: " << reason << std::endl;
+        return;
+    }
+    std::ofstream out(path, std::ios::binary);
+    out << pprof;
+    std::cout << "💾 Wrote CPU profile " << path << " (go tool pprof tinykube_agent " << path << ")" << std::endl;
 }
 
 class TinyKubeAgent {
 private:
     std::unique_ptr<tinykube::ControlPlane::Stub> stub_;
     std::string node_name_;
+    std::string tenant_;
+    std::string frames_address_;
+    std::string bootstrap_token_;
+    std::string session_token_;
+    int64_t renew_at_ms_{0};  // re-register for a fresh session token after this
 
 public:
-    TinyKubeAgent(std::shared_ptr<Channel> channel, const std::string& node_name)
-        : stub_(tinykube::ControlPlane::NewStub(channel)), node_name_(node_name) {}
+    TinyKubeAgent(std::shared_ptr<Channel> channel, const std::string& node_name, const std::string& tenant,
+                  const std::string& frames_address = "", const std::string& bootstrap_token = "")
+        : stub_(tinykube::ControlPlane::NewStub(channel)), node_name_(node_name), tenant_(tenant),
+          frames_address_(frames_address), bootstrap_token_(bootstrap_token) {}
 
     bool RegisterWithControlPlane() {
         tinykube::RegisterRequest request;
         request.mutable_node()->set_name(node_name_);
+        request.mutable_node()->set_tenant(tenant_);
+        request.mutable_node()->set_cpu_millis(static_cast<int64_t>(std::thread::hardware_concurrency()) * 1000);
+        request.mutable_node()->set_memory_mb(sysconf(_SC_PHYS_PAGES) / 1024 * sysconf(_SC_PAGE_SIZE) / 1024);
+        request.set_bootstrap_token(bootstrap_token_);
         
         tinykube::RegisterResponse response;
         ClientContext context;
@@ -49,6 +89,12 @@ public:
         if (status.ok()) {
             if (response.accepted()) {
                 std::cout << "✅ Registration successful: " << response.reason() << std::endl;
+                session_token_ = response.session_token();
+                if (!session_token_.empty()) {
+                    // halfway to expiry by our clock, so skew can't outrun it
+                    int64_t now = tinykube::now_ms();
+                    renew_at_ms_ = now + (response.session_expires_unix_ms() - now) / 2;
+                }
                 return true;
             } else {
                 std::cout << "❌ Registration rejected: " << response.reason() << std::endl;
@@ -61,18 +107,45 @@ public:
     }
 
     void StartHeartbeats() {
+        if (!frames_address_.empty()) {
+            StartFrameHeartbeats();
+            return;
+        }
+        int heartbeat_count = 0;
+        while (g_running.load(std::memory_order_relaxed)) {
+            bool renew = StreamHeartbeats(heartbeat_count);
+            if (!renew || !g_running.load(std::memory_order_relaxed)) {
+                break;
+            }
+            std::cout << "🔑 Renewing session token..." << std::endl;
+            if (!RegisterWithControlPlane()) {
+                break;
+            }
+        }
+    }
+
+    // one stream until shutdown, a lost connection or (true) the session token is due for renewal
+    bool StreamHeartbeats(int& heartbeat_count) {
         std::cout << "💓 Starting heartbeat stream..." << std::endl;
 
         ClientContext context;
+        if (!session_token_.empty()) {
+            context.AddMetadata(tinykube::SESSION_METADATA_KEY, session_token_);
+        }
         tinykube::Empty response;
         
         std::unique_ptr<ClientWriter<tinykube::Heartbeat>> writer(
             stub_->StreamHeartbeats(&context, &response));
 
-        int heartbeat_count = 0;
+        bool renew = false;
         while (g_running.load(std::memory_order_relaxed)) {
+            if (!session_token_.empty() && tinykube::now_ms() >= renew_at_ms_) {
+                renew = true;
+                break;
+            }
             tinykube::Heartbeat heartbeat;
             heartbeat.set_node_name(node_name_);
+            heartbeat.set_tenant(tenant_);
             
             auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
                 std::chrono::system_clock::now().time_since_epoch()).count();
@@ -89,7 +162,9 @@ public:
             std::this_thread::sleep_for(std::chrono::seconds(1));
         }
 
-        std::cout << "🛑 Stopping heartbeats..." << std::endl;
+        if (!renew) {
+            std::cout << "🛑 Stopping heartbeats..." << std::endl;
+        }
         writer->WritesDone();
         Status status = writer->Finish();
         
@@ -98,6 +173,49 @@ public:
         } else {
             std::cout << "❌ Heartbeat stream failed: " << status.error_message() << std::endl;
         }
+        return renew && status.ok();
+    }
+
+    // same cadence, as fixed-size frames on a plain socket instead of a gRPC
+    // stream, or through a shared-memory ring for "shm:<socket path>"
+    void StartFrameHeartbeats() {
+        std::cout << "💓 Sending heartbeat frames to " << frames_address_ << "..." << std::endl;
+
+        std::string error;
+        tinykube::ShmHeartbeatProducer shm;
+        bool shared = frames_address_.rfind("shm:", 0) == 0;
+        int fd = -1;
+        bool connected = shared ? shm.connect(frames_address_.substr(4), error)
+                                : (fd = tinykube::open_frame_socket(frames_address_, false, error)) >= 0;
+        if (!connected) {
+            std::cout << "❌ Could not connect to " << frames_address_ << ": " << error << std::endl;
+            return;
+        }
+
+        int heartbeat_count = 0;
+        while (g_running.load(std::memory_order_relaxed)) {
+            auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            tinykube::HeartbeatFrame frame;
+            if (!tinykube::make_frame(tenant_, node_name_, now, frame)) {
+                std::cout << "❌ Node or tenant name too long for a heartbeat frame" << std::endl;
+                break;
+            }
+            if (!(shared ? shm.push_all(&frame, 1) : tinykube::send_frames(fd, &frame, 1))) {
+                std::cout << "💔 Failed to send heartbeat, connection lost" << std::endl;
+                break;
+            }
+
+            heartbeat_count++;
+            std::cout << "💗 Sent heartbeat #" << heartbeat_count << " at " << now << "ms" << std::endl;
+
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        std::cout << "🛑 Stopped heartbeat frames (" << heartbeat_count << " sent)" << std::endl;
     }
 };
 
@@ -107,7 +225,16 @@ void print_usage(const char* program_name) {
     std::cout << "\nOptions:" << std::endl;
     std::cout << "  -n, --node-name <name>    Node name for registration (required)" << std::endl;
     std::cout << "  -s, --server <address>    Control plane server address (default: localhost:50051)" << std::endl;
+    std::cout << "  -t, --tenant <name>       Tenant the node belongs to (default: default)" << std::endl;
+    std::cout << "  -f, --frames <address>    Send heartbeats as frames to the control plane's --frames listener," << std::endl;
+    std::cout << "                            or through its --shm rings with shm:<socket path>" << std::endl;
+    std::cout << "  -k, --token-file <file>   Bootstrap token for this node (tinykubectl token), if the control plane requires one" << std::endl;
+    std::cout << "  --tls-ca <file>           Dial with mutual TLS, trusting this CA" << std::endl;
+    std::cout << "  --tls-cert <file>         Client certificate (see scripts/gen-certs.sh)" << std::endl;
+    std::cout << "  --tls-key <file>          Client private key" << std::endl;
+    std::cout << "  --tls-server-name <name>  Name to expect in the server certificate (default: the dialed host)" << std::endl;
     std::cout << "  -h, --help                Show this help message" << std::endl;
+    std::cout << "\nSend SIGUSR2 to write a 10s CPU profile (pprof format) to the working directory." << std::endl;
     std::cout << "\nExamples:" << std::endl;
     std::cout << "  " << program_name << " --node-name worker-1" << std::endl;
     std::cout << "  " << program_name << " -n worker-2 -s 192.168.1.100:50051" << std::endl;
@@ -117,6 +244,10 @@ void print_usage(const char* program_name) {
 int main(int argc, char* argv[]) {
     std::string server_address("localhost:50051");
     std::string node_name;
+    std::string tenant;
+    std::string frames_address;
+    tinykube::TlsFiles tls;
+    std::string bootstrap_token;
 
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -144,6 +275,42 @@ int main(int argc, char* argv[]) {
                 return 1;
             }
         }
+        else if (arg == "-t" || arg == "--tenant") {
+            if (i + 1 < argc) {
+                tenant = argv[++i];
+            } else {
+                std::cerr << "❌ Error: --tenant requires a value" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "-f" || arg == "--frames") {
+            if (i + 1 < argc) {
+                frames_address = argv[++i];
+            } else {
+                std::cerr << "❌ Error: --frames requires a value" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "-k" || arg == "--token-file") {
+            std::ifstream token_file(i + 1 < argc ? argv[++i] : "");
+            if (!token_file || !std::getline(token_file, bootstrap_token) || bootstrap_token.empty()) {
+                std::cerr << "❌ Error: --token-file requires a readable file" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--tls-ca" || arg == "--tls-cert" || arg == "--tls-key" || arg == "--tls-server-name") {
+            if (i + 1 < argc) {
+                (arg == "--tls-ca" ? tls.ca : arg == "--tls-cert" ? tls.cert
+                                     : arg == "--tls-key" ? tls.key : tls.server_name) = argv[++i];
+            } else {
+                std::cerr << "❌ Error: " << arg << " requires a value" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
         else {
             std::cerr << "❌ Error: Unknown argument '" << arg << "'" << std::endl;
             print_usage(argv[0]);
@@ -164,9 +331,16 @@ int main(int argc, char* argv[]) {
 
     std::signal(SIGINT, signal_handler);
     std::signal(SIGTERM, signal_handler);
+    std::signal(SIGUSR2, profile_signal_handler);
 
-    auto channel = grpc::CreateChannel(server_address, grpc::InsecureChannelCredentials());
-    TinyKubeAgent agent(channel, node_name);
+    // reconnects after a control plane blip resume the TLS session
+    std::string tls_error;
+    auto channel = tinykube::create_channel(server_address, tls, grpc::ChannelArguments(), tls_error);
+    if (!channel) {
+        std::cerr << "❌ Error: " << tls_error << std::endl;
+        return 1;
+    }
+    TinyKubeAgent agent(channel, node_name, tenant, frames_address, bootstrap_token);
 
     if (agent.RegisterWithControlPlane()) {
         std::cout << "🎉 Agent registered successfully, starting heartbeats..." << std::endl;
@@ -175,10 +349,13 @@ int main(int argc, char* argv[]) {
             agent.StartHeartbeats();
         });
 
-        std::unique_lock<std::mutex> lock(shutdown_mutex);
-        shutdown_cv.wait(lock, []() {
-            return !g_running.load(std::memory_order_relaxed);
-        });
+        while (g_running.load(std::memory_order_relaxed)) {
+            std::this_thread::sleep_for(SIGNAL_POLL_INTERVAL);
+            if (g_profile_requested.exchange(false)) {
+                std::thread(write_cpu_profile, node_name).detach();
+            }
+        }
+        std::cout << "\n🛑 Received signal " << g_stop_signal.load() << ", shutting down gracefully..." << std::endl;
 
         std::cout << "🛑 Waiting for heartbeat thread to finish..." << std::endl;
         heartbeat_thread.join();
@@ -0,0 +1,211 @@
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+
+#include "control/service.hpp"
+#include "tinykube/node_auth.hpp"
+
+// Node authentication benchmark:
+//   tokens   per-operation cost of the HMAC checks, and of a heartbeat's
+//            check against the stream's verified-token cache versus
+//            re-verifying its session token every time
+//   storm    N agents registering at once over real gRPC (in-process
+//            transport), with and without --auth-key; reports throughput and
+//            process CPU per registration, so the difference is what
+//            bootstrap verification plus session issuing costs
+
+using grpc::ClientContext;
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    size_t nodes{10000};
+    size_t streams{16};
+    size_t iterations{200000};
+};
+
+const std::string BENCH_KEY = "tinykube-bench-cluster-key-0123456789";
+
+std::string node_name(size_t index) {
+    return "bench-" + std::to_string(index);
+}
+
+template <typename Op>
+void time_op(const std::string& label, size_t iterations, Op op) {
+    size_t sink = 0;
+    auto start = Clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        sink += op(i) ? 1 : 0;
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(iterations);
+    std::cout << "  " << std::left << std::setw(36) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(9) << ns << " ns/op" << (sink == iterations ? "" : "  (some checks failed!)")
+              << std::defaultfloat << std::endl;
+}
+
+double cpu_us() {
+    rusage usage{};
+    ::getrusage(RUSAGE_SELF, &usage);
+    auto us = [](const timeval& tv) { return static_cast<double>(tv.tv_sec) * 1e6 + static_cast<double>(tv.tv_usec); };
+    return us(usage.ru_utime) + us(usage.ru_stime);
+}
+
+void bench_tokens(const BenchConfig& config) {
+    tinykube::NodeAuthority authority(BENCH_KEY);
+    int64_t now = tinykube::now_ms();
+    std::vector<std::string> bootstrap, sessions;
+    for (size_t i = 0; i < config.nodes; i++) {
+        int64_t expires = 0;
+        bootstrap.push_back(authority.bootstrap_token("", node_name(i)));
+        sessions.push_back(authority.issue_session("", node_name(i), now, expires));
+    }
+    std::vector<std::string> names;
+    for (size_t i = 0; i < config.nodes; i++) {
+        names.push_back(node_name(i));
+    }
+
+    std::cout << "🔑 Token checks (" << config.iterations << " iterations over " << config.nodes << " nodes)"
+              << std::endl;
+    time_op("bootstrap verify (RegisterNode)", config.iterations, [&](size_t i) {
+        size_t n = i % config.nodes;
+        return authority.check_bootstrap("", names[n], bootstrap[n]);
+    });
+    time_op("session issue (RegisterNode)", config.iterations, [&](size_t i) {
+        int64_t expires = 0;
+        return !authority.issue_session("", names[i % config.nodes], now, expires).empty();
+    });
+    time_op("session verify (stream setup)", config.iterations, [&](size_t i) {
+        tinykube::SessionClaim claim;
+        return authority.check_session(sessions[i % config.nodes], now, claim);
+    });
+
+    // an agent's stream: one node, every heartbeat
+    tinykube::StreamAuth single;
+    tinykube::SessionClaim claim;
+    authority.check_session(sessions[0], now, claim);
+    single.add(claim);
+    time_op("heartbeat, cached (one node)", config.iterations,
+            [&](size_t) { return single.allows("", names[0], now); });
+
+    // a relay's stream: every node interleaved, so no hits on the last node
+    tinykube::StreamAuth relay;
+    for (const auto& token : sessions) {
+        authority.check_session(token, now, claim);
+        relay.add(claim);
+    }
+    time_op("heartbeat, cached (all nodes)", config.iterations,
+            [&](size_t i) { return relay.allows("", names[i % config.nodes], now); });
+    time_op("heartbeat, re-verified every time", config.iterations, [&](size_t i) {
+        return authority.check_session(sessions[i % config.nodes], now, claim);
+    });
+}
+
+struct StormResult {
+    double seconds{0};
+    double cpu_us{0};
+    size_t accepted{0};
+};
+
+StormResult registration_storm(const BenchConfig& config, bool authenticated) {
+    ControlPlaneOptions options;
+    options.cron_journal_path.clear();
+    options.verbose = false;
+    if (authenticated) {
+        options.auth_key = BENCH_KEY;
+    }
+    ControlPlaneServiceImpl service(options);
+    tinykube::TenantQuota unlimited;
+    unlimited.max_nodes = config.nodes + 1;
+    unlimited.registrations_per_sec = unlimited.registration_burst = 1e9;
+    service.tenants().set_quota(tinykube::DEFAULT_TENANT, unlimited);
+
+    grpc::ServerBuilder builder;
+    builder.RegisterService(&service);
+    auto server = builder.BuildAndStart();
+    auto stub = tinykube::ControlPlane::NewStub(server->InProcessChannel(grpc::ChannelArguments()));
+
+    // tokens are minted up front, as an operator would before the storm
+    tinykube::NodeAuthority authority(BENCH_KEY);
+    std::vector<tinykube::RegisterRequest> requests(config.nodes);
+    for (size_t i = 0; i < config.nodes; i++) {
+        requests[i].mutable_node()->set_name(node_name(i));
+        if (authenticated) {
+            requests[i].set_bootstrap_token(authority.bootstrap_token("", node_name(i)));
+        }
+    }
+
+    StormResult result;
+    std::atomic<size_t> accepted{0};
+    double cpu_before = cpu_us();
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (size_t s = 0; s < config.streams; s++) {
+        threads.emplace_back([&, s] {
+            for (size_t i = s; i < config.nodes; i += config.streams) {
+                tinykube::RegisterResponse response;
+                ClientContext context;
+                if (stub->RegisterNode(&context, requests[i], &response).ok() && response.accepted() &&
+                    response.session_token().empty() != authenticated) {
+                    accepted.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.cpu_us = cpu_us() - cpu_before;
+    result.accepted = accepted.load();
+
+    service.shutdown();
+    server->Shutdown();
+    return result;
+}
+
+void print_storm(const std::string& label, const StormResult& result, size_t nodes) {
+    std::cout << "  " << std::left << std::setw(14) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(9) << static_cast<double>(result.accepted) / result.seconds / 1000.0 << "k registrations/s  "
+              << std::setw(7) << result.cpu_us / static_cast<double>(nodes) << " us CPU per registration  ("
+              << result.accepted << "/" << nodes << " accepted)" << std::defaultfloat << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help" || i + 1 >= argc) {
+            std::cout << "Usage: " << argv[0] << " [--nodes 10000] [--streams 16] [--iterations 200000]" << std::endl;
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--nodes") config.nodes = std::max<size_t>(1, std::stoul(value));
+        else if (arg == "--streams") config.streams = std::max<size_t>(1, std::stoul(value));
+        else if (arg == "--iterations") config.iterations = std::max<size_t>(1, std::stoul(value));
+        else {
+            std::cerr << "❌ Error: Unknown argument '" << arg << "'" << std::endl;
+            return 1;
+        }
+    }
+
+    bench_tokens(config);
+
+    std::cout << "\n🌩️ Registration storm: " << config.nodes << " agents over " << config.streams
+              << " concurrent callers" << std::endl;
+    auto open = registration_storm(config, false);
+    auto authenticated = registration_storm(config, true);
+    print_storm("no auth", open, config.nodes);
+    print_storm("--auth-key", authenticated, config.nodes);
+    std::cout << "  authentication adds " << std::fixed << std::setprecision(2)
+              << (authenticated.cpu_us - open.cpu_us) / static_cast<double>(config.nodes)
+              << " us CPU per registration" << std::defaultfloat << std::endl;
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "control_plane.pb.h"
+
+#include "tinykube/arrow_ipc.hpp"
+#include "tinykube/node_columns.hpp"
+#include "tinykube/node_record.hpp"
+#include "tinykube/tenant_registry.hpp"
+#include "tinykube/time.hpp"
+
+// Registry dump benchmark: the Arrow export path (columns straight from each
+// partition, one record batch per tenant) against the protobuf snapshot a
+// WatchNodes client gets (copy, to_record, serialize).
+
+double ms_since(std::chrono::steady_clock::time_point started) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+}
+
+void fill(tinykube::TenantRegistry& tenants, size_t count, size_t tenant_count) {
+    int64_t now = tinykube::now_ms();
+    for (size_t t = 0; t < tenant_count; t++) {
+        tinykube::TenantQuota quota;
+        quota.max_nodes = count;
+        tenants.set_quota("tenant-" + std::to_string(t), quota);
+    }
+    for (size_t i = 0; i < count; i++) {
+        tinykube::NodeState node;
+        node.tenant = "tenant-" + std::to_string(i % tenant_count);
+        node.name = "synthetic-node-" + std::to_string(i);
+        node.peer = "ipv4:10." + std::to_string(i >> 16 & 255) + "." + std::to_string(i >> 8 & 255) + "." +
+                    std::to_string(i & 255) + ":" + std::to_string(40000 + i % 20000);
+        node.status = i % 10 == 0 ? tinykube::NodeStatus::SUSPECT : tinykube::NodeStatus::READY;
+        node.last_seen_ms = now - static_cast<int64_t>(i % 5000);
+        node.capacity = tinykube::Resources{4000, 16384};
+        node.labels["zone"] = "zone-" + std::to_string(i % 3);
+        node.labels["rack"] = "r" + std::to_string(i % 64);
+        tenants.partition(node.tenant).nodes.upsert(node);
+    }
+}
+
+void run(size_t count, size_t tenant_count, const std::string& out_path) {
+    tinykube::TenantRegistry tenants;
+    fill(tenants, count, tenant_count);
+    int64_t now = tinykube::now_ms();
+
+    // Arrow: what ExportNodes does, into memory
+    std::string arrow;
+    arrow.reserve(count * 160);
+    auto export_arrow = [&](bool availability, double& columns_ms) {
+        arrow.clear();
+        columns_ms = 0;
+        auto started = std::chrono::steady_clock::now();
+        tinykube::NodeColumns columns(availability);
+        tinykube::ArrowFileWriter file([&](const char* data, size_t size) {
+            arrow.append(data, size);
+            return true;
+        });
+        file.begin(columns.columns);
+        tenants.for_each([&](tinykube::TenantPartition& partition) {
+            auto collected = std::chrono::steady_clock::now();
+            columns.clear();
+            tinykube::append_columns(partition.nodes, columns, now);
+            columns_ms += ms_since(collected);
+            file.write_batch(columns.columns);
+        });
+        file.finish();
+        return ms_since(started);
+    };
+    double slo_columns_ms = 0, columns_ms = 0;
+    double slo_arrow_ms = export_arrow(true, slo_columns_ms);
+    size_t slo_arrow_bytes = arrow.size();
+    double arrow_ms = export_arrow(false, columns_ms);
+
+    // protobuf: the WatchNodes snapshot event
+    auto started = std::chrono::steady_clock::now();
+    auto nodes = tenants.snapshot();
+    double snapshot_ms = ms_since(started);
+    tinykube::NodeEvent event;
+    for (const auto& node : nodes) {
+        tinykube::to_record(node, event.add_nodes());
+    }
+    event.set_snapshot(true);
+    std::string wire;
+    event.SerializeToString(&wire);
+    double proto_ms = ms_since(started);
+
+    std::cout << "\n📦 " << count << " nodes in " << tenant_count << " tenants" << std::fixed << std::setprecision(1)
+              << std::endl;
+    std::cout << "  arrow export:     " << std::setw(8) << arrow_ms << " ms  (" << columns_ms
+              << " ms under partition locks), " << arrow.size() / count << " B/node, "
+              << count / arrow_ms / 1000 << " M rows/s" << std::endl;
+    std::cout << "    + availability: " << std::setw(8) << slo_arrow_ms << " ms  (" << slo_columns_ms
+              << " ms under partition locks), " << slo_arrow_bytes / count << " B/node, "
+              << count / slo_arrow_ms / 1000 << " M rows/s" << std::endl;
+    std::cout << "  protobuf snapshot:" << std::setw(8) << proto_ms << " ms  (" << snapshot_ms
+              << " ms copying), " << wire.size() / count << " B/node, " << count / proto_ms / 1000 << " M rows/s"
+              << std::defaultfloat << std::endl;
+
+    if (!out_path.empty()) {
+        std::ofstream out(out_path, std::ios::binary);
+        out.write(arrow.data(), static_cast<std::streamsize>(arrow.size()));
+        std::cout << "  💾 wrote " << out_path << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<size_t> sizes{100000, 1000000};
+    size_t tenant_count = 4;
+    std::string out_path;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--tenants" && i + 1 < argc) {
+            tenant_count = std::max<size_t>(1, std::stoul(argv[++i]));
+        } else if (arg == "--out" && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (arg == "--sizes" && i + 1 < argc) {
+            sizes.clear();
+            std::istringstream list(argv[++i]);
+            std::string size;
+            while (std::getline(list, size, ',')) {
+                sizes.push_back(std::stoul(size));
+            }
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--sizes 100000,1000000] [--tenants 4] [--out last.arrow]"
+                      << std::endl;
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+
+    std::cout << "🏹 TinyKube registry export benchmark" << std::endl;
+    for (size_t size : sizes) {
+        if (size > 0) {
+            run(size, tenant_count, out_path);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,362 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+
+#include "control/service.hpp"
+
+// End-to-end failure detection benchmark: an in-process control plane, N
+// simulated agents heartbeating over real gRPC streams, a subset of which is
+// killed. Reports how long after each victim's last heartbeat the registry
+// marked it SUSPECT / NOT_READY and a watcher saw the change, plus false
+// positives among the survivors under optional CPU stress and network jitter.
+
+using grpc::ClientContext;
+using grpc::ClientReader;
+using grpc::ClientWriter;
+
+struct BenchConfig {
+    size_t nodes{1000};
+    size_t streams{16};
+    std::string pattern{"burst"};
+    double kill_fraction{0.1};
+    int64_t interval_ms{1000};
+    int64_t sweep_ms{5000};  // tinykube_control sweeps every 5s
+    int64_t warmup_ms{5000};
+    size_t cpu_stress{0};
+    int64_t jitter_ms{0};
+    double drop{0.0};
+    uint32_t seed{42};
+};
+
+// per node, all times are tinykube::now_ms(); -1 means "not yet"
+struct NodeTimes {
+    std::atomic<bool> victim{false};
+    std::atomic<int64_t> kill_at{-1};
+    std::atomic<int64_t> last_heartbeat{-1};
+    std::atomic<int64_t> suspect{-1};
+    std::atomic<int64_t> not_ready{-1};
+    std::atomic<int64_t> watch_suspect{-1};
+    std::atomic<int64_t> watch_not_ready{-1};
+    std::atomic<bool> false_positive{false};
+};
+
+std::string node_name(size_t index) {
+    return "bench-" + std::to_string(index);
+}
+
+void set_once(std::atomic<int64_t>& slot, int64_t value) {
+    int64_t unset = -1;
+    slot.compare_exchange_strong(unset, value);
+}
+
+void print_distribution(const std::string& label, std::vector<int64_t> values) {
+    std::cout << "  " << std::left << std::setw(34) << label << std::right;
+    if (values.empty()) {
+        std::cout << "no samples" << std::endl;
+        return;
+    }
+    std::sort(values.begin(), values.end());
+    auto at = [&](double q) { return values[static_cast<size_t>(q * static_cast<double>(values.size() - 1))]; };
+    std::cout << "n=" << std::setw(6) << values.size() << "  p50 " << std::setw(6) << at(0.50)
+              << "  p90 " << std::setw(6) << at(0.90) << "  p99 " << std::setw(6) << at(0.99)
+              << "  max " << std::setw(6) << values.back() << " ms" << std::endl;
+}
+
+void print_usage(const char* program_name) {
+    std::cout << "⏱️  TinyKube failure detection benchmark\n" << std::endl;
+    std::cout << "Usage: " << program_name << " [OPTIONS]" << std::endl;
+    std::cout << "\nOptions:" << std::endl;
+    std::cout << "  --nodes <n>          Simulated agents (default: 1000)" << std::endl;
+    std::cout << "  --streams <n>        Heartbeat streams / agent threads (default: 16)" << std::endl;
+    std::cout << "  --pattern <p>        burst | staggered | random (default: burst)" << std::endl;
+    std::cout << "  --kill <fraction>    Share of nodes to kill (default: 0.1)" << std::endl;
+    std::cout << "  --interval <ms>      Heartbeat interval (default: 1000)" << std::endl;
+    std::cout << "  --sweep <ms>         Health sweep period (default: 5000, as tinykube_control)" << std::endl;
+    std::cout << "  --warmup <ms>        Healthy run before killing (default: 5000)" << std::endl;
+    std::cout << "  --cpu-stress <n>     Busy-spinning threads competing for CPU (default: 0)" << std::endl;
+    std::cout << "  --jitter <ms>        Random extra delay per heartbeat (default: 0)" << std::endl;
+    std::cout << "  --drop <p>           Probability a heartbeat is lost (default: 0)" << std::endl;
+    std::cout << "  --seed <n>           Random seed (default: 42)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "❌ Error: Unknown or incomplete argument '" << arg << "'" << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+        try {
+            if (arg == "--nodes") config.nodes = std::stoul(value);
+            else if (arg == "--streams") config.streams = std::max<size_t>(1, std::stoul(value));
+            else if (arg == "--pattern") config.pattern = value;
+            else if (arg == "--kill") config.kill_fraction = std::stod(value);
+            else if (arg == "--interval") config.interval_ms = std::stoll(value);
+            else if (arg == "--sweep") config.sweep_ms = std::stoll(value);
+            else if (arg == "--warmup") config.warmup_ms = std::stoll(value);
+            else if (arg == "--cpu-stress") config.cpu_stress = std::stoul(value);
+            else if (arg == "--jitter") config.jitter_ms = std::stoll(value);
+            else if (arg == "--drop") config.drop = std::stod(value);
+            else if (arg == "--seed") config.seed = static_cast<uint32_t>(std::stoul(value));
+            else {
+                std::cerr << "❌ Error: Unknown argument '" << arg << "'" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "❌ Error: " << arg << " needs a number, got '" << value << "'" << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (config.pattern != "burst" && config.pattern != "staggered" && config.pattern != "random") {
+        std::cerr << "❌ Error: --pattern must be burst, staggered or random" << std::endl;
+        return 1;
+    }
+
+    ControlPlaneOptions options;
+    options.cron_journal_path.clear();
+    options.verbose = false;
+    ControlPlaneServiceImpl service(options);
+    tinykube::TenantQuota unlimited;
+    unlimited.max_nodes = config.nodes + 1;
+    unlimited.registrations_per_sec = unlimited.registration_burst = 1e9;
+    unlimited.heartbeats_per_sec = unlimited.heartbeat_burst = 1e9;
+    service.tenants().set_quota(tinykube::DEFAULT_TENANT, unlimited);
+
+    grpc::ServerBuilder builder;
+    builder.RegisterService(&service);
+    auto server = builder.BuildAndStart();
+    auto channel = server->InProcessChannel(grpc::ChannelArguments());
+    auto stub = tinykube::ControlPlane::NewStub(channel);
+
+    std::cout << "🧪 " << config.nodes << " nodes over " << config.streams << " streams, kill "
+              << config.kill_fraction * 100 << "% (" << config.pattern << "), heartbeat every "
+              << config.interval_ms << "ms, sweep every " << config.sweep_ms << "ms, suspect after "
+              << HEARTBEAT_TIMEOUT_MS << "ms, not ready after " << NOT_READY_TIMEOUT_MS << "ms" << std::endl;
+
+    for (size_t i = 0; i < config.nodes; i++) {
+        tinykube::RegisterRequest request;
+        request.mutable_node()->set_name(node_name(i));
+        tinykube::RegisterResponse response;
+        ClientContext context;
+        if (!stub->RegisterNode(&context, request, &response).ok() || !response.accepted()) {
+            std::cerr << "❌ Registration of " << node_name(i) << " failed: " << response.reason() << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<NodeTimes> times(config.nodes);
+    std::atomic<bool> running{true};
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < config.cpu_stress; t++) {
+        threads.emplace_back([&] {
+            volatile uint64_t spin = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                spin = spin + 1;
+            }
+        });
+    }
+
+    // simulated agents: each stream owns every streams-th node
+    for (size_t s = 0; s < config.streams; s++) {
+        threads.emplace_back([&, s] {
+            std::mt19937 rng(config.seed + static_cast<uint32_t>(s));
+            std::uniform_real_distribution<double> unit(0.0, 1.0);
+            ClientContext context;
+            tinykube::Empty response;
+            auto writer = stub->StreamHeartbeats(&context, &response);
+            std::vector<int64_t> next_send;
+            for (size_t i = s; i < config.nodes; i += config.streams) {
+                next_send.push_back(tinykube::now_ms() + static_cast<int64_t>(unit(rng) * config.interval_ms));
+            }
+            while (running.load()) {
+                int64_t now = tinykube::now_ms();
+                int64_t wake = now + config.interval_ms;
+                for (size_t k = 0; k < next_send.size(); k++) {
+                    size_t index = s + k * config.streams;
+                    auto& node = times[index];
+                    int64_t kill_at = node.kill_at.load();
+                    if (kill_at >= 0 && now >= kill_at) {
+                        continue;
+                    }
+                    if (next_send[k] <= now) {
+                        if (unit(rng) >= config.drop) {
+                            tinykube::Heartbeat heartbeat;
+                            heartbeat.set_node_name(node_name(index));
+                            heartbeat.set_now_unix_ms(now);
+                            if (!writer->Write(heartbeat)) {
+                                return;
+                            }
+                            node.last_heartbeat.store(now);
+                        }
+                        next_send[k] = now + config.interval_ms +
+                                       static_cast<int64_t>(unit(rng) * static_cast<double>(config.jitter_ms));
+                    }
+                    wake = std::min(wake, next_send[k]);
+                    if (kill_at >= 0) {
+                        wake = std::min(wake, kill_at);
+                    }
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(std::max<int64_t>(1, wake - now)));
+            }
+            writer->WritesDone();
+            writer->Finish();
+        });
+    }
+
+    auto record_status = [&](size_t index, tinykube::NodeStatus status, int64_t now, bool from_watch) {
+        auto& node = times[index];
+        bool down = status == tinykube::NodeStatus::SUSPECT || status == tinykube::NodeStatus::NOT_READY;
+        if (!down) {
+            return;
+        }
+        int64_t kill_at = node.kill_at.load();
+        if (!node.victim.load() || kill_at < 0 || now < kill_at) {
+            node.false_positive.store(true);
+            return;
+        }
+        if (status == tinykube::NodeStatus::SUSPECT) {
+            set_once(from_watch ? node.watch_suspect : node.suspect, now);
+        } else {
+            set_once(from_watch ? node.watch_not_ready : node.not_ready, now);
+        }
+    };
+    auto index_of = [](const std::string& name) -> long {
+        return name.rfind("bench-", 0) == 0 ? std::stol(name.substr(6)) : -1;
+    };
+
+    // watcher: the same WatchNodes path a real client uses
+    ClientContext watch_context;
+    std::thread watcher([&] {
+        tinykube::WatchRequest request;
+        auto reader = stub->WatchNodes(&watch_context, request);
+        tinykube::NodeEvent event;
+        while (reader->Read(&event)) {
+            int64_t now = tinykube::now_ms();
+            for (const auto& record : event.nodes()) {
+                long index = index_of(record.name());
+                if (index >= 0 && static_cast<size_t>(index) < config.nodes) {
+                    record_status(static_cast<size_t>(index), static_cast<tinykube::NodeStatus>(record.status()), now, true);
+                }
+            }
+        }
+        reader->Finish();
+    });
+
+    // sweeper: what monitor_nodes() does, minus the table
+    std::thread sweeper([&] {
+        while (running.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(config.sweep_ms));
+            service.tenants().sweep(tinykube::now_ms(), HEARTBEAT_TIMEOUT_MS, NOT_READY_TIMEOUT_MS);
+            int64_t now = tinykube::now_ms();
+            for (const auto& node : service.tenants().snapshot()) {
+                long index = index_of(node.name);
+                if (index >= 0 && static_cast<size_t>(index) < config.nodes) {
+                    record_status(static_cast<size_t>(index), node.status, now, false);
+                }
+            }
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(config.warmup_ms));
+
+    std::mt19937 rng(config.seed);
+    std::vector<size_t> order(config.nodes);
+    for (size_t i = 0; i < config.nodes; i++) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+    size_t victims = std::min(config.nodes, static_cast<size_t>(config.kill_fraction * static_cast<double>(config.nodes)));
+    int64_t kill_start = tinykube::now_ms();
+    int64_t spread = config.pattern == "burst" ? 0 : config.pattern == "staggered" ? config.sweep_ms : 2 * NOT_READY_TIMEOUT_MS;
+    std::uniform_int_distribution<int64_t> offset(0, std::max<int64_t>(0, spread));
+    for (size_t v = 0; v < victims; v++) {
+        int64_t at = kill_start;
+        if (config.pattern == "staggered") {
+            at += spread * static_cast<int64_t>(v) / static_cast<int64_t>(std::max<size_t>(1, victims));
+        } else if (config.pattern == "random") {
+            at += offset(rng);
+        }
+        times[order[v]].victim.store(true);
+        times[order[v]].kill_at.store(at);
+    }
+    std::cout << "💀 Killing " << victims << " nodes..." << std::endl;
+
+    // every victim reaches NOT_READY by its last heartbeat + timeout + one sweep
+    int64_t deadline = kill_start + spread + NOT_READY_TIMEOUT_MS + 2 * config.sweep_ms + 2000;
+    while (tinykube::now_ms() < deadline) {
+        bool done = true;
+        for (size_t v = 0; v < victims && done; v++) {
+            done = times[order[v]].watch_not_ready.load() >= 0;
+        }
+        if (done) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    running.store(false);
+    sweeper.join();
+    service.shutdown();
+    watch_context.TryCancel();
+    watcher.join();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    server->Shutdown();
+
+    std::vector<int64_t> to_suspect, to_not_ready, to_watch_suspect, to_watch_not_ready, watch_delay;
+    size_t undetected = 0;
+    for (size_t v = 0; v < victims; v++) {
+        const auto& node = times[order[v]];
+        int64_t last = node.last_heartbeat.load();
+        if (last < 0) {
+            continue;
+        }
+        if (node.suspect.load() >= 0) to_suspect.push_back(node.suspect.load() - last);
+        if (node.not_ready.load() >= 0) to_not_ready.push_back(node.not_ready.load() - last);
+        if (node.watch_suspect.load() >= 0) to_watch_suspect.push_back(node.watch_suspect.load() - last);
+        if (node.watch_not_ready.load() >= 0) {
+            to_watch_not_ready.push_back(node.watch_not_ready.load() - last);
+        } else {
+            undetected++;
+        }
+        // the sweeper snapshot is taken after the publish, so this can come out negative
+        if (node.suspect.load() >= 0 && node.watch_suspect.load() >= 0) {
+            watch_delay.push_back(std::max<int64_t>(0, node.watch_suspect.load() - node.suspect.load()));
+        }
+    }
+    size_t false_positives = 0;
+    for (const auto& node : times) {
+        false_positives += node.false_positive.load() ? 1 : 0;
+    }
+
+    std::cout << "\n📊 Failure detection (ms after the victim's last heartbeat)" << std::endl;
+    print_distribution("registry: SUSPECT", to_suspect);
+    print_distribution("registry: NOT_READY", to_not_ready);
+    print_distribution("watch delivery: SUSPECT", to_watch_suspect);
+    print_distribution("watch delivery: NOT_READY", to_watch_not_ready);
+    print_distribution("sweep -> watch delivery", watch_delay);
+    std::cout << "  undetected victims: " << undetected << " / " << victims << std::endl;
+    std::cout << "  false positives:    " << false_positives << " / " << config.nodes - victims
+              << " survivors (cpu stress " << config.cpu_stress << ", jitter " << config.jitter_ms
+              << "ms, drop " << config.drop << ")" << std::endl;
+    return undetected == 0 ? 0 : 1;
+}
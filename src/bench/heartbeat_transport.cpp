@@ -0,0 +1,284 @@
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+
+#include "control/service.hpp"
+#include "tinykube/heartbeat_frame.hpp"
+#include "tinykube/shm_channel.hpp"
+#include "tinykube/uring_server.hpp"
+
+// Heartbeat transport load generator: the same heartbeat load sent over gRPC
+// streams, as frames to the io_uring listener and through shared-memory
+// rings, from a forked client process so the server's getrusage() is the
+// server alone. Reports server
+// CPU and context switches per heartbeat, plus io_uring_enter calls for the
+// frame path (the gRPC path's syscalls need `strace -c -f` from outside).
+
+using grpc::ClientContext;
+
+struct BenchConfig {
+    size_t nodes{1000};
+    size_t connections{16};
+    size_t rounds{100};  // heartbeats per node
+    size_t batch{1};     // heartbeats per write on the frame and shared-memory paths
+    std::string grpc_address{"127.0.0.1:50161"};
+    std::string frames_address{"127.0.0.1:50162"};
+    std::string shm_path{"/tmp/tinykube-bench-heartbeats.sock"};
+};
+
+std::string node_name(size_t index) {
+    return "bench-" + std::to_string(index);
+}
+
+void send_grpc(const BenchConfig& config) {
+    auto stub = tinykube::ControlPlane::NewStub(
+        grpc::CreateChannel(config.grpc_address, grpc::InsecureChannelCredentials()));
+    std::vector<std::thread> threads;
+    for (size_t c = 0; c < config.connections; c++) {
+        threads.emplace_back([&, c] {
+            ClientContext context;
+            tinykube::Empty response;
+            auto writer = stub->StreamHeartbeats(&context, &response);
+            tinykube::Heartbeat heartbeat;
+            for (size_t round = 0; round < config.rounds; round++) {
+                for (size_t i = c; i < config.nodes; i += config.connections) {
+                    heartbeat.set_node_name(node_name(i));
+                    heartbeat.set_now_unix_ms(tinykube::now_ms());
+                    writer->Write(heartbeat);
+                }
+            }
+            writer->WritesDone();
+            writer->Finish();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void send_frames(const BenchConfig& config) {
+    std::vector<std::thread> threads;
+    for (size_t c = 0; c < config.connections; c++) {
+        threads.emplace_back([&, c] {
+            std::string error;
+            int fd = tinykube::open_frame_socket(config.frames_address, false, error);
+            if (fd < 0) {
+                std::cerr << "❌ Error: " << error << std::endl;
+                return;
+            }
+            std::vector<tinykube::HeartbeatFrame> pending;
+            for (size_t round = 0; round < config.rounds; round++) {
+                for (size_t i = c; i < config.nodes; i += config.connections) {
+                    pending.emplace_back();
+                    tinykube::make_frame("", node_name(i), tinykube::now_ms(), pending.back());
+                    if (pending.size() >= config.batch) {
+                        tinykube::send_frames(fd, pending.data(), pending.size());
+                        pending.clear();
+                    }
+                }
+            }
+            tinykube::send_frames(fd, pending.data(), pending.size());
+            ::close(fd);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void send_shm(const BenchConfig& config) {
+    std::vector<std::thread> threads;
+    for (size_t c = 0; c < config.connections; c++) {
+        threads.emplace_back([&, c] {
+            tinykube::ShmHeartbeatProducer producer;
+            std::string error;
+            if (!producer.connect(config.shm_path, error)) {
+                std::cerr << "❌ Error: " << error << std::endl;
+                return;
+            }
+            std::vector<tinykube::HeartbeatFrame> pending;
+            for (size_t round = 0; round < config.rounds; round++) {
+                for (size_t i = c; i < config.nodes; i += config.connections) {
+                    pending.emplace_back();
+                    tinykube::make_frame("", node_name(i), tinykube::now_ms(), pending.back());
+                    if (pending.size() >= config.batch) {
+                        producer.push_all(pending.data(), pending.size());
+                        pending.clear();
+                    }
+                }
+            }
+            producer.push_all(pending.data(), pending.size());
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// The clients are forked before the server exists: gRPC does not survive a
+// fork once its threads are running. Each waits for a byte on its pipe.
+struct Client {
+    pid_t pid{-1};
+    int go{-1};
+};
+
+Client fork_client(const BenchConfig& config, void (*send)(const BenchConfig&)) {
+    int fds[2];
+    if (::pipe(fds) != 0) {
+        return {};
+    }
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        ::close(fds[1]);
+        char byte;
+        if (::read(fds[0], &byte, 1) == 1) {
+            send(config);
+        }
+        _exit(0);
+    }
+    ::close(fds[0]);
+    return {pid, fds[1]};
+}
+
+struct Usage {
+    double cpu_us{0};
+    long switches{0};
+};
+
+Usage operator-(const rusage& after, const rusage& before) {
+    auto us = [](const timeval& tv) { return static_cast<double>(tv.tv_sec) * 1e6 + static_cast<double>(tv.tv_usec); };
+    Usage usage;
+    usage.cpu_us = us(after.ru_utime) - us(before.ru_utime) + us(after.ru_stime) - us(before.ru_stime);
+    usage.switches = after.ru_nvcsw - before.ru_nvcsw + after.ru_nivcsw - before.ru_nivcsw;
+    return usage;
+}
+
+// runs one client to completion; `drained` says when the server has applied everything
+template <typename Drained>
+void measure(const std::string& label, Client client, size_t heartbeats, Drained drained) {
+    rusage before{}, after{}, child{};
+    ::getrusage(RUSAGE_SELF, &before);
+    auto started = std::chrono::steady_clock::now();
+    ssize_t written = ::write(client.go, "g", 1);
+    (void)written;
+    int status = 0;
+    ::wait4(client.pid, &status, 0, &child);
+    while (!drained()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    ::getrusage(RUSAGE_SELF, &after);
+    ::close(client.go);
+
+    Usage server = after - before;
+    Usage clients = child - rusage{};
+    auto per = [&](double value) { return value / static_cast<double>(heartbeats); };
+    std::cout << "  " << std::left << std::setw(8) << label << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << static_cast<double>(heartbeats) / seconds / 1000.0 << "k/s"
+              << "  server " << std::setw(7) << per(server.cpu_us) << " us CPU, " << std::setw(7)
+              << per(static_cast<double>(server.switches)) << " ctx switches"
+              << "  client " << std::setw(7) << per(clients.cpu_us) << " us CPU  (per heartbeat)"
+              << std::defaultfloat << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help" || i + 1 >= argc) {
+            std::cout << "Usage: " << argv[0] << " [--nodes 1000] [--connections 16] [--rounds 100] [--batch 1]"
+                      << " [--grpc 127.0.0.1:50161] [--frames 127.0.0.1:50162|unix:/path] [--shm <socket path>]" << std::endl;
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--nodes") config.nodes = std::max<size_t>(1, std::stoul(value));
+        else if (arg == "--connections") config.connections = std::max<size_t>(1, std::stoul(value));
+        else if (arg == "--rounds") config.rounds = std::max<size_t>(1, std::stoul(value));
+        else if (arg == "--batch") config.batch = std::max<size_t>(1, std::stoul(value));
+        else if (arg == "--grpc") config.grpc_address = value;
+        else if (arg == "--frames") config.frames_address = value;
+        else if (arg == "--shm") config.shm_path = value;
+        else {
+            std::cerr << "❌ Error: Unknown argument '" << arg << "'" << std::endl;
+            return 1;
+        }
+    }
+
+    Client grpc_client = fork_client(config, send_grpc);
+    Client frames_client = fork_client(config, send_frames);
+    Client shm_client = fork_client(config, send_shm);
+
+    ControlPlaneOptions options;
+    options.cron_journal_path.clear();
+    options.verbose = false;
+    ControlPlaneServiceImpl service(options);
+    tinykube::TenantQuota unlimited;
+    unlimited.max_nodes = config.nodes + 1;
+    unlimited.heartbeats_per_sec = unlimited.heartbeat_burst = 1e12;
+    service.tenants().set_quota(tinykube::DEFAULT_TENANT, unlimited);
+    auto& partition = service.tenants().partition(tinykube::DEFAULT_TENANT);
+    for (size_t i = 0; i < config.nodes; i++) {
+        tinykube::NodeState node;
+        node.name = node_name(i);
+        node.tenant = partition.name;
+        node.status = tinykube::NodeStatus::READY;
+        node.last_seen_ms = tinykube::now_ms();
+        partition.nodes.upsert(node);
+    }
+
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort(config.grpc_address, grpc::InsecureServerCredentials());
+    builder.RegisterService(&service);
+    auto server = builder.BuildAndStart();
+    tinykube::UringHeartbeatServer frames([&service](const tinykube::HeartbeatFrame* batch, size_t count, int64_t now) {
+        service.ingest_frames(batch, count, now);
+    });
+    tinykube::ShmHeartbeatServer shm([&service](const tinykube::HeartbeatFrame* batch, size_t count, int64_t now) {
+        service.ingest_frames(batch, count, now);
+    });
+    std::string error;
+    if (!server || !frames.start(config.frames_address, error) || !shm.start(config.shm_path, error)) {
+        std::cerr << "❌ Error: could not listen: " << (server ? error : config.grpc_address) << std::endl;
+        for (pid_t pid : {grpc_client.pid, frames_client.pid, shm_client.pid}) {
+            ::kill(pid, SIGKILL);
+        }
+        return 1;
+    }
+
+    size_t heartbeats = config.nodes * config.rounds;
+    std::cout << "📨 Heartbeat transport benchmark: " << heartbeats << " heartbeats (" << config.nodes
+              << " nodes x " << config.rounds << ") over " << config.connections << " connections, frame batch "
+              << config.batch << std::endl;
+
+    // a finished stream means the server has read everything on it
+    measure("grpc", grpc_client, heartbeats, [] { return true; });
+    uint64_t enters_before = frames.stats().enters;
+    measure("io_uring", frames_client, heartbeats, [&] { return frames.stats().frames >= heartbeats; });
+
+    auto stats = frames.stats();
+    std::cout << "  io_uring: " << std::fixed << std::setprecision(4)
+              << static_cast<double>(stats.enters - enters_before) / static_cast<double>(heartbeats)
+              << " io_uring_enter calls per heartbeat, " << stats.no_buffers << " buffer ring refills, "
+              << stats.bad_frames << " bad frames" << std::defaultfloat << std::endl;
+
+    measure("shm", shm_client, heartbeats, [&] { return shm.stats().frames >= heartbeats; });
+    std::cout << "  shm: consumer slept " << shm.stats().sleeps << " times" << std::endl;
+
+    shm.stop();
+    frames.stop();
+    service.shutdown();
+    server->Shutdown();
+    return 0;
+}
@@ -0,0 +1,202 @@
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "control_plane.pb.h"
+
+#include "tinykube/node_record.hpp"
+#include "tinykube/tenant_registry.hpp"
+#include "tinykube/time.hpp"
+
+// Control plane memory footprint benchmark. Each size runs in a forked child
+// so RSS starts clean; allocations are attributed to whichever phase the
+// allocating thread is in.
+
+enum Category { OTHER, INPUT, REGISTRY, SNAPSHOT, GRPC, CATEGORY_COUNT };
+const char* CATEGORY_NAMES[] = {"other", "input strings", "registry", "snapshot", "grpc buffers"};
+
+thread_local int g_category = OTHER;
+std::atomic<uint64_t> g_allocations[CATEGORY_COUNT];
+std::atomic<uint64_t> g_allocated_bytes[CATEGORY_COUNT];
+
+void* operator new(std::size_t size) {
+    g_allocations[g_category].fetch_add(1, std::memory_order_relaxed);
+    g_allocated_bytes[g_category].fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+struct CategoryScope {
+    explicit CategoryScope(Category category) : previous(g_category) {
+        g_category = category;
+    }
+    ~CategoryScope() {
+        g_category = previous;
+    }
+    int previous;
+};
+
+size_t rss_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGE_SIZE));
+}
+
+std::string mib(size_t bytes) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << bytes / (1024.0 * 1024.0) << " MiB";
+    return out.str();
+}
+
+void run(size_t count, size_t labels) {
+    size_t rss_start = rss_bytes();
+    tinykube::TenantRegistry tenants;
+    tinykube::TenantQuota quota;
+    quota.max_nodes = count;
+    tenants.set_quota(tinykube::DEFAULT_TENANT, quota);
+    auto& partition = tenants.partition(tinykube::DEFAULT_TENANT);
+
+    auto started = std::chrono::steady_clock::now();
+    int64_t now = tinykube::now_ms();
+    for (size_t i = 0; i < count; i++) {
+        tinykube::NodeState node;
+        {
+            CategoryScope scope(INPUT);
+            node.name = "synthetic-node-" + std::to_string(i);
+            node.tenant = tinykube::DEFAULT_TENANT;
+            node.peer = "ipv4:10." + std::to_string(i >> 16 & 255) + "." + std::to_string(i >> 8 & 255) + "." +
+                        std::to_string(i & 255) + ":" + std::to_string(40000 + i % 20000);
+            node.status = tinykube::NodeStatus::READY;
+            node.last_seen_ms = now;
+            node.capacity = tinykube::Resources{4000, 16384};
+            for (size_t l = 0; l < labels; l++) {
+                node.labels["label-" + std::to_string(l)] = "value-" + std::to_string(i % 16);
+            }
+        }
+        CategoryScope scope(REGISTRY);
+        partition.nodes.upsert(node);
+    }
+    double register_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    size_t rss_registry = rss_bytes();
+    auto usage = tenants.memory_usage();
+
+    uint64_t snapshot_allocations = 0, snapshot_bytes = 0;
+    {
+        uint64_t before = g_allocations[SNAPSHOT], before_bytes = g_allocated_bytes[SNAPSHOT];
+        CategoryScope scope(SNAPSHOT);
+        auto nodes = tenants.snapshot();
+        snapshot_allocations = g_allocations[SNAPSHOT] - before;
+        snapshot_bytes = g_allocated_bytes[SNAPSHOT] - before_bytes;
+    }
+
+    // what a WatchNodes client costs on connect: the snapshot event, serialized
+    size_t wire_bytes = 0;
+    {
+        auto nodes = tenants.snapshot();
+        CategoryScope scope(GRPC);
+        tinykube::NodeEvent event;
+        for (const auto& node : nodes) {
+            tinykube::to_record(node, event.add_nodes());
+        }
+        event.set_snapshot(true);
+        std::string wire;
+        event.SerializeToString(&wire);
+        wire_bytes = wire.size();
+    }
+
+    size_t rss_delta = rss_registry > rss_start ? rss_registry - rss_start : 0;
+    std::cout << "\n📦 " << count << " nodes (" << labels << " labels each), registered in "
+              << std::fixed << std::setprecision(2) << register_s << "s" << std::defaultfloat << std::endl;
+    std::cout << "  RSS:                 " << mib(rss_delta) << " (" << rss_delta / count << " B/node)" << std::endl;
+    std::cout << "  memory_usage():      " << mib(usage.total()) << " (" << usage.total() / count << " B/node)" << std::endl;
+    std::cout << "    node entries       " << mib(usage.node_bytes) << std::endl;
+    std::cout << "    strings            " << mib(usage.string_bytes) << std::endl;
+    std::cout << "    labels             " << mib(usage.label_bytes) << std::endl;
+    std::cout << "    availability       " << mib(usage.availability_bytes) << std::endl;
+    std::cout << "  snapshot:            " << snapshot_allocations << " allocations, " << mib(snapshot_bytes)
+              << " (" << snapshot_bytes / count << " B/node)" << std::endl;
+    std::cout << "  watch snapshot wire: " << mib(wire_bytes) << " (" << wire_bytes / count << " B/node)" << std::endl;
+    std::cout << "  allocations by phase:" << std::endl;
+    for (int category = INPUT; category < CATEGORY_COUNT; category++) {
+        uint64_t allocations = g_allocations[category];
+        std::cout << "    " << std::left << std::setw(17) << CATEGORY_NAMES[category] << std::right
+                  << std::setw(10) << allocations << " allocs (" << std::setprecision(2) << std::fixed
+                  << static_cast<double>(allocations) / count << "/node), " << mib(g_allocated_bytes[category])
+                  << std::defaultfloat << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<size_t> sizes{10000, 100000, 1000000};
+    size_t labels = 2;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--labels" && i + 1 < argc) {
+            labels = std::stoul(argv[++i]);
+        } else if (arg == "--sizes" && i + 1 < argc) {
+            sizes.clear();
+            std::istringstream list(argv[++i]);
+            std::string size;
+            while (std::getline(list, size, ',')) {
+                sizes.push_back(std::stoul(size));
+            }
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--sizes 10000,100000,1000000] [--labels 2]" << std::endl;
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+
+    std::cout << "🧠 TinyKube control plane memory benchmark" << std::endl;
+    for (size_t size : sizes) {
+        if (size == 0) {
+            continue;
+        }
+        std::cout.flush();
+        pid_t child = fork();
+        if (child == 0) {
+            run(size, labels);
+            std::cout.flush();
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(child, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::cerr << "❌ Run with " << size << " nodes failed" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
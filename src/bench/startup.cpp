@@ -0,0 +1,425 @@
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+
+#include "control_plane.grpc.pb.h"
+#include "control_plane.pb.h"
+
+#include "tinykube/tls.hpp"
+#include "tinykube/types.hpp"
+
+// Startup and recovery benchmark for the real tinykube_control binary:
+//   cold start   process start -> accepting RPCs
+//   fill         N agents registered and READY on a fresh control plane
+//   restart      kill + start again -> accepting RPCs -> N nodes known again
+//                -> all N READY, with the agents reconnecting and re-registering
+//   reconnect    every agent dials a fresh connection to the running control
+//                plane and re-registers, as after a network partition heals
+// The control plane keeps no registry state on disk, so "recovered" here means
+// rebuilt from re-registrations. With --tls <dir> (scripts/gen-certs.sh) all
+// of it runs over mutual TLS; compare the reconnect line against a plaintext
+// run, and against --no-resumption for the full-handshake cost.
+
+using grpc::ClientContext;
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    std::string control;
+    std::string address{"127.0.0.1:50151"};
+    size_t nodes{1000};
+    size_t streams{16};
+    int runs{3};
+    bool graceful{false};
+    int64_t timeout_ms{120000};
+    std::string tls_dir;
+    bool resumption{true};
+
+    tinykube::TlsFiles client_tls() const {
+        tinykube::TlsFiles files;
+        if (!tls_dir.empty()) {
+            files.ca = tls_dir + "/ca.pem";
+            files.cert = tls_dir + "/client.pem";
+            files.key = tls_dir + "/client.key";
+        }
+        return files;
+    }
+};
+
+double ms_since(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// `own_connection` keeps the channel off the process-wide subchannel pool, so
+// it dials its own TCP (and TLS) connection like a separate agent would
+std::shared_ptr<grpc::Channel> make_channel(const BenchConfig& config, bool own_connection = false) {
+    // the default reconnect backoff starts at 1s and would dominate the numbers
+    grpc::ChannelArguments args;
+    args.SetInt(GRPC_ARG_INITIAL_RECONNECT_BACKOFF_MS, 10);
+    args.SetInt(GRPC_ARG_MIN_RECONNECT_BACKOFF_MS, 10);
+    args.SetInt(GRPC_ARG_MAX_RECONNECT_BACKOFF_MS, 100);
+    if (own_connection) {
+        args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+    }
+    std::string error;
+    auto credentials = tinykube::channel_credentials(config.client_tls(), error);
+    if (!credentials) {
+        std::cerr << "❌ Error: " << error << std::endl;
+        std::exit(1);
+    }
+    if (!config.tls_dir.empty() && config.resumption) {
+        tinykube::enable_session_resumption(args);
+    }
+    return grpc::CreateCustomChannel(config.address, credentials, args);
+}
+
+class ControlProcess {
+public:
+    ControlProcess(const BenchConfig& config, const std::string& workdir) : config_(config), workdir_(workdir) {}
+
+    ~ControlProcess() {
+        stop(false);
+    }
+
+    void start() {
+        started_ = Clock::now();
+        pid_ = fork();
+        if (pid_ == 0) {
+            // quiet child in its own directory, so its cron journal is its own
+            if (chdir(workdir_.c_str()) != 0) {
+                _exit(127);
+            }
+            int log = open("control.log", O_WRONLY | O_CREAT | O_APPEND, 0644);
+            dup2(log, STDOUT_FILENO);
+            dup2(log, STDERR_FILENO);
+            std::vector<std::string> args{config_.control, "--listen", config_.address};
+            if (!config_.tls_dir.empty()) {
+                args.insert(args.end(), {"--tls-ca", config_.tls_dir + "/ca.pem", "--tls-cert",
+                                         config_.tls_dir + "/server.pem", "--tls-key", config_.tls_dir + "/server.key"});
+            }
+            std::vector<char*> argv;
+            for (auto& arg : args) {
+                argv.push_back(arg.data());
+            }
+            argv.push_back(nullptr);
+            execv(config_.control.c_str(), argv.data());
+            _exit(127);
+        }
+    }
+
+    // SIGTERM waits for the graceful path, SIGKILL models a crash
+    void stop(bool graceful) {
+        if (pid_ <= 0) {
+            return;
+        }
+        kill(pid_, graceful ? SIGTERM : SIGKILL);
+        int status = 0;
+        waitpid(pid_, &status, 0);
+        pid_ = -1;
+    }
+
+    // time from fork to the first answered RPC, or -1 on timeout
+    double wait_listening(int64_t timeout_ms) {
+        auto stub = tinykube::ControlPlane::NewStub(make_channel(config_));
+        while (ms_since(started_) < static_cast<double>(timeout_ms)) {
+            tinykube::TraceRequest request;
+            tinykube::TraceResponse response;
+            ClientContext context;
+            context.set_deadline(std::chrono::system_clock::now() + std::chrono::milliseconds(100));
+            context.set_wait_for_ready(true);
+            if (stub->Trace(&context, request, &response).ok()) {
+                return ms_since(started_);
+            }
+        }
+        return -1;
+    }
+
+    Clock::time_point started() const {
+        return started_;
+    }
+
+    // user + system CPU the control plane has used so far, from /proc
+    double cpu_ms() const {
+        std::ifstream in("/proc/" + std::to_string(pid_) + "/stat");
+        std::string line;
+        std::getline(in, line);
+        auto close = line.rfind(')');
+        if (close == std::string::npos) {
+            return 0;
+        }
+        std::istringstream fields(line.substr(close + 2));
+        std::string field;
+        double ticks = 0;
+        for (int index = 3; fields >> field && index <= 15; index++) {
+            if (index >= 14) {  // utime, stime
+                ticks += std::stod(field);
+            }
+        }
+        return ticks * 1000.0 / static_cast<double>(sysconf(_SC_CLK_TCK));
+    }
+private:
+    const BenchConfig& config_;
+    std::string workdir_;
+    pid_t pid_{-1};
+    Clock::time_point started_;
+};
+
+// Simulated agents that, unlike tinykube_agent today, re-register and
+// reopen their stream whenever the control plane goes away.
+class AgentFleet {
+public:
+    explicit AgentFleet(const BenchConfig& config) : config_(config), stub_(tinykube::ControlPlane::NewStub(make_channel(config))) {}
+
+    ~AgentFleet() {
+        stop();
+    }
+
+    void start() {
+        for (size_t s = 0; s < config_.streams; s++) {
+            threads_.emplace_back([this, s] { run(s); });
+        }
+    }
+
+    void stop() {
+        running_.store(false);
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+        threads_.clear();
+    }
+private:
+    void run(size_t stream) {
+        while (running_.load()) {
+            for (size_t i = stream; i < config_.nodes && running_.load(); i += config_.streams) {
+                while (running_.load() && !register_node(i)) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                }
+            }
+
+            ClientContext context;
+            tinykube::Empty response;
+            auto writer = stub_->StreamHeartbeats(&context, &response);
+            bool healthy = true;
+            while (running_.load() && healthy) {
+                for (size_t i = stream; i < config_.nodes && healthy; i += config_.streams) {
+                    tinykube::Heartbeat heartbeat;
+                    heartbeat.set_node_name("bench-" + std::to_string(i));
+                    healthy = writer->Write(heartbeat);
+                }
+                for (int tick = 0; tick < 10 && running_.load() && healthy; tick++) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                }
+            }
+            writer->WritesDone();
+            writer->Finish();
+        }
+    }
+
+    bool register_node(size_t index) {
+        tinykube::RegisterRequest request;
+        request.mutable_node()->set_name("bench-" + std::to_string(index));
+        tinykube::RegisterResponse response;
+        ClientContext context;
+        context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(1));
+        context.set_wait_for_ready(true);
+        return stub_->RegisterNode(&context, request, &response).ok() && response.accepted();
+    }
+
+    const BenchConfig& config_;
+    std::unique_ptr<tinykube::ControlPlane::Stub> stub_;
+    std::atomic<bool> running_{true};
+    std::vector<std::thread> threads_;
+};
+
+bool alive(uint32_t status) {
+    return status == static_cast<uint32_t>(tinykube::NodeStatus::READY) ||
+           status == static_cast<uint32_t>(tinykube::NodeStatus::DEGRADED);
+}
+
+// Follows WatchNodes and records when N nodes are known and when all are READY.
+// Returns {known_ms, ready_ms} relative to `since`, -1 for a missed deadline.
+std::pair<double, double> wait_fleet(const BenchConfig& config, Clock::time_point since) {
+    auto stub = tinykube::ControlPlane::NewStub(make_channel(config));
+    double known_ms = -1, ready_ms = -1;
+    while (ready_ms < 0 && ms_since(since) < static_cast<double>(config.timeout_ms)) {
+        std::unordered_map<std::string, uint32_t> status;
+        size_t ready = 0;
+        ClientContext context;
+        context.set_deadline(std::chrono::system_clock::now() +
+                             std::chrono::milliseconds(config.timeout_ms - static_cast<int64_t>(ms_since(since))));
+        context.set_wait_for_ready(true);
+        tinykube::WatchRequest request;
+        auto reader = stub->WatchNodes(&context, request);
+        tinykube::NodeEvent event;
+        while (reader->Read(&event)) {
+            for (const auto& record : event.nodes()) {
+                auto [it, inserted] = status.try_emplace(record.name(), 0);
+                bool was_ready = !inserted && alive(it->second);
+                bool is_ready = alive(record.status());
+                it->second = record.status();
+                ready += (is_ready && !was_ready) ? 1 : 0;
+                ready -= (!is_ready && was_ready) ? 1 : 0;
+            }
+            if (known_ms < 0 && status.size() >= config.nodes) {
+                known_ms = ms_since(since);
+            }
+            if (ready >= config.nodes) {
+                ready_ms = ms_since(since);
+                context.TryCancel();
+                break;
+            }
+        }
+        reader->Finish();
+    }
+    return {known_ms, ready_ms};
+}
+
+// Every agent drops its connection and dials a new one, then re-registers.
+// Returns the wall time until the whole fleet is back, -1 on a failure.
+double reconnect_fleet(const BenchConfig& config) {
+    auto start = Clock::now();
+    std::atomic<size_t> failed{0};
+    std::vector<std::thread> threads;
+    for (size_t s = 0; s < config.streams; s++) {
+        threads.emplace_back([&, s] {
+            for (size_t i = s; i < config.nodes; i += config.streams) {
+                auto stub = tinykube::ControlPlane::NewStub(make_channel(config, true));
+                tinykube::RegisterRequest request;
+                request.mutable_node()->set_name("bench-" + std::to_string(i));
+                tinykube::RegisterResponse response;
+                ClientContext context;
+                context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(5));
+                context.set_wait_for_ready(true);
+                if (!stub->RegisterNode(&context, request, &response).ok()) {
+                    failed++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return failed.load() == 0 ? ms_since(start) : -1;
+}
+
+void print_summary(const std::string& label, std::vector<double> values) {
+    std::cout << "  " << std::left << std::setw(30) << label << std::right;
+    values.erase(std::remove(values.begin(), values.end(), -1.0), values.end());
+    if (values.empty()) {
+        std::cout << "timed out" << std::endl;
+        return;
+    }
+    std::sort(values.begin(), values.end());
+    std::cout << std::fixed << std::setprecision(1) << "median " << std::setw(9) << values[values.size() / 2]
+              << "  min " << std::setw(9) << values.front() << "  max " << std::setw(9) << values.back()
+              << " ms" << std::defaultfloat << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    config.control = (std::filesystem::path(argv[0]).parent_path() / "tinykube_control").string();
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--graceful") {
+            config.graceful = true;
+            continue;
+        }
+        if (arg == "--no-resumption") {
+            config.resumption = false;
+            continue;
+        }
+        if (arg == "-h" || arg == "--help" || i + 1 >= argc) {
+            std::cout << "Usage: " << argv[0] << " [--control <path>] [--address host:port] [--nodes 1000]"
+                      << " [--streams 16] [--runs 3] [--timeout <ms>] [--graceful] [--tls <cert dir> [--no-resumption]]"
+                      << std::endl;
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--control") config.control = value;
+        else if (arg == "--address") config.address = value;
+        else if (arg == "--nodes") config.nodes = std::stoul(value);
+        else if (arg == "--streams") config.streams = std::max<size_t>(1, std::stoul(value));
+        else if (arg == "--runs") config.runs = std::max(1, std::stoi(value));
+        else if (arg == "--timeout") config.timeout_ms = std::stoll(value);
+        else if (arg == "--tls") config.tls_dir = std::filesystem::absolute(value).string();
+        else {
+            std::cerr << "❌ Error: Unknown argument '" << arg << "'" << std::endl;
+            return 1;
+        }
+    }
+
+    char workdir_template[] = "/tmp/tinykube-bench-XXXXXX";
+    if (mkdtemp(workdir_template) == nullptr) {
+        std::cerr << "❌ Error: could not create a work directory" << std::endl;
+        return 1;
+    }
+    std::string workdir = workdir_template;
+    std::cout << "🚀 Startup benchmark: " << config.control << " on " << config.address << ", " << config.nodes
+              << " agents over " << config.streams << " streams, " << config.runs << " runs, restarts via "
+              << (config.graceful ? "SIGTERM" : "SIGKILL") << ", "
+              << (config.tls_dir.empty() ? "plaintext" : config.resumption ? "mutual TLS" : "mutual TLS without resumption")
+              << " (logs in " << workdir << ")" << std::endl;
+
+    std::vector<double> cold_listen, fill_ready, restart_listen, restart_known, restart_ready, reconnect, reconnect_cpu;
+    for (int run = 0; run < config.runs; run++) {
+        ControlProcess control(config, workdir);
+        control.start();
+        cold_listen.push_back(control.wait_listening(config.timeout_ms));
+
+        AgentFleet agents(config);
+        auto fill_start = Clock::now();
+        agents.start();
+        fill_ready.push_back(wait_fleet(config, fill_start).second);
+
+        control.stop(config.graceful);
+        control.start();
+        restart_listen.push_back(control.wait_listening(config.timeout_ms));
+        auto [known, ready] = wait_fleet(config, control.started());
+        restart_known.push_back(known);
+        restart_ready.push_back(ready);
+
+        // once to warm the session cache, as the fleet's first connections would
+        reconnect_fleet(config);
+        double cpu_before = control.cpu_ms();
+        reconnect.push_back(reconnect_fleet(config));
+        reconnect_cpu.push_back((control.cpu_ms() - cpu_before) * 1000.0 / static_cast<double>(config.nodes));
+
+        std::cout << "  run " << run + 1 << ": listening after " << std::fixed << std::setprecision(1)
+                  << cold_listen.back() << "ms, fleet READY after " << fill_ready.back() << "ms; restart: listening "
+                  << restart_listen.back() << "ms, " << config.nodes << " known " << known << "ms, all READY "
+                  << ready << "ms; reconnect " << reconnect.back() << "ms, " << reconnect_cpu.back()
+                  << "us control CPU per connection" << std::defaultfloat << std::endl;
+        agents.stop();
+        control.stop(true);
+    }
+
+    std::cout << "\n📊 Startup and recovery (" << config.runs << " runs)" << std::endl;
+    print_summary("cold start -> listening", cold_listen);
+    print_summary("fresh fleet -> all READY", fill_ready);
+    print_summary("restart -> listening", restart_listen);
+    print_summary("restart -> all nodes known", restart_known);
+    print_summary("restart -> all READY", restart_ready);
+    print_summary("fleet reconnect", reconnect);
+    std::sort(reconnect_cpu.begin(), reconnect_cpu.end());
+    std::cout << "  " << std::left << std::setw(30) << "reconnect control CPU" << std::right << std::fixed
+              << std::setprecision(1) << "median " << std::setw(9) << reconnect_cpu[reconnect_cpu.size() / 2]
+              << " us per connection" << std::defaultfloat << std::endl;
+    std::filesystem::remove_all(workdir);
+    return 0;
+}
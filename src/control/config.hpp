@@ -0,0 +1,150 @@
+#pragma once
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Control plane tunables, from a file of "key = value" lines (# comments):
+//   listen = 0.0.0.0:50051        gRPC address, read at startup only
+//   heartbeat_timeout_ms = 3000   silence before READY becomes SUSPECT
+//   not_ready_timeout_ms = 10000  silence before SUSPECT becomes NOT_READY
+//   monitor_period_ms = 5000      sweep, schedule and status log period
+//   drain_timeout_ms = 2000       how long shutdown waits for in-flight RPCs
+// tinykube_control --config <file> reads it at startup and again on SIGHUP.
+
+const int64_t HEARTBEAT_TIMEOUT_MS = 3000; // 3 seconds
+const int64_t NOT_READY_TIMEOUT_MS = 10000; // 10 seconds
+
+struct ControlPlaneConfig {
+    std::string listen{"0.0.0.0:50051"};
+    int64_t heartbeat_timeout_ms{HEARTBEAT_TIMEOUT_MS};
+    int64_t not_ready_timeout_ms{NOT_READY_TIMEOUT_MS};
+    int64_t monitor_period_ms{5000};
+    int64_t drain_timeout_ms{2000};
+};
+
+struct ConfigKey {
+    const char* name;
+    int64_t ControlPlaneConfig::* field;
+    int64_t min;
+};
+
+inline constexpr ConfigKey CONFIG_KEYS[] = {
+    {"heartbeat_timeout_ms", &ControlPlaneConfig::heartbeat_timeout_ms, 1},
+    {"not_ready_timeout_ms", &ControlPlaneConfig::not_ready_timeout_ms, 1},
+    {"monitor_period_ms", &ControlPlaneConfig::monitor_period_ms, 10},
+    {"drain_timeout_ms", &ControlPlaneConfig::drain_timeout_ms, 0},
+};
+
+inline std::string_view trim_blanks(std::string_view text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    return text.substr(begin, text.find_last_not_of(" \t\r") - begin + 1);
+}
+
+// Keys the file leaves out keep their value in `config`, so start from
+// ControlPlaneConfig{} to get the defaults for them.
+inline bool parse_config(std::istream& in, ControlPlaneConfig& config, std::string& error) {
+    std::string line;
+    for (int number = 1; std::getline(in, line); number++) {
+        std::string_view text = trim_blanks(std::string_view(line).substr(0, line.find('#')));
+        if (text.empty()) {
+            continue;
+        }
+        auto equals = text.find('=');
+        if (equals == std::string_view::npos) {
+            error = "line " + std::to_string(number) + ": expected key = value";
+            return false;
+        }
+        std::string_view key = trim_blanks(text.substr(0, equals));
+        std::string_view value = trim_blanks(text.substr(equals + 1));
+        if (key == "listen") {
+            config.listen = value;
+            continue;
+        }
+        const ConfigKey* known = nullptr;
+        for (const auto& candidate : CONFIG_KEYS) {
+            if (key == candidate.name) {
+                known = &candidate;
+            }
+        }
+        if (known == nullptr) {
+            error = "line " + std::to_string(number) + ": unknown key '" + std::string(key) + "'";
+            return false;
+        }
+        int64_t number_value = 0;
+        auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), number_value);
+        if (ec != std::errc() || end != value.data() + value.size() || number_value < known->min) {
+            error = "line " + std::to_string(number) + ": " + known->name + " needs an integer of at least " +
+                    std::to_string(known->min);
+            return false;
+        }
+        config.*known->field = number_value;
+    }
+    if (config.listen.empty()) {
+        error = "listen cannot be empty";
+        return false;
+    }
+    if (config.not_ready_timeout_ms <= config.heartbeat_timeout_ms) {
+        error = "not_ready_timeout_ms must be longer than heartbeat_timeout_ms";
+        return false;
+    }
+    return true;
+}
+
+inline bool load_config(const std::string& path, ControlPlaneConfig& config, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot read " + path;
+        return false;
+    }
+    return parse_config(in, config, error);
+}
+
+// "key old -> new" for every setting that differs
+inline std::vector<std::string> config_changes(const ControlPlaneConfig& before, const ControlPlaneConfig& after) {
+    std::vector<std::string> changes;
+    if (before.listen != after.listen) {
+        changes.push_back("listen " + before.listen + " -> " + after.listen);
+    }
+    for (const auto& key : CONFIG_KEYS) {
+        if (before.*key.field != after.*key.field) {
+            changes.push_back(std::string(key.name) + " " + std::to_string(before.*key.field) + " -> " +
+                              std::to_string(after.*key.field));
+        }
+    }
+    return changes;
+}
+
+// Hands the current config to readers with a single acquire load: no lock,
+// no reference count. A reload swaps in a new immutable copy. Replaced copies
+// are kept rather than freed, so a reader may hold its reference as long as
+// it likes; reloads are rare and a config is a few dozen bytes.
+class ConfigStore {
+public:
+    explicit ConfigStore(ControlPlaneConfig initial = {}) {
+        publish(std::move(initial));
+    }
+
+    const ControlPlaneConfig& current() const {
+        return *current_.load(std::memory_order_acquire);
+    }
+
+    void publish(ControlPlaneConfig config) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        versions_.push_back(std::make_unique<const ControlPlaneConfig>(std::move(config)));
+        current_.store(versions_.back().get(), std::memory_order_release);
+    }
+private:
+    mutable std::mutex mutex_;  // publishers only
+    std::vector<std::unique_ptr<const ControlPlaneConfig>> versions_;
+    std::atomic<const ControlPlaneConfig*> current_{nullptr};
+};
@@ -0,0 +1,382 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "tinykube/federation.hpp"
+#include "tinykube/http_server.hpp"
+#include "tinykube/json_writer.hpp"
+#include "tinykube/tenant_registry.hpp"
+#include "tinykube/time.hpp"
+
+// Read-only HTTP/JSON view of the registry for consumers that don't speak
+// gRPC, served by tinykube_control --http:
+//   GET /summary                    counts by status, overall and per tenant
+//   GET /nodes[?tenant=<t>]         every node, streamed in chunks
+//   GET /nodes/<name>[?tenant=<t>]  one node, with its availability
+//   GET /events[?since=<revision>]  server-sent events, one per registry change
+// Responses carry the cluster revision as a weak ETag (weak because
+// last_seen_ms moves between revisions), so a poller sending If-None-Match
+// gets its 304 from one comparison, before the registry is touched.
+
+inline constexpr size_t HTTP_NODES_PER_CHUNK = 256;
+inline constexpr size_t EVENT_FEED_HISTORY = 1024;  // frames kept for reconnecting clients
+inline constexpr auto EVENT_FEED_PING = std::chrono::seconds(15);  // keeps idle proxies from timing out
+
+inline void write_node(tinykube::JsonWriter& json, const tinykube::NodeState& node) {
+    json.begin_object()
+        .field("name", node.name)
+        .field("tenant", node.tenant)
+        .field("peer", node.peer)
+        .field("status", tinykube::status_name(node.status))
+        .field("last_seen_ms", node.last_seen_ms)
+        .field("unschedulable", node.unschedulable)
+        .field("cpu_millis", node.capacity.cpu_millis)
+        .field("memory_mb", node.capacity.memory_mb)
+        .field("jitter_score", node.jitter.score());
+    json.key("labels").begin_object();
+    for (const auto& [key, value] : node.labels) {
+        json.field(key, value);
+    }
+    json.end_object().end_object();
+}
+
+inline void write_counts(tinykube::JsonWriter& json, const tinykube::ClusterSummary& counts) {
+    using tinykube::NodeStatus;
+    json.field("nodes", counts.nodes)
+        .field("ready", counts.count(NodeStatus::READY))
+        .field("degraded", counts.count(NodeStatus::DEGRADED))
+        .field("suspect", counts.count(NodeStatus::SUSPECT))
+        .field("not_ready", counts.count(NodeStatus::NOT_READY))
+        .field("unknown", counts.count(NodeStatus::UNKNOWN))
+        .field("unschedulable", counts.unschedulable)
+        .field("alive_cpu_millis", counts.alive_cpu_millis)
+        .field("alive_memory_mb", counts.alive_memory_mb);
+}
+
+inline void write_error(tinykube::HttpResponse& response, int status, const char* message) {
+    response.status = status;
+    tinykube::JsonWriter(response.body).begin_object().field("error", message).end_object();
+}
+
+// Turns registry changes into server-sent event frames. Each change is
+// serialized once, on this feed's thread, and the same buffer goes to every
+// subscriber. The last EVENT_FEED_HISTORY frames are kept so a reconnecting
+// EventSource (Last-Event-ID) or ?since= catches up from those buffers too.
+// Frames can repeat around a (re)connect; they carry whole node states, so
+// applying one twice is harmless.
+class EventFeed {
+public:
+    EventFeed(tinykube::WatchHub& hub, tinykube::HttpServer& server) : hub_(hub), server_(server) {
+        server_.set_overflow_frame(resync_frame());
+    }
+
+    ~EventFeed() {
+        stop();
+    }
+
+    void start() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            latest_ = hub_.revision();
+        }
+        running_ = true;
+        thread_ = std::thread([this] { run(); });
+    }
+
+    void stop() {
+        running_ = false;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    // Frames after `since`, or false if they are no longer all here and the
+    // client has to resync. Newer ones not yet fed through are on their way
+    // to every subscriber anyway. A `since` past even the hub's revision was
+    // handed out before a restart (revisions start over from 1), so it gets
+    // a resync too rather than waiting for a revision that means nothing.
+    bool catch_up(uint64_t since, std::vector<std::shared_ptr<const std::string>>& out) const {
+        if (since > hub_.revision()) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (since >= latest_) {
+            return true;
+        }
+        if (history_.empty() || history_.front().first > since + 1) {
+            return false;
+        }
+        for (const auto& [revision, frame] : history_) {
+            if (revision > since) {
+                out.push_back(frame);
+            }
+        }
+        return true;
+    }
+
+    // tells the client its view has a gap: refetch /nodes, keep listening
+    static const std::shared_ptr<const std::string>& resync_frame() {
+        static const auto frame = std::make_shared<const std::string>("event: resync\ndata: {}\n\n");
+        return frame;
+    }
+private:
+    void run() {
+        static const auto ping = std::make_shared<const std::string>(": ping\n\n");
+        std::vector<std::shared_ptr<const tinykube::WatchEvent>> events;
+        uint64_t since = latest_;
+        auto last_frame = std::chrono::steady_clock::now();
+        while (running_ && !hub_.closed()) {
+            events.clear();
+            bool resync = false;
+            if (!hub_.wait_events(since, events, std::chrono::seconds(1), resync)) {
+                if (resync) {
+                    // fell out of the hub's history: subscribers have a gap now
+                    since = hub_.revision();
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        history_.clear();
+                        latest_ = since;
+                    }
+                    server_.publish(resync_frame());
+                    last_frame = std::chrono::steady_clock::now();
+                } else if (std::chrono::steady_clock::now() - last_frame > EVENT_FEED_PING) {
+                    server_.publish(ping);
+                    last_frame = std::chrono::steady_clock::now();
+                }
+                continue;
+            }
+            for (const auto& event : events) {
+                auto frame = std::make_shared<const std::string>(encode(*event));
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    history_.emplace_back(event->revision, frame);
+                    if (history_.size() > EVENT_FEED_HISTORY) {
+                        history_.pop_front();
+                    }
+                    latest_ = event->revision;
+                }
+                server_.publish(std::move(frame));
+                since = event->revision;
+            }
+            last_frame = std::chrono::steady_clock::now();
+        }
+    }
+
+    std::string encode(const tinykube::WatchEvent& event) {
+        std::string frame = "id: " + std::to_string(event.revision) + "\nevent: change\ndata: ";
+        tinykube::JsonWriter json(frame);
+        json.begin_object().field("revision", event.revision).field("tenant", event.tenant).key("nodes").begin_array();
+        for (const auto& node : event.nodes) {
+            write_node(json, node);
+        }
+        json.end_array().key("removed").begin_array();
+        for (const auto& name : event.removed) {
+            json.value(name);
+        }
+        json.end_array().end_object();
+        frame += "\n\n";
+        return frame;
+    }
+
+    tinykube::WatchHub& hub_;
+    tinykube::HttpServer& server_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::deque<std::pair<uint64_t, std::shared_ptr<const std::string>>> history_;
+    uint64_t latest_{0};  // newest revision fed through
+};
+
+// Runs on the HTTP server's one thread, so the summary cache needs no lock.
+class HttpApi {
+public:
+    explicit HttpApi(tinykube::TenantRegistry& tenants) : tenants_(tenants) {}
+
+    void set_event_feed(const EventFeed* feed) {
+        feed_ = feed;
+    }
+
+    void handle(const tinykube::HttpRequest& request, tinykube::HttpResponse& response) {
+        std::string_view path = request.path;
+        if (path == "/events" && feed_ != nullptr) {
+            events(request, response);
+            return;
+        }
+        bool known = path == "/summary" || path == "/nodes" || (path.starts_with("/nodes/") && path.size() > 7);
+        if (!known) {
+            write_error(response, 404, "no such endpoint");
+            return;
+        }
+        uint64_t revision = tenants_.revision();
+        response.set_etag(revision);
+        if (request.not_modified(revision)) {
+            response.status = 304;
+            return;
+        }
+
+        if (path == "/summary") {
+            summary(revision, response);
+        } else if (path == "/nodes") {
+            list(request, revision, response);
+        } else {
+            node(request, path.substr(7), response);
+        }
+    }
+private:
+    // counts only change with the revision, so the rendered body is reused
+    // until it moves
+    void summary(uint64_t revision, tinykube::HttpResponse& response) {
+        if (summary_body_.empty() || summary_revision_ != revision) {
+            render_summary(revision);
+        }
+        response.body = summary_body_;
+    }
+
+    void render_summary(uint64_t revision) {
+        std::vector<tinykube::ClusterSummary> per_tenant;
+        tinykube::ClusterSummary total;
+        tenants_.for_each([&](tinykube::TenantPartition& partition) {
+            tinykube::ClusterSummary counts;
+            counts.name = partition.name;
+            partition.nodes.for_each_node([&](const tinykube::NodeState& node) {
+                counts.nodes++;
+                auto status = static_cast<size_t>(node.status);
+                if (status < counts.by_status.size()) {
+                    counts.by_status[status]++;
+                }
+                counts.unschedulable += node.unschedulable ? 1 : 0;
+                if (node.is_alive()) {
+                    counts.alive_cpu_millis += node.capacity.cpu_millis;
+                    counts.alive_memory_mb += node.capacity.memory_mb;
+                }
+            });
+            total.add(counts);
+            per_tenant.push_back(std::move(counts));
+        });
+        std::sort(per_tenant.begin(), per_tenant.end(),
+                  [](const auto& a, const auto& b) { return a.name < b.name; });
+
+        summary_body_.clear();
+        tinykube::JsonWriter json(summary_body_);
+        json.begin_object().field("revision", revision);
+        write_counts(json, total);
+        json.key("tenants").begin_array();
+        for (const auto& counts : per_tenant) {
+            json.begin_object().field("name", counts.name);
+            write_counts(json, counts);
+            json.end_object();
+        }
+        json.end_array().end_object();
+        summary_revision_ = revision;
+    }
+
+    // Partitions are copied one at a time as the client reads, and encoded
+    // HTTP_NODES_PER_CHUNK nodes per chunk, so neither the registry lock nor
+    // the response buffer grows with the cluster.
+    struct NodeListStream {
+        std::vector<tinykube::TenantPartition*> partitions;
+        size_t partition{0};
+        std::vector<tinykube::NodeState> nodes;
+        size_t next{0};
+        uint64_t revision{0};
+        bool opened{false};
+        bool written{false};  // an element is already out
+    };
+
+    void list(const tinykube::HttpRequest& request, uint64_t revision, tinykube::HttpResponse& response) {
+        auto stream = std::make_shared<NodeListStream>();
+        stream->revision = revision;
+        std::string tenant(request.query_param("tenant"));
+        if (!tenant.empty()) {
+            auto* partition = tenants_.find(tenant);
+            if (partition == nullptr) {
+                write_error(response, 404, "unknown tenant");
+                return;
+            }
+            stream->partitions.push_back(partition);
+        } else {
+            tenants_.for_each([&](tinykube::TenantPartition& partition) { stream->partitions.push_back(&partition); });
+        }
+        response.stream = [stream](std::string& out) { return next_chunk(*stream, out); };
+    }
+
+    static bool next_chunk(NodeListStream& stream, std::string& out) {
+        tinykube::JsonWriter json(out);
+        if (!stream.opened) {
+            json.begin_object().field("revision", stream.revision).key("nodes").begin_array();
+            stream.opened = true;
+        } else {
+            json.resume_array(!stream.written);
+        }
+        size_t encoded = 0;
+        while (encoded < HTTP_NODES_PER_CHUNK) {
+            if (stream.next == stream.nodes.size()) {
+                if (stream.partition == stream.partitions.size()) {
+                    out += "]}";
+                    return false;
+                }
+                stream.nodes = stream.partitions[stream.partition++]->nodes.snapshot();
+                stream.next = 0;
+                continue;
+            }
+            write_node(json, stream.nodes[stream.next++]);
+            stream.written = true;
+            encoded++;
+        }
+        return true;
+    }
+
+    // Without a starting point the stream is live only; a client that wants
+    // no gap takes /nodes first and subscribes with ?since=<its revision>.
+    void events(const tinykube::HttpRequest& request, tinykube::HttpResponse& response) {
+        response.content_type = "text/event-stream";
+        response.subscribe = true;
+        response.body = "retry: 2000\n\n";
+        uint64_t since = request.last_event_id;
+        bool resume = request.has_last_event_id;
+        if (!resume) {
+            auto param = request.query_param("since");
+            auto [end, ec] = std::from_chars(param.data(), param.data() + param.size(), since);
+            resume = !param.empty() && ec == std::errc() && end == param.data() + param.size();
+        }
+        if (resume && !feed_->catch_up(since, response.frames)) {
+            response.frames.assign(1, EventFeed::resync_frame());
+        }
+    }
+
+    void node(const tinykube::HttpRequest& request, std::string_view name, tinykube::HttpResponse& response) {
+        auto* partition = tenants_.find(std::string(request.query_param("tenant")));
+        std::string node_name(name);
+        auto node = partition != nullptr ? partition->nodes.get(node_name) : std::nullopt;
+        if (!node) {
+            write_error(response, 404, "node not found");
+            return;
+        }
+        tinykube::JsonWriter json(response.body);
+        json.begin_object().field("revision", response.etag_revision).key("node");
+        write_node(json, *node);
+        if (auto report = partition->nodes.availability(node_name, tinykube::now_ms())) {
+            json.key("availability")
+                .begin_object()
+                .field("1h", report->hour.ratio())
+                .field("1d", report->day.ratio())
+                .field("30d", report->month.ratio())
+                .end_object();
+        }
+        json.end_object();
+    }
+
+    tinykube::TenantRegistry& tenants_;
+    const EventFeed* feed_{nullptr};
+    std::string summary_body_;
+    uint64_t summary_revision_{0};
+};
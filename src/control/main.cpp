@@ -5,235 +5,474 @@
 #include <thread>
 #include <csignal>
 #include <atomic>
-#include <iomanip>
-#include <sstream>
+#include <charconv>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
 
-#include "control_plane.grpc.pb.h"
-#include "control_plane.pb.h"
-
-#include "tinykube/node_registry.hpp"
-#include "tinykube/time.hpp"
+#include "control/http_api.hpp"
+#include "control/service.hpp"
+#include "tinykube/shm_channel.hpp"
+#include "tinykube/tls.hpp"
+#include "tinykube/uring_server.hpp"
 
 using grpc::Server;
 using grpc::ServerBuilder;
-using grpc::ServerContext;
-using grpc::ServerReader;
-using grpc::Status;
-
-const int64_t HEARTBEAT_TIMEOUT_MS = 3000; // 3 seconds
-const int64_t NOT_READY_TIMEOUT_MS = 10000; // 10 seconds
 
-std::atomic<bool> g_running{true};
 std::unique_ptr<Server> g_server;
 
-// Utility functions for pretty printing
-std::string status_to_string(tinykube::NodeStatus status) {
-    switch (status) {
-        case tinykube::NodeStatus::RESERVED:   return "RESERVED";
-        case tinykube::NodeStatus::READY:      return "READY";
-        case tinykube::NodeStatus::NOT_READY:  return "NOT_READY";
-        case tinykube::NodeStatus::SUSPECT:    return "SUSPECT";
-        case tinykube::NodeStatus::UNKNOWN:    return "UNKNOWN";
-        default:                               return "INVALID";
+// closes the fd on every way out of the scope holding it
+struct ScopedFd {
+    int fd;
+    ~ScopedFd() {
+        if (fd >= 0) {
+            close(fd);
+        }
     }
-}
+};
 
-std::string status_to_emoji(tinykube::NodeStatus status) {
-    switch (status) {
-        case tinykube::NodeStatus::RESERVED:   return "🔒";
-        case tinykube::NodeStatus::READY:      return "✅";
-        case tinykube::NodeStatus::NOT_READY:  return "⏳";
-        case tinykube::NodeStatus::SUSPECT:    return "⚠️";
-        case tinykube::NodeStatus::UNKNOWN:    return "❓";
-        default:                               return "❌";
+// Re-reads the file from the defaults, so a key deleted from it reverts.
+// A bad file leaves the running config alone. `listen_override` is -l, which
+// wins over the file here just as at startup.
+void reload_config(const std::string& path, const std::string& listen_override, ConfigStore& store) {
+    ControlPlaneConfig config;
+    std::string error;
+    if (!load_config(path, config, error)) {
+        std::cerr << "❌ Error: not reloading " << path << ": " << error << std::endl;
+        return;
     }
+    if (!listen_override.empty()) {
+        config.listen = listen_override;
+    }
+    const auto& current = store.current();
+    if (config.listen != current.listen) {
+        std::cout << "⚠️ listen changed to " << config.listen << ", which takes a restart" << std::endl;
+        config.listen = current.listen;
+    }
+    auto changes = config_changes(current, config);
+    store.publish(std::move(config));
+    std::cout << "🔧 Reloaded " << path << ":";
+    for (const auto& change : changes) {
+        std::cout << " " << change << ";";
+    }
+    std::cout << (changes.empty() ? " nothing changed" : "") << std::endl;
 }
 
-std::string format_time_ago(int64_t last_seen_ms, int64_t current_ms) {
-    int64_t diff_ms = current_ms - last_seen_ms;
-    
-    if (diff_ms < 1000) {
-        return "just now";
-    } else if (diff_ms < 60000) {
-        return std::to_string(diff_ms / 1000) + "s ago";
-    } else if (diff_ms < 3600000) {
-        return std::to_string(diff_ms / 60000) + "m ago";
-    } else {
-        return std::to_string(diff_ms / 3600000) + "h ago";
-    }
+void print_usage(const char* program_name) {
+    std::cout << "🚀 TinyKube Control Plane\n" << std::endl;
+    std::cout << "Usage: " << program_name << " [OPTIONS]" << std::endl;
+    std::cout << "\nOptions:" << std::endl;
+    std::cout << "  -l, --listen <address>    Address to listen on (default: 0.0.0.0:50051)" << std::endl;
+    std::cout << "  --config <file>           Read tunables (timeouts, periods, listen) from a key = value file;" << std::endl;
+    std::cout << "                            kill -HUP reloads it, command-line flags win over it" << std::endl;
+    std::cout << "  -c, --capture <file>      Record registrations and heartbeats for tinykube_replay" << std::endl;
+    std::cout << "  --cron-journal <file>     Persist cron jobs here (default: " << CRON_JOURNAL_PATH << " in the working directory," << std::endl;
+    std::cout << "                            \"\" keeps them in memory only)" << std::endl;
+    std::cout << "  -f, --frames <address>    Also take fixed-size heartbeat frames over io_uring (host:port or unix:/path)" << std::endl;
+    std::cout << "  --shm <socket path>       Hand out shared-memory heartbeat rings to same-host agents and relays" << std::endl;
+    std::cout << "  --http <address>          Serve read-only JSON at /nodes, /nodes/<name>, /summary and /events (SSE), e.g. 0.0.0.0:8080" << std::endl;
+    std::cout << "  --http-max-connections <n>" << std::endl;
+    std::cout << "                            Request connections the HTTP server holds open (default: 1024)" << std::endl;
+    std::cout << "  --http-max-streams <n>    Event streams (/events subscribers) it holds open besides (default: 16384)" << std::endl;
+    std::cout << "  --report-memory           Log registry memory use every monitor cycle (walks every node)" << std::endl;
+    std::cout << "  --ingest-cpu <n>          Busy-poll heartbeat ingestion on this (isolated) CPU" << std::endl;
+    std::cout << "  --rpc-cpus <list>         Pin gRPC handler threads, e.g. 2-5" << std::endl;
+    std::cout << "  --monitor-cpus <list>     Pin the sweep and render thread, e.g. 6" << std::endl;
+    std::cout << "  --auth-key <file>         Require HMAC node tokens (mint bootstrap tokens with tinykubectl token)" << std::endl;
+    std::cout << "  --allow-unauthenticated-frames" << std::endl;
+    std::cout << "                            Let --frames and --shm run with --auth-key; they carry no tokens, so anyone" << std::endl;
+    std::cout << "                            who reaches them can heartbeat as any node" << std::endl;
+    std::cout << "  --max-tenants <n>         Refuse registrations that would create more tenants (default: 1024)" << std::endl;
+    std::cout << "  --tls-ca <file>           Require client certificates signed by this CA (mutual TLS)" << std::endl;
+    std::cout << "  --tls-cert <file>         Server certificate (see scripts/gen-certs.sh)" << std::endl;
+    std::cout << "  --tls-key <file>          Server private key" << std::endl;
+    std::cout << "  -h, --help                Show this help message" << std::endl;
 }
 
-void print_node_table(const std::vector<tinykube::NodeState>& nodes) {
-    if (nodes.empty()) {
-        std::cout << "\n📭 No nodes registered yet\n" << std::endl;
-        return;
+int main(int argc, char* argv[]) {
+    std::string server_address;
+    std::string config_path;
+    ControlPlaneOptions options;
+    std::vector<int> monitor_cpus;
+    std::string frames_address;
+    std::string shm_path;
+    std::string http_address;
+    tinykube::HttpServerLimits http_limits;
+    bool allow_unauthenticated_frames = false;
+    tinykube::TlsFiles tls;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else if (arg == "-l" || arg == "--listen") {
+            if (i + 1 < argc) {
+                server_address = argv[++i];
+            } else {
+                std::cerr << "❌ Error: --listen requires a value" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--config") {
+            if (i + 1 < argc) {
+                config_path = argv[++i];
+            } else {
+                std::cerr << "❌ Error: --config requires a value" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "-c" || arg == "--capture") {
+            if (i + 1 < argc) {
+                options.capture_path = argv[++i];
+            } else {
+                std::cerr << "❌ Error: --capture requires a value" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--cron-journal") {
+            if (i + 1 < argc) {
+                options.cron_journal_path = argv[++i];
+            } else {
+                std::cerr << "❌ Error: --cron-journal requires a value" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "-f" || arg == "--frames") {
+            if (i + 1 < argc) {
+                frames_address = argv[++i];
+            } else {
+                std::cerr << "❌ Error: --frames requires a value" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--http") {
+            if (i + 1 < argc) {
+                http_address = argv[++i];
+            } else {
+                std::cerr << "❌ Error: --http requires a value" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--shm") {
+            if (i + 1 < argc) {
+                shm_path = argv[++i];
+            } else {
+                std::cerr << "❌ Error: --shm requires a value" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--http-max-connections" || arg == "--http-max-streams") {
+            std::string_view value = i + 1 < argc ? argv[++i] : "";
+            size_t limit = 0;
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), limit);
+            if (ec == std::errc() && end == value.data() + value.size() && limit > 0) {
+                (arg == "--http-max-connections" ? http_limits.max_connections : http_limits.max_subscribers) = limit;
+            } else {
+                std::cerr << "❌ Error: " << arg << " requires a positive number" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--report-memory") {
+            options.report_memory = true;
+        }
+        else if (arg == "--ingest-cpu") {
+            std::vector<int> cpus;
+            if (i + 1 < argc && tinykube::parse_cpu_list(argv[++i], cpus) && cpus.size() == 1) {
+                options.ingest_cpu = cpus.front();
+            } else {
+                std::cerr << "❌ Error: --ingest-cpu requires a single CPU number" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--rpc-cpus" || arg == "--monitor-cpus") {
+            auto& cpus = arg == "--rpc-cpus" ? options.rpc_cpus : monitor_cpus;
+            if (i + 1 >= argc || !tinykube::parse_cpu_list(argv[++i], cpus)) {
+                std::cerr << "❌ Error: " << arg << " requires a CPU list like 0-3,8" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--auth-key") {
+            std::string error;
+            if (i + 1 >= argc || !tinykube::read_auth_key(argv[++i], options.auth_key, error)) {
+                std::cerr << "❌ Error: --auth-key requires a key file" << (error.empty() ? "" : ": " + error) << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--allow-unauthenticated-frames") {
+            allow_unauthenticated_frames = true;
+        }
+        else if (arg == "--max-tenants") {
+            std::string_view value = i + 1 < argc ? argv[++i] : "";
+            size_t max_tenants = 0;
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), max_tenants);
+            if (ec == std::errc() && end == value.data() + value.size() && max_tenants > 0) {
+                options.max_tenants = max_tenants;
+            } else {
+                std::cerr << "❌ Error: --max-tenants requires a positive number" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--tls-ca" || arg == "--tls-cert" || arg == "--tls-key") {
+            if (i + 1 < argc) {
+                (arg == "--tls-ca" ? tls.ca : arg == "--tls-cert" ? tls.cert : tls.key) = argv[++i];
+            } else {
+                std::cerr << "❌ Error: " << arg << " requires a file" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else {
+            std::cerr << "❌ Error: Unknown argument '" << arg << "'" << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
     }
 
-    int64_t current_time = tinykube::now_ms();
-    
-    std::cout << "\n┌─────────────────────────────────────────────────────────────────────────┐" << std::endl;
-    std::cout << "│                           🖥️  TinyKube Cluster Status                    │" << std::endl;
-    std::cout << "├─────────────────────────────────────────────────────────────────────────┤" << std::endl;
-    std::cout << "│ Node Name        │ Status     │ Peer Address         │ Last Seen      │" << std::endl;
-    std::cout << "├─────────────────────────────────────────────────────────────────────────┤" << std::endl;
-    
-    for (const auto& node : nodes) {
-        std::cout << "│ " 
-                  << std::left << std::setw(16) << node.name << " │ "
-                  << status_to_emoji(node.status) << " " << std::left << std::setw(8) << status_to_string(node.status) << " │ "
-                  << std::left << std::setw(20) << node.peer << " │ "
-                  << std::left << std::setw(14) << format_time_ago(node.last_seen_ms, current_time) << " │"
-                  << std::endl;
+    // SIGINT, SIGTERM and SIGHUP are taken from a signalfd by the terminator
+    // thread; blocked before any thread starts, so every thread inherits it
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    ScopedFd signal_fd{signalfd(-1, &signals, SFD_CLOEXEC)};
+    if (signal_fd.fd < 0) {
+        std::cerr << "❌ Error: signalfd failed" << std::endl;
+        return 1;
     }
-    
-    std::cout << "└─────────────────────────────────────────────────────────────────────────┘" << std::endl;
-    
-    // Summary statistics
-    int ready_count = 0, suspect_count = 0, not_ready_count = 0, other_count = 0;
-    for (const auto& node : nodes) {
-        switch (node.status) {
-            case tinykube::NodeStatus::READY:     ready_count++; break;
-            case tinykube::NodeStatus::SUSPECT:   suspect_count++; break;
-            case tinykube::NodeStatus::NOT_READY: not_ready_count++; break;
-            default:                              other_count++; break;
+
+    ControlPlaneConfig config;
+    if (!config_path.empty()) {
+        std::string error;
+        if (!load_config(config_path, config, error)) {
+            std::cerr << "❌ Error: " << config_path << ": " << error << std::endl;
+            return 1;
         }
     }
-    
-    std::cout << "📊 Summary: " 
-              << ready_count << " ready, "
-              << suspect_count << " suspect, "
-              << not_ready_count << " not ready, "
-              << other_count << " other"
-              << " (total: " << nodes.size() << " nodes)\n" << std::endl;
-}
+    const std::string listen_override = server_address;
+    if (!listen_override.empty()) {
+        config.listen = listen_override;
+    }
+    server_address = config.listen;
 
-class ControlPlaneServiceImpl final : public tinykube::ControlPlane::Service {
-public:
-    Status RegisterNode(ServerContext* context, 
-                       const tinykube::RegisterRequest* request,
-                       tinykube::RegisterResponse* response) override {
-        
-        const std::string& node_name = request->node().name();
-        
-        // Validate node name
-        if (node_name.empty()) {
-            std::cout << "❌ Registration rejected: empty node name from " << context->peer() << std::endl;
-            response->set_accepted(false);
-            response->set_reason("Node name cannot be empty");
-            return Status::OK;
-        }
-                        
-        std::cout << "📋 Node registration request received from: " 
-                  << node_name << "(" << context->peer() << ")" << std::endl;
-
-        // Check if node already exists
-        if (node_registry_.exists(node_name)) {
-            std::cout << "⚠️ Node " << node_name << " already registered, updating..." << std::endl;
-        }
-
-        tinykube::NodeState node_state;
-        node_state.name = node_name;
-        node_state.peer = context->peer();
-        node_state.last_seen_ms = tinykube::now_ms();
-        node_state.status = tinykube::NodeStatus::READY;
-        node_registry_.upsert(node_state);
-        
-        // Accept the node
-        response->set_accepted(true);
-        response->set_reason("Welcome to TinyKube cluster!");
-        
-        std::cout << "✅ Node " << node_name << " registered successfully (total: " 
-                  << node_registry_.size() << " nodes)" << std::endl;
-        
-        return Status::OK;
+    if (!options.auth_key.empty() && (!frames_address.empty() || !shm_path.empty())) {
+        if (!allow_unauthenticated_frames) {
+            std::cerr << "❌ Error: --frames and --shm carry no node tokens and would bypass --auth-key;" << std::endl;
+            std::cerr << "   pass --allow-unauthenticated-frames if only trusted producers can reach them" << std::endl;
+            return 1;
+        }
+        std::cout << "⚠️ Heartbeat frames and shared-memory rings carry no tokens; only trusted producers should reach them" << std::endl;
     }
-    
-    Status StreamHeartbeats(ServerContext* context,
-                           ServerReader<tinykube::Heartbeat>* reader,
-                           tinykube::Empty* response) override {
-        
-        std::cout << "💓 Starting heartbeat stream from " << context->peer() << std::endl;
-        
-        tinykube::Heartbeat heartbeat;
-        int heartbeat_count = 0;
-        
-        while (reader->Read(&heartbeat)) {
-            const std::string& node_name = heartbeat.node_name();
-            
-            // Validate that the node is registered
-            if (!node_registry_.exists(node_name)) {
-                std::cout << "⚠️ Received heartbeat from unregistered node: " << node_name << std::endl;
-                continue;  // Ignore heartbeats from unknown nodes
-            }
-            
-            node_registry_.touch(node_name, tinykube::now_ms());
-            heartbeat_count++;
-            
-            std::cout << "💗 Heartbeat #" << heartbeat_count << " from " << node_name 
-                      << " (client time: " << heartbeat.now_unix_ms() << "ms)" << std::endl;
-            
-            if (!g_running.load()) {
-                std::cout << "🛑 Server is shutting down, ending heartbeat stream..." << std::endl;
-                break;
-            }
+
+    if (!options.cron_journal_path.empty()) {
+        // resolved once, so the log says where jobs live and a later chdir can't move it
+        std::error_code ec;
+        auto absolute = std::filesystem::absolute(options.cron_journal_path, ec);
+        if (!ec) {
+            options.cron_journal_path = absolute.string();
         }
-        
-        std::cout << "💔 Heartbeat stream ended (received " << heartbeat_count 
-                  << " heartbeats)" << std::endl;
-        return Status::OK;
     }
-    void monitor_nodes() {
-        node_registry_.sweep(tinykube::now_ms(), HEARTBEAT_TIMEOUT_MS, NOT_READY_TIMEOUT_MS);
-        
-        auto nodes = node_registry_.snapshot();
-        
-        // Print the beautiful table
-        print_node_table(nodes);
+
+    std::string tls_error;
+    auto credentials = tinykube::server_credentials(tls, tls_error);
+    if (!credentials) {
+        std::cerr << "❌ Error: " << tls_error << std::endl;
+        return 1;
     }
-private:
-    tinykube::NodeRegistry node_registry_;
-};
 
-void signal_handler(int signal) {
-    std::cout << "\n🛑 Received signal " << signal << ", shutting down gracefully..." << std::endl;
-    g_running.store(false);
-}
+    if (options.ingest_cpu >= 0) {
+        // registry shards are allocated as tenants appear, from threads created
+        // after this, so they land on the ingestion core's node
+        int node = tinykube::numa_node_of_cpu(options.ingest_cpu);
+        if (node >= 0 && tinykube::prefer_numa_node(node)) {
+            std::cout << "🧭 Preferring memory from NUMA node " << node << std::endl;
+        }
+    }
 
-int main() {
-    std::string server_address("0.0.0.0:50051");
-    ControlPlaneServiceImpl service;
+    ControlPlaneServiceImpl service(options);
+    if (!service.startup_error().empty()) {
+        std::cerr << "❌ Error: " << service.startup_error() << std::endl;
+        service.shutdown();
+        return 1;
+    }
+    service.config().publish(config);
 
     ServerBuilder builder;
-    builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
+    builder.AddListeningPort(server_address, credentials);
     builder.RegisterService(&service);
     
     g_server = builder.BuildAndStart();
+    if (!g_server) {
+        std::cerr << "❌ Error: could not listen on " << server_address << std::endl;
+        service.shutdown();
+        return 1;
+    }
     
+    tinykube::UringHeartbeatServer frames([&service](const tinykube::HeartbeatFrame* batch, size_t count, int64_t now) {
+        service.ingest_frames(batch, count, now);
+    });
+    if (!frames_address.empty()) {
+        std::string error;
+        if (!frames.start(frames_address, error)) {
+            std::cerr << "❌ Error: could not take heartbeat frames on " << frames_address << ": " << error << std::endl;
+            service.shutdown();
+            g_server->Shutdown();
+            return 1;
+        }
+        std::cout << "📨 Taking heartbeat frames on " << frames_address << " (io_uring)" << std::endl;
+    }
+
+    tinykube::ShmHeartbeatServer shm([&service](const tinykube::HeartbeatFrame* batch, size_t count, int64_t now) {
+        service.ingest_frames(batch, count, now);
+    });
+    if (!shm_path.empty()) {
+        std::string error;
+        if (!shm.start(shm_path, error)) {
+            std::cerr << "❌ Error: could not take shared-memory producers on " << shm_path << ": " << error << std::endl;
+            frames.stop();
+            service.shutdown();
+            g_server->Shutdown();
+            return 1;
+        }
+        std::cout << "🧵 Shared-memory heartbeat rings on " << shm_path << std::endl;
+    }
+
+    HttpApi api(service.tenants());
+    tinykube::HttpServer http([&api](const tinykube::HttpRequest& request, tinykube::HttpResponse& response) {
+        api.handle(request, response);
+    }, http_limits);
+    EventFeed feed(service.tenants().watch_hub(), http);
+    api.set_event_feed(&feed);
+    if (!http_address.empty()) {
+        // every connection and stream is an fd; take what the hard limit allows
+        rlimit files{};
+        if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur < files.rlim_max) {
+            files.rlim_cur = files.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &files);
+        }
+        if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur != RLIM_INFINITY &&
+            files.rlim_cur < http_limits.max_connections + http_limits.max_subscribers) {
+            std::cout << "⚠️ Only " << files.rlim_cur << " file descriptors for " << http_limits.max_connections
+                      << " HTTP connections and " << http_limits.max_subscribers
+                      << " event streams; raise ulimit -n to reach them" << std::endl;
+        }
+        std::string error;
+        if (!http.start(http_address, error)) {
+            std::cerr << "❌ Error: could not serve HTTP on " << http_address << ": " << error << std::endl;
+            shm.stop();
+            frames.stop();
+            service.shutdown();
+            g_server->Shutdown();
+            return 1;
+        }
+        feed.start();
+        std::cout << "🌍 Read-only JSON API on http://" << http_address << "/summary" << std::endl;
+    }
+
     std::cout << "🚀 TinyKube Control Plane server listening on " << server_address << std::endl;
+    if (tls.enabled()) {
+        std::cout << "🔐 Mutual TLS: clients need a certificate signed by " << tls.ca << std::endl;
+    }
+    if (options.cron_journal_path.empty()) {
+        std::cout << "🗓️ Cron jobs are kept in memory only" << std::endl;
+    } else {
+        std::cout << "🗓️ Cron journal: " << options.cron_journal_path << std::endl;
+    }
     std::cout << "📡 Ready to accept node registrations and heartbeats!" << std::endl;
     std::cout << "🛑 Press Ctrl+C to stop" << std::endl;
     
-    std::signal(SIGINT, signal_handler);
-    std::signal(SIGTERM, signal_handler);
-    
+    std::mutex stop_mutex;
+    std::condition_variable stop_cv;
+    bool stopping = false;
+
     std::thread server_thread([&]{ g_server->Wait(); });
     std::thread monitor([&]{
+        tinykube::pin_current_thread(monitor_cpus);
         int monitor_cycle = 0;
-        while (g_running.load()) {
+        while (true) {
             monitor_cycle++;
             std::cout << "\n🔍 Cluster Health Check #" << monitor_cycle 
                       << " (" << tinykube::now_ms() << ")" << std::endl;
             service.monitor_nodes();
-            std::this_thread::sleep_for(std::chrono::seconds(5));
+            if (!frames_address.empty()) {
+                auto stats = frames.stats();
+                std::cout << "📨 Frames: " << stats.frames << " heartbeats over " << stats.open << " connections, "
+                          << stats.enters << " io_uring_enter calls, " << stats.bad_frames << " bad, "
+                          << stats.accept_errors << " failed accepts" << std::endl;
+            }
+            if (!shm_path.empty()) {
+                auto stats = shm.stats();
+                std::cout << "🧵 Shared memory: " << stats.frames << " heartbeats from " << stats.producers
+                          << " producers (" << stats.refused << " refused), consumer slept " << stats.sleeps << " times, "
+                          << stats.bad_frames << " bad" << std::endl;
+            }
+            if (!http_address.empty()) {
+                auto stats = http.stats();
+                std::cout << "🌍 HTTP: " << stats.requests << " requests (" << stats.not_modified << " not modified, "
+                          << stats.streamed << " streamed) over " << stats.open << " connections, "
+                          << stats.subscribers << " event subscribers (" << stats.overflows << " resyncs), "
+                          << stats.refused_streams << " streams refused, " << stats.idle_closed << " closed idle"
+                          << std::endl;
+            }
+            std::unique_lock<std::mutex> lock(stop_mutex);
+            auto period = std::chrono::milliseconds(service.config().current().monitor_period_ms);
+            if (stop_cv.wait_for(lock, period, [&] { return stopping; })) {
+                break;
+            }
         }
     });
+    // Sleeps in read() until a signal arrives. Shutdown stops taking new
+    // work, ends the watch and heartbeat streams, then gives unary RPCs
+    // still in flight drain_timeout_ms before gRPC cancels them.
     std::thread terminator([&](){
-        while (g_running.load(std::memory_order_relaxed)) {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+        signalfd_siginfo info;
+        while (read(signal_fd.fd, &info, sizeof(info)) == sizeof(info)) {
+            if (info.ssi_signo != SIGHUP) {
+                std::cout << "\n🛑 Received signal " << info.ssi_signo << ", shutting down gracefully..." << std::endl;
+                break;
+            }
+            if (config_path.empty()) {
+                std::cout << "⚠️ SIGHUP without --config, nothing to reload" << std::endl;
+            } else {
+                reload_config(config_path, listen_override, service.config());
+            }
         }
+        auto started = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(stop_mutex);
+            stopping = true;
+        }
+        stop_cv.notify_all();
+        frames.stop();
+        shm.stop();
+        service.shutdown();  // closes the watch hub first, so the event feed isn't left waiting on it
+        feed.stop();
+        http.stop();
         if (g_server) {
-            g_server->Shutdown();
+            auto drain = std::chrono::milliseconds(service.config().current().drain_timeout_ms);
+            g_server->Shutdown(std::chrono::system_clock::now() + drain);
         }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+        std::cout << "🚪 Drained in " << elapsed.count() << "ms" << std::endl;
     });
 
     server_thread.join();
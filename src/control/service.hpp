@@ -0,0 +1,911 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+
+#include "control_plane.grpc.pb.h"
+#include "control_plane.pb.h"
+
+#include "control/config.hpp"
+#include "tinykube/capture.hpp"
+#include "tinykube/cpu_profiler.hpp"
+#include "tinykube/cron_engine.hpp"
+#include "tinykube/fair_queue.hpp"
+#include "tinykube/heartbeat_frame.hpp"
+#include "tinykube/ingest.hpp"
+#include "tinykube/lock_profile.hpp"
+#include "tinykube/node_columns.hpp"
+#include "tinykube/node_auth.hpp"
+#include "tinykube/node_record.hpp"
+#include "tinykube/scheduler.hpp"
+#include "tinykube/tenant_registry.hpp"
+#include "tinykube/time.hpp"
+#include "tinykube/trace.hpp"
+
+// The control plane's gRPC service, shared by tinykube_control and the
+// offline tools (replay, benchmarks) that drive the real implementation.
+
+using grpc::ServerContext;
+using grpc::ServerReader;
+using grpc::ServerWriter;
+using grpc::Status;
+
+inline constexpr const char* CRON_JOURNAL_PATH = "tinykube-cron.journal";
+inline constexpr size_t EXPORT_CHUNK_BYTES = 1 << 20;  // well under gRPC's 4 MiB message cap
+
+struct ControlPlaneOptions {
+    std::string cron_journal_path{CRON_JOURNAL_PATH};
+    std::string capture_path;  // record RegisterNode and Heartbeat traffic here when set
+    bool verbose{true};        // a log line per registration and heartbeat
+    bool report_memory{false}; // log registry memory each monitor cycle; it walks every node under the partition locks
+    int ingest_cpu{-1};        // busy-poll heartbeats on this core, -1 applies them on the RPC thread
+    std::vector<int> rpc_cpus; // affinity of the gRPC handler threads, empty leaves them alone
+    std::string auth_key;      // HMAC key for node tokens, empty lets anyone register or heartbeat as any node
+    size_t max_tenants{tinykube::DEFAULT_MAX_TENANTS};  // tenants registrations may create
+};
+
+enum class HeartbeatResult { ACCEPTED, UNKNOWN, THROTTLED };
+
+// An empty selector matches every node, so it has to say so explicitly;
+// otherwise one bare RPC could cordon or relabel the whole tenant.
+inline bool selects_something(const tinykube::NodeSelectorSpec& spec) {
+    return spec.all() || spec.names_size() > 0 || spec.match_labels_size() > 0;
+}
+
+// Utility functions for pretty printing
+inline std::string status_to_emoji(tinykube::NodeStatus status) {
+    switch (status) {
+        case tinykube::NodeStatus::RESERVED:   return "🔒";
+        case tinykube::NodeStatus::READY:      return "✅";
+        case tinykube::NodeStatus::NOT_READY:  return "⏳";
+        case tinykube::NodeStatus::SUSPECT:    return "⚠️";
+        case tinykube::NodeStatus::UNKNOWN:    return "❓";
+        case tinykube::NodeStatus::DEGRADED:   return "📉";
+        default:                               return "❌";
+    }
+}
+
+inline std::string format_time_ago(int64_t last_seen_ms, int64_t current_ms) {
+    int64_t diff_ms = current_ms - last_seen_ms;
+    
+    if (diff_ms < 1000) {
+        return "just now";
+    } else if (diff_ms < 60000) {
+        return std::to_string(diff_ms / 1000) + "s ago";
+    } else if (diff_ms < 3600000) {
+        return std::to_string(diff_ms / 60000) + "m ago";
+    } else {
+        return std::to_string(diff_ms / 3600000) + "h ago";
+    }
+}
+
+inline void print_node_table(const std::vector<tinykube::NodeState>& nodes) {
+    if (nodes.empty()) {
+        std::cout << "\n📭 No nodes registered yet\n" << std::endl;
+        return;
+    }
+
+    int64_t current_time = tinykube::now_ms();
+    
+    std::cout << "\n┌─────────────────────────────────────────────────────────────────────────┐" << std::endl;
+    std::cout << "│                           🖥️  TinyKube Cluster Status                    │" << std::endl;
+    std::cout << "├─────────────────────────────────────────────────────────────────────────┤" << std::endl;
+    std::cout << "│ Node Name        │ Status     │ Peer Address         │ Last Seen      │" << std::endl;
+    std::cout << "├─────────────────────────────────────────────────────────────────────────┤" << std::endl;
+    
+    for (const auto& node : nodes) {
+        std::cout << "│ " 
+                  << std::left << std::setw(16) << (node.tenant == tinykube::DEFAULT_TENANT ? node.name : node.tenant + "/" + node.name) << " │ "
+                  << status_to_emoji(node.status) << " " << std::left << std::setw(8) << tinykube::status_name(node.status) << " │ "
+                  << std::left << std::setw(20) << node.peer << " │ "
+                  << std::left << std::setw(14) << format_time_ago(node.last_seen_ms, current_time) << " │"
+                  << std::endl;
+    }
+    
+    std::cout << "└─────────────────────────────────────────────────────────────────────────┘" << std::endl;
+    
+    // Summary statistics
+    int ready_count = 0, degraded_count = 0, suspect_count = 0, not_ready_count = 0, other_count = 0;
+    for (const auto& node : nodes) {
+        switch (node.status) {
+            case tinykube::NodeStatus::READY:     ready_count++; break;
+            case tinykube::NodeStatus::DEGRADED:  degraded_count++; break;
+            case tinykube::NodeStatus::SUSPECT:   suspect_count++; break;
+            case tinykube::NodeStatus::NOT_READY: not_ready_count++; break;
+            default:                              other_count++; break;
+        }
+    }
+    
+    std::cout << "📊 Summary: " 
+              << ready_count << " ready, "
+              << degraded_count << " degraded, "
+              << suspect_count << " suspect, "
+              << not_ready_count << " not ready, "
+              << other_count << " other"
+              << " (total: " << nodes.size() << " nodes)\n" << std::endl;
+}
+
+class ControlPlaneServiceImpl final : public tinykube::ControlPlane::Service {
+public:
+    explicit ControlPlaneServiceImpl(const ControlPlaneOptions& options = {})
+        : verbose_(options.verbose),
+          report_memory_(options.report_memory),
+          rpc_cpus_(options.rpc_cpus),
+          tenants_({}, options.max_tenants),
+          cron_(options.cron_journal_path,
+                [this](const tinykube::CronJob& job, int64_t fire_ms) { fire_cron_job(job, fire_ms); }) {
+        if (!options.capture_path.empty()) {
+            capture_ = std::make_unique<tinykube::CaptureWriter>(options.capture_path);
+            std::cout << "🎥 Capturing registrations and heartbeats to " << options.capture_path << std::endl;
+        }
+        if (!options.auth_key.empty()) {
+            auth_ = std::make_unique<tinykube::NodeAuthority>(options.auth_key);
+            std::cout << "🔑 Nodes must present bootstrap and session tokens" << std::endl;
+        }
+        if (options.ingest_cpu >= 0) {
+            ingest_ = std::make_unique<tinykube::HeartbeatIngest>(options.ingest_cpu);
+            if (ingest_->start(startup_error_)) {
+                std::cout << "⚡ Heartbeat ingestion busy-polling on CPU " << options.ingest_cpu << std::endl;
+            } else {
+                ingest_.reset();
+            }
+        }
+        cron_.start();
+    }
+
+    Status RegisterNode(ServerContext* context, 
+                       const tinykube::RegisterRequest* request,
+                       tinykube::RegisterResponse* response) override {
+        TK_TRACE_SPAN("rpc.RegisterNode");
+        pin_rpc_thread();
+        
+        const std::string& node_name = request->node().name();
+        
+        // Validate node name
+        if (node_name.empty()) {
+            std::cout << "❌ Registration rejected: empty node name from " << context->peer() << std::endl;
+            response->set_accepted(false);
+            response->set_reason("Node name cannot be empty");
+            return Status::OK;
+        }
+        if (auth_ && !auth_->check_bootstrap(request->node().tenant(), node_name, request->bootstrap_token())) {
+            std::cout << "🔑 Registration of " << node_name << " rejected: bad bootstrap token from "
+                      << context->peer() << std::endl;
+            response->set_accepted(false);
+            response->set_reason("Invalid bootstrap token");
+            return Status::OK;
+        }
+                        
+        if (verbose_) {
+            std::cout << "📋 Node registration request received from: " 
+                      << node_name << "(" << context->peer() << ")" << std::endl;
+        }
+        if (capture_) {
+            tinykube::CaptureRecord record;
+            record.type = tinykube::CaptureType::REGISTER;
+            record.tenant = request->node().tenant();
+            record.node = node_name;
+            record.cpu_millis = request->node().cpu_millis();
+            record.memory_mb = request->node().memory_mb();
+            capture_->record(std::move(record));
+        }
+
+        if (!running_.load()) {
+            return Status(grpc::StatusCode::UNAVAILABLE, "control plane is shutting down");
+        }
+        auto* admitted = tenants_.admit(request->node().tenant());
+        if (admitted == nullptr) {
+            std::cout << "🚫 Registration of " << node_name << " refused: too many tenants, and "
+                      << request->node().tenant() << " has no configured quota" << std::endl;
+            response->set_accepted(false);
+            response->set_reason("Unknown tenant and the control plane is at its tenant limit");
+            return Status::OK;
+        }
+        auto& partition = *admitted;
+        if (!partition.registrations.try_acquire(tinykube::now_ms())) {
+            std::cout << "🚦 Registration of " << node_name << " throttled: tenant "
+                      << partition.name << " is over its registration rate" << std::endl;
+            response->set_accepted(false);
+            response->set_reason("Tenant registration rate exceeded, retry later");
+            return Status::OK;
+        }
+
+        tinykube::NodeState node_state;
+        node_state.name = node_name;
+        node_state.tenant = partition.name;
+        node_state.peer = context->peer();
+        node_state.status = tinykube::NodeStatus::READY;
+        node_state.capacity.cpu_millis = request->node().cpu_millis();
+        node_state.capacity.memory_mb = request->node().memory_mb();
+
+        // The registry write goes through the fair queue, so when many tenants
+        // register at once each gets its turn at the registry. This gRPC thread
+        // still waits for the result: what keeps one tenant from tying up the
+        // thread pool is its registration rate limit above, not the queue.
+        std::promise<bool> accepted;
+        auto done = accepted.get_future();
+        bool queued = work_queue_.submit(partition.name, [&] {
+            // Check if node already exists
+            if (partition.nodes.exists(node_name) && verbose_) {
+                std::cout << "⚠️ Node " << node_name << " already registered, updating..." << std::endl;
+            }
+            node_state.last_seen_ms = tinykube::now_ms();
+            accepted.set_value(partition.nodes.upsert(node_state, partition.max_nodes.load(std::memory_order_relaxed)));
+        });
+        if (!queued && !running_.load()) {
+            return Status(grpc::StatusCode::UNAVAILABLE, "control plane is shutting down");  // stopped since the check above
+        }
+        if (!queued) {
+            response->set_accepted(false);
+            response->set_reason("Tenant work queue is full, retry later");
+            return Status::OK;
+        }
+        if (!done.get()) {
+            std::cout << "❌ Registration rejected: tenant " << partition.name << " is at its node quota" << std::endl;
+            response->set_accepted(false);
+            response->set_reason("Tenant node quota exceeded");
+            return Status::OK;
+        }
+        
+        // Accept the node
+        response->set_accepted(true);
+        response->set_reason("Welcome to TinyKube cluster!");
+        if (auth_) {
+            int64_t expires_ms = 0;
+            response->set_session_token(auth_->issue_session(partition.name, node_name, tinykube::now_ms(), expires_ms));
+            response->set_session_expires_unix_ms(expires_ms);
+        }
+        
+        if (verbose_) {
+            std::cout << "✅ Node " << node_name << " registered successfully in tenant " << partition.name
+                      << " (total: " << partition.nodes.size() << " nodes)" << std::endl;
+        }
+        
+        return Status::OK;
+    }
+    
+    Status StreamHeartbeats(ServerContext* context,
+                           ServerReader<tinykube::Heartbeat>* reader,
+                           tinykube::Empty* response) override {
+        
+        if (verbose_) {
+            std::cout << "💓 Starting heartbeat stream from " << context->peer() << std::endl;
+        }
+        
+        if (!track_stream(context)) {
+            return Status(grpc::StatusCode::UNAVAILABLE, "control plane is shutting down");
+        }
+        struct Untrack {
+            ControlPlaneServiceImpl* service;
+            ServerContext* context;
+            ~Untrack() { service->untrack_stream(context); }
+        } untrack{this, context};
+
+        tinykube::Heartbeat heartbeat;
+        int heartbeat_count = 0;
+        uint64_t stream_id = next_stream_id_.fetch_add(1, std::memory_order_relaxed) + 1;
+
+        // session tokens are verified here, once; heartbeats check the cache
+        tinykube::StreamAuth stream_auth;
+        if (auth_) {
+            int64_t now = tinykube::now_ms();
+            auto tokens = context->client_metadata().equal_range(tinykube::SESSION_METADATA_KEY);
+            for (auto it = tokens.first; it != tokens.second; ++it) {
+                tinykube::SessionClaim claim;
+                if (auth_->check_session(std::string_view(it->second.data(), it->second.size()), now, claim)) {
+                    stream_auth.add(std::move(claim));
+                }
+            }
+            if (stream_auth.size() == 0) {
+                return Status(grpc::StatusCode::UNAUTHENTICATED, "no valid session token, register again");
+            }
+        }
+        
+        pin_rpc_thread();
+        while (reader->Read(&heartbeat)) {
+            TK_TRACE_SPAN("rpc.Heartbeat");
+            const std::string& node_name = heartbeat.node_name();
+            int64_t now = tinykube::now_ms();
+            if (auth_ && !stream_auth.allows(heartbeat.tenant(), node_name, now)) {
+                return Status(grpc::StatusCode::UNAUTHENTICATED,
+                              "session token missing or expired for " + node_name + ", register again");
+            }
+            if (capture_) {
+                tinykube::CaptureRecord record;
+                record.stream = stream_id;
+                record.tenant = heartbeat.tenant();
+                record.node = node_name;
+                record.client_ms = heartbeat.now_unix_ms();
+                capture_->record(std::move(record));
+            }
+            
+            auto result = ingest_heartbeat(heartbeat.tenant(), node_name, now);
+            if (result == HeartbeatResult::UNKNOWN) {
+                if (verbose_) {
+                    std::cout << "⚠️ Received heartbeat from unregistered node: " << node_name << std::endl;
+                }
+                continue;  // Ignore heartbeats from unknown nodes
+            }
+            if (result == HeartbeatResult::THROTTLED) {
+                continue;  // over the tenant's heartbeat rate, the next one will do
+            }
+            heartbeat_count++;
+            
+            if (verbose_) {
+                std::cout << "💗 Heartbeat #" << heartbeat_count << " from " << node_name 
+                          << " (client time: " << heartbeat.now_unix_ms() << "ms)" << std::endl;
+            }
+            
+            if (!running_.load()) {
+                std::cout << "🛑 Server is shutting down, ending heartbeat stream..." << std::endl;
+                break;
+            }
+        }
+        
+        if (verbose_) {
+            std::cout << "💔 Heartbeat stream ended (received " << heartbeat_count 
+                      << " heartbeats)" << std::endl;
+        }
+        return Status::OK;
+    }
+
+    Status CordonNodes(ServerContext* context,
+                       const tinykube::CordonRequest* request,
+                       tinykube::BulkMutationResponse* response) override {
+        if (!selects_something(request->selector())) {
+            return Status(grpc::StatusCode::INVALID_ARGUMENT, "empty selector, set names, labels or all");
+        }
+        auto* partition = tenants_.find(request->tenant());
+        if (partition == nullptr) {
+            return Status(grpc::StatusCode::NOT_FOUND, "unknown tenant");
+        }
+        auto result = partition->nodes.set_unschedulable(tinykube::from_spec(request->selector()),
+                                                       request->unschedulable());
+        fill_bulk_response(result, response);
+
+        std::cout << (request->unschedulable() ? "🚧 Cordoned " : "🟢 Uncordoned ") << result.changed
+                  << " of " << result.matched << " matched nodes (revision " << result.revision
+                  << ", requested by " << context->peer() << ")" << std::endl;
+        return Status::OK;
+    }
+
+    Status LabelNodes(ServerContext* context,
+                      const tinykube::LabelNodesRequest* request,
+                      tinykube::BulkMutationResponse* response) override {
+        if (!selects_something(request->selector())) {
+            return Status(grpc::StatusCode::INVALID_ARGUMENT, "empty selector, set names, labels or all");
+        }
+        std::map<std::string, std::string> set_labels(request->set_labels().begin(), request->set_labels().end());
+        std::vector<std::string> remove_labels(request->remove_labels().begin(), request->remove_labels().end());
+        auto* partition = tenants_.find(request->tenant());
+        if (partition == nullptr) {
+            return Status(grpc::StatusCode::NOT_FOUND, "unknown tenant");
+        }
+        auto result = partition->nodes.update_labels(tinykube::from_spec(request->selector()),
+                                                   set_labels, remove_labels);
+        fill_bulk_response(result, response);
+
+        std::cout << "🏷️ Relabeled " << result.changed << " of " << result.matched
+                  << " matched nodes (revision " << result.revision
+                  << ", requested by " << context->peer() << ")" << std::endl;
+        return Status::OK;
+    }
+
+    Status WatchNodes(ServerContext* context,
+                      const tinykube::WatchRequest* request,
+                      ServerWriter<tinykube::NodeEvent>* writer) override {
+        std::cout << "👀 Watch started by " << context->peer()
+                  << " from revision " << request->since_revision() << std::endl;
+
+        auto& hub = tenants_.watch_hub();
+        uint64_t since = request->since_revision();
+        bool need_snapshot = since == 0;
+        std::vector<std::shared_ptr<const tinykube::WatchEvent>> events;
+
+        while (running_.load() && !context->IsCancelled() && !hub.closed()) {
+            if (need_snapshot) {
+                tinykube::NodeEvent snapshot_event;
+                for (const auto& node : tenants_.snapshot(since)) {
+                    tinykube::to_record(node, snapshot_event.add_nodes());
+                }
+                snapshot_event.set_revision(since);
+                snapshot_event.set_snapshot(true);
+                if (!writer->Write(snapshot_event)) {
+                    break;
+                }
+                need_snapshot = false;
+            }
+
+            events.clear();
+            bool resync = false;
+            if (!hub.wait_events(since, events, std::chrono::seconds(1), resync)) {
+                need_snapshot = resync;
+                continue;
+            }
+
+            bool write_failed = false;
+            for (const auto& event : events) {
+                TK_TRACE_SPAN("rpc.WatchNodes.event");
+                tinykube::NodeEvent out;
+                tinykube::to_event(*event, &out);
+                if (!writer->Write(out)) {
+                    write_failed = true;
+                    break;
+                }
+                since = event->revision;
+            }
+            if (write_failed) {
+                break;
+            }
+        }
+
+        std::cout << "🙈 Watch from " << context->peer() << " ended at revision " << since << std::endl;
+        return Status::OK;
+    }
+
+    Status SubmitWorkload(ServerContext* context,
+                          const tinykube::WorkloadSpec* request,
+                          tinykube::SubmitWorkloadResponse* response) override {
+        if (request->name().empty()) {
+            response->set_accepted(false);
+            response->set_reason("Workload name cannot be empty");
+            return Status::OK;
+        }
+
+        tinykube::Workload workload;
+        workload.name = request->name();
+        workload.tenant = request->tenant().empty() ? tinykube::DEFAULT_TENANT : request->tenant();
+        workload.request.cpu_millis = request->cpu_millis();
+        workload.request.memory_mb = request->memory_mb();
+        workload.submitted_ms = tinykube::now_ms();
+
+        std::string reason;
+        if (!submit_workload(workload, reason)) {
+            std::cout << "❌ Workload " << workload.tenant << "/" << workload.name << " rejected: " << reason << std::endl;
+            response->set_accepted(false);
+            response->set_reason(reason);
+            return Status::OK;
+        }
+
+        std::cout << "📦 Workload " << workload.tenant << "/" << workload.name << " queued ("
+                  << workload.request.cpu_millis << "m CPU, " << workload.request.memory_mb
+                  << "MB, from " << context->peer() << ")" << std::endl;
+        response->set_accepted(true);
+        response->set_reason("Queued for scheduling");
+        return Status::OK;
+    }
+
+    Status CompleteWorkload(ServerContext* context,
+                            const tinykube::WorkloadRef* request,
+                            tinykube::CompleteWorkloadResponse* response) override {
+        const std::string& tenant = request->tenant().empty() ? tinykube::DEFAULT_TENANT : request->tenant();
+        response->set_completed(scheduler_.complete(tenant, request->name()));
+        if (response->completed()) {
+            std::cout << "🏁 Workload " << tenant << "/" << request->name() << " completed ("
+                      << context->peer() << ")" << std::endl;
+        }
+        return Status::OK;
+    }
+
+    Status PutCronJob(ServerContext* context,
+                      const tinykube::CronJobSpec* request,
+                      tinykube::CronJobResponse* response) override {
+        tinykube::CronJob job;
+        job.name = request->name();
+        job.tenant = request->tenant().empty() ? tinykube::DEFAULT_TENANT : request->tenant();
+        job.schedule = request->schedule();
+        job.next_fire_ms = request->run_at_unix_ms();
+        job.request.cpu_millis = request->cpu_millis();
+        job.request.memory_mb = request->memory_mb();
+
+        std::string reason;
+        if (!cron_.put(job, reason)) {
+            std::cout << "❌ Cron job " << job.tenant << "/" << job.name << " rejected: " << reason << std::endl;
+            response->set_accepted(false);
+            response->set_reason(reason);
+            return Status::OK;
+        }
+
+        int64_t next_fire = cron_.next_fire(job.tenant, job.name);
+        std::cout << "⏰ Cron job " << job.tenant << "/" << job.name << " scheduled, next fire at "
+                  << next_fire << " (" << context->peer() << ")" << std::endl;
+        response->set_accepted(true);
+        response->set_reason("Scheduled");
+        response->set_next_fire_unix_ms(next_fire);
+        return Status::OK;
+    }
+
+    Status DeleteCronJob(ServerContext* context,
+                         const tinykube::WorkloadRef* request,
+                         tinykube::DeleteCronJobResponse* response) override {
+        const std::string& tenant = request->tenant().empty() ? tinykube::DEFAULT_TENANT : request->tenant();
+        response->set_deleted(cron_.remove(tenant, request->name()));
+        if (response->deleted()) {
+            std::cout << "🗑️ Cron job " << tenant << "/" << request->name() << " deleted ("
+                      << context->peer() << ")" << std::endl;
+        }
+        return Status::OK;
+    }
+
+    Status GetAvailability(ServerContext* context,
+                           const tinykube::AvailabilityRequest* request,
+                           tinykube::AvailabilityReport* response) override {
+        (void)context;
+        int64_t now = tinykube::now_ms();
+        std::optional<tinykube::SloReport> report;
+        if (request->node_name().empty()) {
+            report = tenants_.fleet_availability(now);
+        } else if (auto* partition = tenants_.find(request->tenant())) {
+            report = partition->nodes.availability(request->node_name(), now);
+        }
+
+        response->set_found(report.has_value());
+        if (report) {
+            auto add_window = [&](const char* name, const tinykube::Availability& availability) {
+                auto* window = response->add_windows();
+                window->set_window(name);
+                window->set_up_ms(availability.up_ms);
+                window->set_observed_ms(availability.observed_ms);
+                window->set_ratio(availability.ratio());
+            };
+            add_window("1h", report->hour);
+            add_window("1d", report->day);
+            add_window("30d", report->month);
+        }
+        return Status::OK;
+    }
+
+    Status Trace(ServerContext* context,
+                 const tinykube::TraceRequest* request,
+                 tinykube::TraceResponse* response) override {
+        switch (request->action()) {
+            case tinykube::TraceRequest::START:
+                tinykube::trace::set_enabled(true);
+                std::cout << "🔬 Tracing enabled by " << context->peer() << std::endl;
+                break;
+            case tinykube::TraceRequest::STOP:
+                tinykube::trace::set_enabled(false);
+                std::cout << "🔬 Tracing disabled by " << context->peer() << std::endl;
+                break;
+            case tinykube::TraceRequest::DUMP: {
+                std::ostringstream json;
+                response->set_events(tinykube::trace::Registry::instance().write_chrome_json(json));
+                response->set_chrome_json(json.str());
+                break;
+            }
+            default:
+                break;
+        }
+        response->set_enabled(tinykube::trace::enabled());
+        return Status::OK;
+    }
+
+    Status GetLockProfile(ServerContext* context,
+                          const tinykube::LockProfileRequest* request,
+                          tinykube::LockProfileReport* response) override {
+        auto& profiler = tinykube::lockprof::Profiler::instance();
+        auto reports = profiler.report(request->per_thread());
+        if (request->reset()) {
+            profiler.reset();
+            std::cout << "🔒 Lock profile reset by " << context->peer() << std::endl;
+        }
+
+        auto fill = [](const tinykube::lockprof::HistogramSummary& from, tinykube::LockHistogram* to) {
+            to->set_count(from.count);
+            to->set_total_ns(from.total_ns);
+            to->set_p50_ns(from.quantile_ns(0.50));
+            to->set_p99_ns(from.quantile_ns(0.99));
+            to->set_max_ns(from.max_ns);
+        };
+        for (const auto& report : reports) {
+            auto* site = response->add_sites();
+            site->set_site(report.site);
+            site->set_thread_id(report.tid);
+            fill(report.wait, site->mutable_wait());
+            fill(report.hold, site->mutable_hold());
+        }
+
+        std::ostringstream text;
+        tinykube::lockprof::write_text(text, reports);
+        response->set_text(text.str());
+        response->set_enabled(tinykube::lockprof::ENABLED);
+        return Status::OK;
+    }
+
+    Status Profile(ServerContext* context,
+                   const tinykube::ProfileRequest* request,
+                   tinykube::ProfileResponse* response) override {
+        int seconds = request->seconds() > 0 ? request->seconds() : 10;
+        int hz = request->frequency_hz() > 0 ? request->frequency_hz() : 99;
+        std::cout << "🔥 CPU profile for " << seconds << "s at " << hz << "Hz requested by "
+                  << context->peer() << std::endl;
+
+        std::string pprof, reason;
+        auto& profiler = tinykube::CpuProfiler::instance();
+        if (!profiler.profile(seconds, hz, pprof, reason)) {
+            return Status(grpc::StatusCode::FAILED_PRECONDITION, reason);
+        }
+        response->set_pprof(std::move(pprof));
+        response->set_dropped_samples(profiler.dropped());
+        return Status::OK;
+    }
+
+    // Streams an Arrow IPC file of the registry: each tenant's nodes go
+    // straight from its partition into columns and out as one record batch.
+    Status ExportNodes(ServerContext* context,
+                       const tinykube::ExportRequest* request,
+                       ServerWriter<tinykube::ExportChunk>* writer) override {
+        tinykube::ExportChunk chunk;
+        chunk.mutable_data()->reserve(EXPORT_CHUNK_BYTES);
+        auto flush = [&] {
+            bool written = writer->Write(chunk);
+            chunk.mutable_data()->clear();
+            return written;
+        };
+        tinykube::ArrowFileWriter file([&](const char* data, size_t size) {
+            auto* out = chunk.mutable_data();
+            while (size > 0) {
+                size_t take = std::min(size, EXPORT_CHUNK_BYTES - out->size());
+                out->append(data, take);
+                data += take;
+                size -= take;
+                if (out->size() == EXPORT_CHUNK_BYTES && !flush()) {
+                    return false;
+                }
+            }
+            return true;
+        });
+
+        tinykube::NodeColumns columns(request->availability());
+        int64_t now = tinykube::now_ms();
+        bool ok = file.begin(columns.columns);
+        auto export_partition = [&](tinykube::TenantPartition& partition) {
+            if (!ok) {
+                return;
+            }
+            columns.clear();
+            if (tinykube::append_columns(partition.nodes, columns, now) > 0) {
+                ok = file.write_batch(columns.columns);
+            }
+        };
+        if (!request->tenant().empty()) {
+            auto* partition = tenants_.find(request->tenant());
+            if (partition == nullptr) {
+                return Status(grpc::StatusCode::NOT_FOUND, "unknown tenant");
+            }
+            export_partition(*partition);
+        } else {
+            tenants_.for_each(export_partition);
+        }
+        ok = ok && file.finish() && (chunk.data().empty() || flush());
+        if (!ok) {
+            return Status(grpc::StatusCode::CANCELLED, "export stream closed");
+        }
+        std::cout << "📦 Exported " << file.rows_written() << " nodes (" << file.bytes_written()
+                  << " bytes of Arrow) to " << context->peer() << std::endl;
+        return Status::OK;
+    }
+
+    // empty unless part of the service failed to start, e.g. ingestion pinning
+    const std::string& startup_error() const {
+        return startup_error_;
+    }
+
+    // The one entry point for heartbeats, whatever transport they came in on.
+    // With an ingestion core the touch is queued; the node is still looked up
+    // here first so an unregistered one is refused as on the direct path.
+    HeartbeatResult ingest_heartbeat(const std::string& tenant, const std::string& node_name, int64_t now) {
+        auto* partition = tenants_.find(tenant);
+        if (partition == nullptr) {
+            return HeartbeatResult::UNKNOWN;
+        }
+        if (!partition->heartbeats.try_acquire(now)) {
+            return HeartbeatResult::THROTTLED;
+        }
+        if (ingest_) {
+            // Not checked against the registry here: that takes the partition
+            // lock the ingestion core holds, and the RPC thread would queue
+            // behind it. The core counts unknown nodes in IngestStats instead.
+            ingest_->submit(*partition, node_name, now);
+            return HeartbeatResult::ACCEPTED;
+        }
+        return partition->nodes.touch(node_name, now) ? HeartbeatResult::ACCEPTED : HeartbeatResult::UNKNOWN;
+    }
+
+    // Frames arrive in batches on the bypass transports. Each run of frames
+    // from one tenant costs one rate-limit check and one registry lock.
+    // Returns how many were admitted.
+    size_t ingest_frames(const tinykube::HeartbeatFrame* frames, size_t count, int64_t now) {
+        thread_local std::vector<std::pair<std::string, int64_t>> run;
+        size_t admitted = 0;
+        for (size_t start = 0, end = 0; start < count; start = end) {
+            auto tenant = frames[start].tenant_name();
+            for (end = start + 1; end < count && frames[end].tenant_name() == tenant; end++) {}
+
+            auto* partition = tenants_.find(std::string(tenant));
+            if (partition == nullptr) {
+                continue;
+            }
+            size_t allowed = end - start;
+            if (!partition->heartbeats.try_acquire(now, static_cast<double>(allowed))) {
+                allowed = 0;
+                while (allowed < end - start && partition->heartbeats.try_acquire(now)) {
+                    allowed++;
+                }
+            }
+            if (ingest_) {
+                for (size_t i = start; i < start + allowed; i++) {
+                    ingest_->submit(*partition, std::string(frames[i].node_name()), now);
+                }
+            } else if (allowed > 0) {
+                run.clear();
+                for (size_t i = start; i < start + allowed; i++) {
+                    run.emplace_back(frames[i].node_name(), now);
+                }
+                partition->nodes.touch_batch(run);
+            }
+            admitted += allowed;
+        }
+        return admitted;
+    }
+
+    // Watch streams end when the hub closes. Heartbeat streams would only end
+    // when their agents hang up, so they are cancelled here, between messages,
+    // rather than left for Shutdown(deadline) to wait out.
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(streams_mutex_);
+            running_.store(false);
+            for (auto* context : streams_) {
+                context->TryCancel();
+            }
+        }
+        if (ingest_) {
+            ingest_->stop();
+        }
+        tenants_.watch_hub().close();
+        cron_.stop();
+        work_queue_.stop();
+        if (capture_) {
+            capture_->flush();
+            std::cout << "🎥 Captured " << capture_->records() << " records" << std::endl;
+        }
+    }
+
+    tinykube::TenantRegistry& tenants() {
+        return tenants_;
+    }
+
+    // tunables that can change while serving; readers go through current()
+    ConfigStore& config() {
+        return config_;
+    }
+
+    void monitor_nodes() {
+        {
+            TK_TRACE_SPAN("monitor.sweep");
+            const auto& config = config_.current();
+            tenants_.sweep(tinykube::now_ms(), config.heartbeat_timeout_ms, config.not_ready_timeout_ms);
+        }
+        
+        auto nodes = tenants_.snapshot();
+        {
+            TK_TRACE_SPAN("monitor.schedule");
+            scheduler_.schedule(nodes);
+        }
+        
+        // Print the beautiful table
+        {
+            TK_TRACE_SPAN("monitor.render");
+            print_node_table(nodes);
+        }
+
+        if (!nodes.empty()) {
+            auto slo = tenants_.fleet_availability(tinykube::now_ms());
+            std::cout << "📈 Fleet availability: " << std::fixed << std::setprecision(3)
+                      << slo.hour.ratio() * 100 << "% (1h), " << slo.day.ratio() * 100 << "% (1d), "
+                      << slo.month.ratio() * 100 << "% (30d)" << std::defaultfloat << std::endl;
+
+            if (report_memory_) {
+                auto memory = tenants_.memory_usage();
+                std::cout << "🧠 Registry memory: " << memory.total() / 1024 << " KiB ("
+                          << memory.total() / std::max<size_t>(1, memory.nodes) << " B/node)" << std::endl;
+            }
+        }
+
+        if (ingest_) {
+            auto ingest = ingest_->stats();
+            std::cout << "⚡ Ingestion (CPU " << ingest_->cpu() << "): " << ingest.ingested << " heartbeats, "
+                      << ingest.unknown << " unknown, " << ingest.overflow << " overflowed, latency p50 "
+                      << ingest.latency.quantile_ns(0.50) << "ns p99 " << ingest.latency.quantile_ns(0.99)
+                      << "ns" << std::endl;
+        }
+
+        auto stats = scheduler_.stats();
+        if (stats.pending > 0 || stats.running > 0) {
+            std::cout << "📦 Workloads: " << stats.running << " running, " << stats.pending
+                      << " pending, " << stats.parked
+                      << " too big for any node (" << stats.bound_last_pass << " bound this cycle)\n" << std::endl;
+        }
+    }
+private:
+    // gRPC creates its handler threads on demand, so each pins itself once
+    void pin_rpc_thread() {
+        thread_local bool pinned = false;
+        if (!pinned) {
+            pinned = true;
+            tinykube::pin_current_thread(rpc_cpus_);
+        }
+    }
+
+    // queues the workload against its tenant's workload quota
+    bool submit_workload(const tinykube::Workload& workload, std::string& reason) {
+        auto* partition = tenants_.admit(workload.tenant);
+        if (partition == nullptr) {
+            reason = "Unknown tenant and the control plane is at its tenant limit";
+            return false;
+        }
+        return scheduler_.submit(workload, partition->workload_limits(), reason);
+    }
+
+    // each firing becomes an ordinary workload named after the job and fire time
+    void fire_cron_job(const tinykube::CronJob& job, int64_t fire_ms) {
+        tinykube::Workload workload;
+        workload.name = job.name + "-" + std::to_string(fire_ms / 1000);
+        workload.tenant = job.tenant;
+        workload.request = job.request;
+        workload.submitted_ms = tinykube::now_ms();
+
+        std::string reason;
+        if (!submit_workload(workload, reason)) {
+            std::cout << "⚠️ Cron job " << job.tenant << "/" << job.name << " fired but was not queued: "
+                      << reason << std::endl;
+        }
+    }
+
+    static void fill_bulk_response(const tinykube::BulkResult& result, tinykube::BulkMutationResponse* response) {
+        response->set_matched(static_cast<uint32_t>(result.matched));
+        response->set_changed(static_cast<uint32_t>(result.changed));
+        response->set_revision(result.revision);
+    }
+
+    bool track_stream(ServerContext* context) {
+        std::lock_guard<std::mutex> lock(streams_mutex_);
+        if (!running_.load()) {
+            return false;
+        }
+        streams_.insert(context);
+        return true;
+    }
+
+    void untrack_stream(ServerContext* context) {
+        std::lock_guard<std::mutex> lock(streams_mutex_);
+        streams_.erase(context);
+    }
+
+    const bool verbose_;
+    const bool report_memory_;
+    std::string startup_error_;
+    ConfigStore config_;
+    const std::vector<int> rpc_cpus_;
+    std::atomic<bool> running_{true};
+    std::unique_ptr<tinykube::CaptureWriter> capture_;
+    std::unique_ptr<tinykube::NodeAuthority> auth_;
+    std::atomic<uint64_t> next_stream_id_{0};
+    std::mutex streams_mutex_;
+    std::unordered_set<ServerContext*> streams_;  // open heartbeat streams, cancelled on shutdown
+    tinykube::TenantRegistry tenants_;
+    tinykube::FairWorkQueue work_queue_;
+    tinykube::Scheduler scheduler_;
+    tinykube::CronEngine cron_;
+    std::unique_ptr<tinykube::HeartbeatIngest> ingest_;  // declared last so it stops before the registry is destroyed
+};
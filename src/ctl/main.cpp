@@ -0,0 +1,575 @@
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+#include "control_plane.grpc.pb.h"
+#include "control_plane.pb.h"
+#include "ctl/top.hpp"
+#include "tinykube/node_auth.hpp"
+#include "tinykube/tls.hpp"
+
+using grpc::Channel;
+using grpc::ClientContext;
+using grpc::Status;
+
+void print_usage(const char* program_name) {
+    std::cout << "🎛️ TinyKube Control - Cluster Operations Client\n" << std::endl;
+    std::cout << "Usage: " << program_name << " [OPTIONS] <command> [ARGS]" << std::endl;
+    std::cout << "\nCommands:" << std::endl;
+    std::cout << "  cordon <node>... | -l k=v      Mark nodes unschedulable" << std::endl;
+    std::cout << "  uncordon <node>... | -l k=v    Mark nodes schedulable again" << std::endl;
+    std::cout << "  drain <node>... | -l k=v       Cordon nodes (there are no workloads to evict yet)" << std::endl;
+    std::cout << "  label <node>... | -l k=v  key=value... key-...   Set or remove labels" << std::endl;
+    std::cout << "  submit <workload> <cpu_millis> <memory_mb>       Queue a workload" << std::endl;
+    std::cout << "  complete <workload>            Mark a running workload finished" << std::endl;
+    std::cout << "  cron <job> \"<m h dom mon dow>\" <cpu_millis> <memory_mb>   Run a workload on a schedule" << std::endl;
+    std::cout << "  at <job> <delay_seconds> <cpu_millis> <memory_mb>          Run a workload once, later" << std::endl;
+    std::cout << "  uncron <job>                   Delete a cron or delayed job" << std::endl;
+    std::cout << "  trace start|stop|dump <file>   Control span tracing, dump as Chrome trace JSON" << std::endl;
+    std::cout << "  profile <file> [seconds] [hz]  Sample control plane CPU into a pprof file" << std::endl;
+    std::cout << "  export <file.arrow> [availability]   Dump every node (or -t tenant's) as an Arrow/Feather file" << std::endl;
+    std::cout << "  locks [threads] [reset]        Show registry lock wait/hold profile" << std::endl;
+    std::cout << "  slo [node]                     Show 1h/1d/30d availability of a node or the fleet" << std::endl;
+    std::cout << "  top                            Live full-screen node list (s sort, / filter, q quit)" << std::endl;
+    std::cout << "  clusters                       Per-cluster counts and health (-s <federator>)" << std::endl;
+    std::cout << "  cluster <name> [status]        Nodes of one federated cluster, e.g. suspect (-s <federator>)" << std::endl;
+    std::cout << "  token <node>... --auth-key <file>   Mint bootstrap tokens for tinykube_agent --token-file (offline)" << std::endl;
+    std::cout << "\nOptions:" << std::endl;
+    std::cout << "  -s, --server <address>    Control plane server address (default: localhost:50051)" << std::endl;
+    std::cout << "  -t, --tenant <name>       Tenant whose nodes to operate on (default: default)" << std::endl;
+    std::cout << "  -l, --selector <k=v>      Select nodes by label (repeatable, all must match)" << std::endl;
+    std::cout << "  --all                     Select every node of the tenant (cordon, uncordon, drain, label)" << std::endl;
+    std::cout << "  --auth-key <file>         Cluster key the control plane runs with (for token)" << std::endl;
+    std::cout << "  --tls-ca, --tls-cert, --tls-key <file>   Dial with mutual TLS (see scripts/gen-certs.sh)" << std::endl;
+    std::cout << "  --tls-server-name <name>  Name to expect in the server certificate" << std::endl;
+    std::cout << "  -h, --help                Show this help message" << std::endl;
+    std::cout << "\nExamples:" << std::endl;
+    std::cout << "  " << program_name << " cordon worker-1 worker-2" << std::endl;
+    std::cout << "  " << program_name << " drain -l rack=r12" << std::endl;
+    std::cout << "  " << program_name << " label -l zone=a tier=batch old-" << std::endl;
+}
+
+bool split_label(const std::string& arg, std::string& key, std::string& value) {
+    auto pos = arg.find('=');
+    if (pos == std::string::npos || pos == 0) {
+        return false;
+    }
+    key = arg.substr(0, pos);
+    value = arg.substr(pos + 1);
+    return true;
+}
+
+int report(const Status& status, const tinykube::BulkMutationResponse& response, const std::string& verb) {
+    if (!status.ok()) {
+        std::cerr << "🚫 RPC failed: " << status.error_message() << std::endl;
+        return 1;
+    }
+    std::cout << "✅ " << verb << " " << response.changed() << " of " << response.matched()
+              << " matched nodes (revision " << response.revision() << ")" << std::endl;
+    return 0;
+}
+
+void print_health(const tinykube::ClusterHealth& health) {
+    std::cout << "  " << (health.connected() ? "🟢 " : "🔴 ") << std::left << std::setw(16) << health.name() << std::right
+              << std::setw(7) << health.nodes() << " nodes  " << std::setw(7) << health.ready() << " ready  "
+              << std::setw(5) << health.degraded() << " degraded  " << std::setw(5) << health.suspect() << " suspect  "
+              << std::setw(5) << health.not_ready() << " not ready  " << std::setw(5) << health.unschedulable()
+              << " cordoned  " << health.alive_cpu_millis() / 1000 << " cores, " << health.alive_memory_mb() / 1024
+              << " GiB alive" << std::endl;
+}
+
+// "ready", "suspect", ... as tinykube::NodeStatus, 0 if unknown
+uint32_t parse_status(std::string name) {
+    for (auto& c : name) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    if (name == "ready") return 1;
+    if (name == "not_ready" || name == "notready") return 2;
+    if (name == "suspect") return 3;
+    if (name == "unknown") return 4;
+    if (name == "degraded") return 5;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::string server_address("localhost:50051");
+    std::string command;
+    std::string tenant;
+    std::vector<std::string> positional;
+    tinykube::NodeSelectorSpec selector;
+    tinykube::TlsFiles tls;
+    std::string auth_key_path;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else if (arg == "-s" || arg == "--server") {
+            if (i + 1 < argc) {
+                server_address = argv[++i];
+            } else {
+                std::cerr << "❌ Error: --server requires a value" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "-t" || arg == "--tenant") {
+            if (i + 1 < argc) {
+                tenant = argv[++i];
+            } else {
+                std::cerr << "❌ Error: --tenant requires a value" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "-l" || arg == "--selector") {
+            std::string key, value;
+            if (i + 1 < argc && split_label(argv[i + 1], key, value)) {
+                (*selector.mutable_match_labels())[key] = value;
+                i++;
+            } else {
+                std::cerr << "❌ Error: --selector requires a key=value argument" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--all") {
+            selector.set_all(true);
+        }
+        else if (arg == "--auth-key") {
+            if (i + 1 < argc) {
+                auth_key_path = argv[++i];
+            } else {
+                std::cerr << "❌ Error: --auth-key requires a value" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--tls-ca" || arg == "--tls-cert" || arg == "--tls-key" || arg == "--tls-server-name") {
+            if (i + 1 < argc) {
+                (arg == "--tls-ca" ? tls.ca : arg == "--tls-cert" ? tls.cert
+                                     : arg == "--tls-key" ? tls.key : tls.server_name) = argv[++i];
+            } else {
+                std::cerr << "❌ Error: " << arg << " requires a value" << std::endl;
+                return 1;
+            }
+        }
+        else if (command.empty()) {
+            command = arg;
+        }
+        else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (command.empty()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // minted locally from the key file, the control plane isn't involved
+    if (command == "token") {
+        std::string key, error;
+        if (auth_key_path.empty() || positional.empty()) {
+            std::cerr << "❌ Error: token needs --auth-key <file> and at least one node name" << std::endl;
+            return 1;
+        }
+        if (!tinykube::read_auth_key(auth_key_path, key, error)) {
+            std::cerr << "❌ Error: " << error << std::endl;
+            return 1;
+        }
+        tinykube::NodeAuthority authority(key);
+        for (const auto& node : positional) {
+            std::cout << node << " " << authority.bootstrap_token(tenant, node) << std::endl;
+        }
+        return 0;
+    }
+
+    grpc::ChannelArguments channel_args;
+    channel_args.SetMaxReceiveMessageSize(-1);  // trace dumps can be large
+    std::string tls_error;
+    auto channel = tinykube::create_channel(server_address, tls, channel_args, tls_error);
+    if (!channel) {
+        std::cerr << "❌ Error: " << tls_error << std::endl;
+        return 1;
+    }
+    auto stub = tinykube::ControlPlane::NewStub(channel);
+
+    if (command == "top") {
+        if (!positional.empty()) {
+            std::cerr << "❌ Error: top takes no arguments (-t limits it to one tenant)" << std::endl;
+            return 1;
+        }
+        return run_top(channel, server_address, tenant);
+    }
+
+    if (command == "cordon" || command == "uncordon" || command == "drain") {
+        for (const auto& name : positional) {
+            selector.add_names(name);
+        }
+        if (selector.names().empty() && selector.match_labels().empty() && !selector.all()) {
+            std::cerr << "❌ Error: " << command << " needs node names, a --selector or --all" << std::endl;
+            return 1;
+        }
+
+        tinykube::CordonRequest request;
+        *request.mutable_selector() = selector;
+        request.set_unschedulable(command != "uncordon");
+        request.set_tenant(tenant);
+
+        tinykube::BulkMutationResponse response;
+        ClientContext context;
+        Status status = stub->CordonNodes(&context, request, &response);
+        return report(status, response, command == "uncordon" ? "Uncordoned" : "Cordoned");
+    }
+
+    if (command == "label") {
+        tinykube::LabelNodesRequest request;
+        for (const auto& arg : positional) {
+            std::string key, value;
+            if (split_label(arg, key, value)) {
+                (*request.mutable_set_labels())[key] = value;
+            } else if (arg.size() > 1 && arg.back() == '-') {
+                request.add_remove_labels(arg.substr(0, arg.size() - 1));
+            } else {
+                selector.add_names(arg);
+            }
+        }
+        if (selector.names().empty() && selector.match_labels().empty() && !selector.all()) {
+            std::cerr << "❌ Error: label needs node names, a --selector or --all" << std::endl;
+            return 1;
+        }
+        *request.mutable_selector() = selector;
+        request.set_tenant(tenant);
+
+        tinykube::BulkMutationResponse response;
+        ClientContext context;
+        Status status = stub->LabelNodes(&context, request, &response);
+        return report(status, response, "Relabeled");
+    }
+
+    if (command == "submit") {
+        if (positional.size() != 3) {
+            std::cerr << "❌ Error: submit needs <workload> <cpu_millis> <memory_mb>" << std::endl;
+            return 1;
+        }
+        tinykube::WorkloadSpec request;
+        request.set_name(positional[0]);
+        request.set_tenant(tenant);
+        try {
+            request.set_cpu_millis(std::stoll(positional[1]));
+            request.set_memory_mb(std::stoll(positional[2]));
+        } catch (const std::exception&) {
+            std::cerr << "❌ Error: resource requests must be integers" << std::endl;
+            return 1;
+        }
+
+        tinykube::SubmitWorkloadResponse response;
+        ClientContext context;
+        Status status = stub->SubmitWorkload(&context, request, &response);
+        if (!status.ok()) {
+            std::cerr << "🚫 RPC failed: " << status.error_message() << std::endl;
+            return 1;
+        }
+        std::cout << (response.accepted() ? "✅ " : "❌ ") << response.reason() << std::endl;
+        return response.accepted() ? 0 : 1;
+    }
+
+    if (command == "complete") {
+        if (positional.size() != 1) {
+            std::cerr << "❌ Error: complete needs <workload>" << std::endl;
+            return 1;
+        }
+        tinykube::WorkloadRef request;
+        request.set_name(positional[0]);
+        request.set_tenant(tenant);
+
+        tinykube::CompleteWorkloadResponse response;
+        ClientContext context;
+        Status status = stub->CompleteWorkload(&context, request, &response);
+        if (!status.ok()) {
+            std::cerr << "🚫 RPC failed: " << status.error_message() << std::endl;
+            return 1;
+        }
+        std::cout << (response.completed() ? "✅ Completed " : "❌ Not running: ") << positional[0] << std::endl;
+        return response.completed() ? 0 : 1;
+    }
+
+    if (command == "cron" || command == "at") {
+        if (positional.size() != 4) {
+            std::cerr << "❌ Error: " << command << " needs <job> <" << (command == "cron" ? "schedule" : "delay_seconds")
+                      << "> <cpu_millis> <memory_mb>" << std::endl;
+            return 1;
+        }
+        tinykube::CronJobSpec request;
+        request.set_name(positional[0]);
+        request.set_tenant(tenant);
+        try {
+            if (command == "cron") {
+                request.set_schedule(positional[1]);
+            } else {
+                auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+                request.set_run_at_unix_ms(now + std::stoll(positional[1]) * 1000);
+            }
+            request.set_cpu_millis(std::stoll(positional[2]));
+            request.set_memory_mb(std::stoll(positional[3]));
+        } catch (const std::exception&) {
+            std::cerr << "❌ Error: delay and resource requests must be integers" << std::endl;
+            return 1;
+        }
+
+        tinykube::CronJobResponse response;
+        ClientContext context;
+        Status status = stub->PutCronJob(&context, request, &response);
+        if (!status.ok()) {
+            std::cerr << "🚫 RPC failed: " << status.error_message() << std::endl;
+            return 1;
+        }
+        if (!response.accepted()) {
+            std::cout << "❌ " << response.reason() << std::endl;
+            return 1;
+        }
+        std::cout << "✅ " << response.reason() << ", next fire at " << response.next_fire_unix_ms() << "ms" << std::endl;
+        return 0;
+    }
+
+    if (command == "uncron") {
+        if (positional.size() != 1) {
+            std::cerr << "❌ Error: uncron needs <job>" << std::endl;
+            return 1;
+        }
+        tinykube::WorkloadRef request;
+        request.set_name(positional[0]);
+        request.set_tenant(tenant);
+
+        tinykube::DeleteCronJobResponse response;
+        ClientContext context;
+        Status status = stub->DeleteCronJob(&context, request, &response);
+        if (!status.ok()) {
+            std::cerr << "🚫 RPC failed: " << status.error_message() << std::endl;
+            return 1;
+        }
+        std::cout << (response.deleted() ? "✅ Deleted " : "❌ No such job: ") << positional[0] << std::endl;
+        return response.deleted() ? 0 : 1;
+    }
+
+    if (command == "slo") {
+        tinykube::AvailabilityRequest request;
+        request.set_tenant(tenant);
+        if (!positional.empty()) {
+            request.set_node_name(positional[0]);
+        }
+
+        tinykube::AvailabilityReport response;
+        ClientContext context;
+        Status status = stub->GetAvailability(&context, request, &response);
+        if (!status.ok()) {
+            std::cerr << "🚫 RPC failed: " << status.error_message() << std::endl;
+            return 1;
+        }
+        if (!response.found()) {
+            std::cout << "❌ No such node: " << positional[0] << std::endl;
+            return 1;
+        }
+        std::cout << "📈 Availability of " << (positional.empty() ? "the fleet" : positional[0]) << std::endl;
+        for (const auto& window : response.windows()) {
+            std::cout << "  " << std::left << std::setw(4) << window.window() << " "
+                      << std::fixed << std::setprecision(3) << window.ratio() * 100 << "%  ("
+                      << window.up_ms() / 1000 << "s up of " << window.observed_ms() / 1000 << "s observed)" << std::endl;
+        }
+        return 0;
+    }
+
+    if (command == "profile") {
+        if (positional.empty() || positional.size() > 3) {
+            std::cerr << "❌ Error: profile needs <file> [seconds] [hz]" << std::endl;
+            return 1;
+        }
+        tinykube::ProfileRequest request;
+        try {
+            request.set_seconds(positional.size() > 1 ? std::stoi(positional[1]) : 10);
+            request.set_frequency_hz(positional.size() > 2 ? std::stoi(positional[2]) : 99);
+        } catch (const std::exception&) {
+            std::cerr << "❌ Error: profile seconds and hz must be integers" << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        tinykube::ProfileResponse response;
+        ClientContext context;
+        context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(request.seconds() + 30));
+        std::cout << "🔥 Profiling control plane for " << request.seconds() << "s..." << std::endl;
+        Status status = stub->Profile(&context, request, &response);
+        if (!status.ok()) {
+            std::cerr << "🚫 RPC failed: " << status.error_message() << std::endl;
+            return 1;
+        }
+        std::ofstream out(positional[0], std::ios::binary);
+        out << response.pprof();
+        std::cout << "💾 Wrote " << response.pprof().size() << " bytes to " << positional[0];
+        if (response.dropped_samples() > 0) {
+            std::cout << " (" << response.dropped_samples() << " samples dropped)";
+        }
+        std::cout << "\n   go tool pprof -http=: tinykube_control " << positional[0] << std::endl;
+        return 0;
+    }
+
+    if (command == "export") {
+        if (positional.empty() || positional.size() > 2 || (positional.size() == 2 && positional[1] != "availability")) {
+            std::cerr << "❌ Error: export needs <file.arrow> [availability]" << std::endl;
+            return 1;
+        }
+        tinykube::ExportRequest request;
+        request.set_tenant(tenant);
+        request.set_availability(positional.size() == 2);
+
+        std::ofstream out(positional[0], std::ios::binary);
+        if (!out) {
+            std::cerr << "❌ Error: cannot write " << positional[0] << std::endl;
+            return 1;
+        }
+        ClientContext context;
+        auto reader = stub->ExportNodes(&context, request);
+        tinykube::ExportChunk chunk;
+        size_t bytes = 0;
+        auto started = std::chrono::steady_clock::now();
+        while (reader->Read(&chunk)) {
+            out.write(chunk.data().data(), static_cast<std::streamsize>(chunk.data().size()));
+            bytes += chunk.data().size();
+        }
+        Status status = reader->Finish();
+        if (!status.ok()) {
+            std::cerr << "🚫 RPC failed: " << status.error_message() << std::endl;
+            return 1;
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+        std::cout << "💾 Wrote " << bytes << " bytes to " << positional[0] << " in " << elapsed.count() << "ms"
+                  << "\n   pyarrow.feather.read_table(\"" << positional[0] << "\")" << std::endl;
+        return 0;
+    }
+
+    if (command == "locks") {
+        tinykube::LockProfileRequest request;
+        for (const auto& arg : positional) {
+            if (arg == "threads") {
+                request.set_per_thread(true);
+            } else if (arg == "reset") {
+                request.set_reset(true);
+            } else {
+                std::cerr << "❌ Error: locks takes 'threads' and/or 'reset'" << std::endl;
+                return 1;
+            }
+        }
+
+        tinykube::LockProfileReport response;
+        ClientContext context;
+        Status status = stub->GetLockProfile(&context, request, &response);
+        if (!status.ok()) {
+            std::cerr << "🚫 RPC failed: " << status.error_message() << std::endl;
+            return 1;
+        }
+        if (!response.enabled()) {
+            std::cout << "⚠️  Control plane was built without TINYKUBE_LOCK_PROFILING" << std::endl;
+            return 0;
+        }
+        std::cout << "🔒 Lock profile (ns, percentiles are power-of-two bucket bounds)" << std::endl;
+        std::cout << response.text();
+        return 0;
+    }
+
+    if (command == "trace") {
+        tinykube::TraceRequest request;
+        std::string action = positional.empty() ? "status" : positional[0];
+        if (action == "start") {
+            request.set_action(tinykube::TraceRequest::START);
+        } else if (action == "stop") {
+            request.set_action(tinykube::TraceRequest::STOP);
+        } else if (action == "dump" && positional.size() == 2) {
+            request.set_action(tinykube::TraceRequest::DUMP);
+        } else if (action != "status") {
+            std::cerr << "❌ Error: trace needs start, stop, status or dump <file>" << std::endl;
+            return 1;
+        }
+
+        tinykube::TraceResponse response;
+        ClientContext context;
+        Status status = stub->Trace(&context, request, &response);
+        if (!status.ok()) {
+            std::cerr << "🚫 RPC failed: " << status.error_message() << std::endl;
+            return 1;
+        }
+        if (request.action() == tinykube::TraceRequest::DUMP) {
+            std::ofstream out(positional[1], std::ios::binary);
+            out << response.chrome_json();
+            std::cout << "💾 Wrote " << response.events() << " trace events to " << positional[1]
+                      << " (open in chrome://tracing or ui.perfetto.dev)" << std::endl;
+        }
+        std::cout << "🔬 Tracing is " << (response.enabled() ? "on" : "off") << std::endl;
+        return 0;
+    }
+
+    if (command == "clusters") {
+        auto federation = tinykube::Federation::NewStub(channel);
+        tinykube::FederationRequest request;
+        tinykube::FederationSummary response;
+        ClientContext context;
+        Status status = federation->Summarize(&context, request, &response);
+        if (!status.ok()) {
+            std::cerr << "🚫 RPC failed: " << status.error_message() << std::endl;
+            return 1;
+        }
+        std::cout << "🌐 " << response.clusters_size() << " clusters" << std::endl;
+        for (const auto& health : response.clusters()) {
+            print_health(health);
+        }
+        print_health(response.total());
+        return 0;
+    }
+
+    if (command == "cluster") {
+        if (positional.empty() || positional.size() > 2) {
+            std::cerr << "❌ Error: cluster needs <name> [status]" << std::endl;
+            return 1;
+        }
+        tinykube::DrillDownRequest request;
+        request.set_cluster(positional[0]);
+        request.set_tenant(tenant);
+        if (positional.size() > 1) {
+            request.set_status(parse_status(positional[1]));
+        }
+        if (positional.size() > 1 && request.status() == 0) {
+            std::cerr << "❌ Error: status must be ready, degraded, suspect, not_ready or unknown" << std::endl;
+            return 1;
+        }
+        tinykube::DrillDownResponse response;
+        ClientContext context;
+        Status status = tinykube::Federation::NewStub(channel)->DrillDown(&context, request, &response);
+        if (!status.ok()) {
+            std::cerr << "🚫 RPC failed: " << status.error_message() << std::endl;
+            return 1;
+        }
+        if (!response.found()) {
+            std::cout << "❌ No such cluster: " << positional[0] << std::endl;
+            return 1;
+        }
+        std::cout << "🔎 " << response.matched() << " matching nodes in " << positional[0]
+                  << (static_cast<uint32_t>(response.nodes_size()) < response.matched()
+                          ? " (showing " + std::to_string(response.nodes_size()) + ")" : "")
+                  << std::endl;
+        for (const auto& node : response.nodes()) {
+            std::cout << "  " << std::left << std::setw(24) << (node.tenant() + "/" + node.name()) << std::right
+                      << " status " << node.status() << (node.unschedulable() ? "  cordoned" : "")
+                      << "  last seen " << node.last_seen_ms() << std::endl;
+        }
+        return 0;
+    }
+
+    std::cerr << "❌ Error: Unknown command '" << command << "'" << std::endl;
+    print_usage(argv[0]);
+    return 1;
+}
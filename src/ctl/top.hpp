@@ -0,0 +1,578 @@
+#pragma once
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+
+#include "tinykube/federation.hpp"
+#include "tinykube/mirror_watcher.hpp"
+#include "tinykube/time.hpp"
+
+// tinykubectl top: a full-screen node list fed by one WatchNodes stream. The
+// stream keeps a ClusterMirror current. The rows on screen are looked up
+// again every frame, but which rows those are (a pass over every node) is
+// worked out at most once per TOP_RESELECT while only the cluster moves, and
+// at once when the view does. Only the cells that differ from what the
+// terminal already shows are written.
+
+inline constexpr auto TOP_REFRESH = std::chrono::milliseconds(100);
+inline constexpr auto TOP_RESELECT = std::chrono::seconds(1);
+inline constexpr auto TOP_MAX_BACKOFF = std::chrono::milliseconds(5000);
+inline constexpr int TOP_HEADER_LINES = 3;  // summary, keys, column titles
+
+enum class TopSort { STATUS, NAME, TENANT, CPU, MEMORY, UPDATED, COUNT };
+
+struct TopColumn {
+    const char* title;
+    int width;  // including the space after it
+    TopSort sort;
+};
+
+inline constexpr TopColumn TOP_COLUMNS[] = {
+    {"NAME", 29, TopSort::NAME},
+    {"TENANT", 13, TopSort::TENANT},
+    {"STATUS", 11, TopSort::STATUS},
+    {"CORDONED", 9, TopSort::COUNT},
+    {"CPU", 7, TopSort::CPU},
+    {"MEMORY", 9, TopSort::MEMORY},
+    {"UPDATED", 9, TopSort::UPDATED},
+    {"PEER", 26, TopSort::COUNT},
+};
+
+inline const char* top_sort_name(TopSort sort) {
+    switch (sort) {
+        case TopSort::STATUS:  return "status";
+        case TopSort::NAME:    return "name";
+        case TopSort::TENANT:  return "tenant";
+        case TopSort::CPU:     return "cpu";
+        case TopSort::MEMORY:  return "memory";
+        default:               return "updated";
+    }
+}
+
+// sorting by status puts the trouble first
+inline int top_severity(tinykube::NodeStatus status) {
+    switch (status) {
+        case tinykube::NodeStatus::NOT_READY: return 0;
+        case tinykube::NodeStatus::SUSPECT:   return 1;
+        case tinykube::NodeStatus::DEGRADED:  return 2;
+        case tinykube::NodeStatus::UNKNOWN:   return 3;
+        case tinykube::NodeStatus::READY:     return 4;
+        default:                              return 5;
+    }
+}
+
+inline const char* top_status_color(tinykube::NodeStatus status) {
+    switch (status) {
+        case tinykube::NodeStatus::READY:     return "\x1b[32m";
+        case tinykube::NodeStatus::DEGRADED:  return "\x1b[33m";
+        case tinykube::NodeStatus::SUSPECT:   return "\x1b[35m";
+        case tinykube::NodeStatus::NOT_READY: return "\x1b[31m";
+        default:                              return "\x1b[2m";
+    }
+}
+
+inline std::string top_age(int64_t since_ms, int64_t now_ms) {
+    int64_t seconds = std::max<int64_t>(0, now_ms - since_ms) / 1000;
+    if (seconds < 60) return std::to_string(seconds) + "s";
+    if (seconds < 3600) return std::to_string(seconds / 60) + "m";
+    if (seconds < 86400) return std::to_string(seconds / 3600) + "h";
+    return std::to_string(seconds / 86400) + "d";
+}
+
+// The length of the UTF-8 character at text[i], or 0 if the byte there
+// doesn't start one (stray continuation, overlong, surrogate, cut short).
+inline size_t top_decode(std::string_view text, size_t i, char32_t& ch) {
+    auto byte = [&](size_t k) { return static_cast<unsigned char>(text[k]); };
+    unsigned char lead = byte(i);
+    size_t length = 0;
+    char32_t min = 0;
+    if (lead < 0x80) {
+        ch = lead;
+        return 1;
+    } else if ((lead & 0xe0) == 0xc0) {
+        length = 2, ch = lead & 0x1f, min = 0x80;
+    } else if ((lead & 0xf0) == 0xe0) {
+        length = 3, ch = lead & 0x0f, min = 0x800;
+    } else if ((lead & 0xf8) == 0xf0) {
+        length = 4, ch = lead & 0x07, min = 0x10000;
+    } else {
+        return 0;
+    }
+    if (i + length > text.size()) {
+        return 0;
+    }
+    for (size_t k = 1; k < length; k++) {
+        if ((byte(i + k) & 0xc0) != 0x80) {
+            return 0;
+        }
+        ch = (ch << 6) | (byte(i + k) & 0x3f);
+    }
+    if (ch < min || ch > 0x10ffff || (ch >= 0xd800 && ch <= 0xdfff)) {
+        return 0;
+    }
+    return length;
+}
+
+// terminal columns a character takes: 0 for combining marks and zero-width
+// characters, 2 for East Asian wide ones and emoji, -1 for C0/C1 controls
+inline int top_char_width(char32_t ch) {
+    if (ch < 0x20 || (ch >= 0x7f && ch < 0xa0)) return -1;
+    if ((ch >= 0x300 && ch <= 0x36f) || (ch >= 0x200b && ch <= 0x200f) || (ch >= 0xfe00 && ch <= 0xfe0f)) return 0;
+    if ((ch >= 0x1100 && ch <= 0x115f) || (ch >= 0x2e80 && ch <= 0xa4cf) || (ch >= 0xac00 && ch <= 0xd7a3) ||
+        (ch >= 0xf900 && ch <= 0xfaff) || (ch >= 0xfe30 && ch <= 0xfe4f) || (ch >= 0xff00 && ch <= 0xff60) ||
+        (ch >= 0xffe0 && ch <= 0xffe6) || (ch >= 0x1f300 && ch <= 0x1f64f) || (ch >= 0x1f900 && ch <= 0x1f9ff) ||
+        (ch >= 0x20000 && ch <= 0x3fffd)) {
+        return 2;
+    }
+    return 1;
+}
+
+// Appends as many whole characters of `text` as fit in `columns` and returns
+// the columns used. Node names and peers come from agents, so controls and
+// bytes that aren't UTF-8 are written as '?': nothing in them can move the
+// cursor, recolour the screen or talk to the terminal.
+inline int top_fit(std::string_view text, int columns, std::string& out) {
+    int used = 0;
+    for (size_t i = 0; i < text.size();) {
+        char32_t ch = 0;
+        size_t length = top_decode(text, i, ch);
+        int width = length == 0 ? -1 : top_char_width(ch);
+        if (used + (width < 0 ? 1 : width) > columns) {
+            break;
+        }
+        if (width < 0) {
+            out += '?';
+            used++;
+        } else {
+            out.append(text.substr(i, length));
+            used += width;
+        }
+        i += length == 0 ? 1 : length;
+    }
+    return used;
+}
+
+inline bool write_all(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t n = ::write(fd, data.data(), data.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(n));
+    }
+    return true;
+}
+
+// Raw, unechoed input on the alternate screen for as long as it lives.
+class RawTerminal {
+public:
+    bool enter(std::string& error) {
+        if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) {
+            error = "top needs a terminal";
+            return false;
+        }
+        if (tcgetattr(STDIN_FILENO, &saved_) != 0) {
+            error = "cannot read terminal settings";
+            return false;
+        }
+        termios raw = saved_;
+        raw.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO | ISIG);
+        raw.c_iflag &= ~static_cast<tcflag_t>(IXON | ICRNL);
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) != 0) {
+            error = "cannot switch the terminal to raw mode";
+            return false;
+        }
+        active_ = true;
+        write_all(STDOUT_FILENO, "\x1b[?1049h\x1b[?25l\x1b[2J");
+        return true;
+    }
+
+    ~RawTerminal() {
+        if (active_) {
+            write_all(STDOUT_FILENO, "\x1b[0m\x1b[?25h\x1b[?1049l");
+            tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved_);
+        }
+    }
+
+    static bool size(int& rows, int& cols) {
+        winsize ws{};
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) != 0 || ws.ws_row == 0 || ws.ws_col == 0) {
+            return false;
+        }
+        rows = ws.ws_row;
+        cols = ws.ws_col;
+        return true;
+    }
+private:
+    termios saved_{};
+    bool active_{false};
+};
+
+// What is on screen, cell by cell, and the view state (sort, filter,
+// scroll) that decides what should be.
+class TopView {
+public:
+    TopView(const tinykube::MirrorWatcher& watch, std::string tenant) : watch_(watch), tenant_(std::move(tenant)) {}
+
+    // false once the user asked to quit
+    bool key(std::string_view input) {
+        for (size_t i = 0; i < input.size(); i++) {
+            char c = input[i];
+            if (c == 3) {  // ^C, with ISIG off
+                return false;
+            }
+            if (editing_) {
+                edit(c);
+                continue;
+            }
+            if (c == 27 && i + 2 < input.size() && input[i + 1] == '[') {
+                char code = input[i + 2];
+                i += 2;
+                if (code == 'A') scroll(-1);
+                if (code == 'B') scroll(1);
+                if ((code == '5' || code == '6') && i + 1 < input.size() && input[i + 1] == '~') {
+                    i++;
+                    scroll(code == '5' ? -page() : page());
+                }
+                continue;
+            }
+            switch (c) {
+                case 'q': return false;
+                case 's':
+                    sort_ = static_cast<TopSort>((static_cast<int>(sort_) + 1) % static_cast<int>(TopSort::COUNT));
+                    dirty_ = true;
+                    break;
+                case 'r': reverse_ = !reverse_; dirty_ = true; break;
+                case '/': editing_ = true; break;
+                case 27: set_filter(""); break;
+                case 'j': scroll(1); break;
+                case 'k': scroll(-1); break;
+                case ' ': scroll(page()); break;
+                case 'g': scroll(-static_cast<int>(offset_)); break;
+                case 'G': scroll(static_cast<int>(matched_)); break;
+                default: break;
+            }
+        }
+        return true;
+    }
+
+    // appends the escape sequences that bring the screen up to date
+    void draw(std::string& out) {
+        int rows = 24, cols = 80;
+        RawTerminal::size(rows, cols);
+        if (rows != rows_ || cols != cols_) {
+            rows_ = rows;
+            cols_ = cols;
+            shown_.assign(static_cast<size_t>(rows_), {});
+            out += "\x1b[2J";
+            dirty_ = true;
+        }
+        auto summary = watch_.mirror().summary();
+        bool moved = summary.revision != revision_ || summary.resyncs != resyncs_;
+        if (moved) {
+            revision_ = summary.revision;
+            resyncs_ = summary.resyncs;
+            stale_ = true;
+        }
+        auto steady_now = std::chrono::steady_clock::now();
+        if (dirty_ || (stale_ && steady_now - selected_at_ >= TOP_RESELECT)) {
+            dirty_ = false;
+            stale_ = false;
+            selected_at_ = steady_now;
+            select();
+        } else if (moved) {
+            refresh();
+        }
+        int64_t now = tinykube::now_ms();
+
+        using tinykube::NodeStatus;
+        line_ = "tinykube top  " + summary.address + "  revision " + std::to_string(summary.revision) + "  " +
+                std::to_string(summary.nodes) + " nodes: " + std::to_string(summary.count(NodeStatus::READY)) +
+                " ready, " + std::to_string(summary.count(NodeStatus::DEGRADED)) + " degraded, " +
+                std::to_string(summary.count(NodeStatus::SUSPECT)) + " suspect, " +
+                std::to_string(summary.count(NodeStatus::NOT_READY)) + " not ready, " +
+                std::to_string(summary.unschedulable) + " cordoned  ";
+        line_ += summary.connected ? "[live]" : "[reconnecting: " + watch_.error() + "]";
+        put(0, 0, 0, cols_, "\x1b[1m", line_, out);
+
+        line_ = "sort " + std::string(top_sort_name(sort_)) + (reverse_ ? " (reversed)" : "") + "  filter " +
+                (filter_.empty() && !editing_ ? "-" : filter_) + (editing_ ? "_" : "") + "  " +
+                std::to_string(matched_) + " shown" + (tenant_.empty() ? "" : " of tenant " + tenant_) +
+                "    s sort  r reverse  / filter  esc clear  j/k pgup/pgdn scroll  q quit";
+        put(1, 0, 0, cols_, "", line_, out);
+
+        int x = 0;
+        size_t cell = 0;
+        for (const auto& column : TOP_COLUMNS) {
+            line_ = column.title;
+            if (column.sort == sort_) {
+                line_ += reverse_ ? " ^" : " v";
+            }
+            put(2, cell++, x, column.width, "\x1b[7m", line_, out);
+            x += column.width;
+        }
+        put(2, cell, x, cols_ - x, "\x1b[7m", "", out);
+
+        for (int row = TOP_HEADER_LINES; row < rows_; row++) {
+            size_t index = static_cast<size_t>(row - TOP_HEADER_LINES);
+            const tinykube::MemberNode* node = index < visible_.size() ? &visible_[index] : nullptr;
+            x = 0;
+            cell = 0;
+            for (const auto& column : TOP_COLUMNS) {
+                const char* sgr = "";
+                line_.clear();
+                if (node != nullptr) {
+                    format_cell(*node, cell, now, sgr);
+                }
+                put(row, cell++, x, column.width, sgr, line_, out);
+                x += column.width;
+            }
+        }
+    }
+private:
+    void edit(char c) {
+        if (c == '\r' || c == '\n') {
+            editing_ = false;
+        } else if (c == 27) {
+            editing_ = false;
+            set_filter("");
+        } else if (c == 127 || c == 8) {
+            if (!filter_.empty()) {
+                set_filter(filter_.substr(0, filter_.size() - 1));
+            }
+        } else if (std::isprint(static_cast<unsigned char>(c))) {
+            set_filter(filter_ + c);
+        }
+    }
+
+    // a status name or "cordoned" selects on that, anything else is a
+    // substring of the node or tenant name
+    void set_filter(std::string filter) {
+        filter_ = std::move(filter);
+        std::string lower = filter_;
+        for (auto& c : lower) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        filter_status_ = -1;
+        for (int status = 1; status < static_cast<int>(tinykube::NODE_STATUS_COUNT); status++) {
+            std::string name = tinykube::status_name(static_cast<tinykube::NodeStatus>(status));
+            for (auto& c : name) {
+                c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            }
+            if (lower == name) {
+                filter_status_ = status;
+            }
+        }
+        filter_cordoned_ = lower == "cordoned";
+        offset_ = 0;
+        dirty_ = true;
+    }
+
+    bool matches(const tinykube::MemberNode& node) const {
+        if (!tenant_.empty() && node.tenant != tenant_) {
+            return false;
+        }
+        if (filter_status_ >= 0) {
+            return static_cast<int>(node.status) == filter_status_;
+        }
+        if (filter_cordoned_) {
+            return node.unschedulable;
+        }
+        return filter_.empty() || node.name.find(filter_) != std::string::npos ||
+               node.tenant.find(filter_) != std::string::npos;
+    }
+
+    // whether `a` is listed above `b`; numbers and recency sort largest first
+    bool before(const tinykube::MemberNode& a, const tinykube::MemberNode& b) const {
+        int order = 0;
+        switch (sort_) {
+            case TopSort::STATUS: order = top_severity(a.status) - top_severity(b.status); break;
+            case TopSort::NAME:   order = a.name.compare(b.name); break;
+            case TopSort::TENANT: order = a.tenant.compare(b.tenant); break;
+            case TopSort::CPU:    order = (b.cpu_millis > a.cpu_millis) - (b.cpu_millis < a.cpu_millis); break;
+            case TopSort::MEMORY: order = (b.memory_mb > a.memory_mb) - (b.memory_mb < a.memory_mb); break;
+            default:              order = (b.last_seen_ms > a.last_seen_ms) - (b.last_seen_ms < a.last_seen_ms); break;
+        }
+        if (order != 0) {
+            return reverse_ ? order > 0 : order < 0;
+        }
+        if (int tenant = a.tenant.compare(b.tenant); tenant != 0) {
+            return tenant < 0;
+        }
+        return a.name < b.name;
+    }
+
+    // One pass over the mirror keeping the first offset + page rows in a
+    // bounded heap, so a frame copies a screenful of nodes, not the cluster.
+    void select() {
+        size_t limit = offset_ + static_cast<size_t>(page());
+        auto later = [this](const tinykube::MemberNode& a, const tinykube::MemberNode& b) { return before(a, b); };
+        heap_.clear();
+        matched_ = 0;
+        watch_.mirror().for_each_node([&](const tinykube::MemberNode& node) {
+            if (!matches(node)) {
+                return;
+            }
+            matched_++;
+            if (heap_.size() < limit) {
+                heap_.push_back(node);
+                std::push_heap(heap_.begin(), heap_.end(), later);
+            } else if (limit > 0 && before(node, heap_.front())) {
+                std::pop_heap(heap_.begin(), heap_.end(), later);
+                heap_.back() = node;
+                std::push_heap(heap_.begin(), heap_.end(), later);
+            }
+        });
+        std::sort_heap(heap_.begin(), heap_.end(), later);
+        size_t max_offset = matched_ > static_cast<size_t>(page()) ? matched_ - static_cast<size_t>(page()) : 0;
+        if (offset_ > max_offset) {
+            offset_ = max_offset;  // the list shrank under us; next frame fills the page again
+            dirty_ = true;
+        }
+        visible_.assign(heap_.begin() + static_cast<std::ptrdiff_t>(std::min(offset_, heap_.size())), heap_.end());
+    }
+
+    // the same rows, with what the mirror has for them now
+    void refresh() {
+        for (auto& node : visible_) {
+            auto current = watch_.mirror().get(node.tenant, node.name);
+            if (current) {
+                node = std::move(*current);
+            } else {
+                dirty_ = true;  // removed: pick the rows again next frame
+            }
+        }
+    }
+
+    void scroll(int delta) {
+        int64_t offset = static_cast<int64_t>(offset_) + delta;
+        int64_t max_offset = std::max<int64_t>(0, static_cast<int64_t>(matched_) - page());
+        offset_ = static_cast<size_t>(std::clamp<int64_t>(offset, 0, max_offset));
+        dirty_ = true;
+    }
+
+    int page() const {
+        return std::max(0, rows_ - TOP_HEADER_LINES);
+    }
+
+    void format_cell(const tinykube::MemberNode& node, size_t cell, int64_t now, const char*& sgr) {
+        switch (cell) {
+            case 0: line_ = node.name; break;
+            case 1: line_ = node.tenant; break;
+            case 2: line_ = tinykube::status_name(node.status); sgr = top_status_color(node.status); break;
+            case 3: line_ = node.unschedulable ? "yes" : ""; break;
+            case 4: line_ = std::to_string(node.cpu_millis / 1000) + "." + std::to_string(node.cpu_millis % 1000 / 100); break;
+            case 5:
+                line_ = node.memory_mb < 1024 ? std::to_string(node.memory_mb) + " MiB"
+                                              : std::to_string(node.memory_mb / 1024) + " GiB";
+                break;
+            case 6: line_ = top_age(node.last_seen_ms, now); break;
+            default: line_ = node.peer; break;
+        }
+    }
+
+    // writes one cell, padded to its width, unless the screen has it already
+    void put(int row, size_t cell, int x, int width, const char* sgr, std::string_view text, std::string& out) {
+        if (x >= cols_ || width <= 0) {
+            return;
+        }
+        // a whole cell keeps its last column blank as the gap to the next
+        int fit = std::min(width, cols_ - x);
+        cell_ = sgr;
+        int used = top_fit(text, fit < width ? fit : fit - 1, cell_);
+        cell_.append(static_cast<size_t>(fit - used), ' ');
+        auto& shown = shown_[static_cast<size_t>(row)];
+        if (shown.size() <= cell) {
+            shown.resize(cell + 1);
+        }
+        if (shown[cell] == cell_) {
+            return;
+        }
+        shown[cell] = cell_;
+        out += "\x1b[";
+        out += std::to_string(row + 1);
+        out += ';';
+        out += std::to_string(x + 1);
+        out += 'H';
+        out += cell_;
+        out += "\x1b[0m";
+    }
+
+    const tinykube::MirrorWatcher& watch_;
+    std::string tenant_;
+    TopSort sort_{TopSort::STATUS};
+    bool reverse_{false};
+    std::string filter_;
+    int filter_status_{-1};
+    bool filter_cordoned_{false};
+    bool editing_{false};
+    size_t offset_{0};
+    size_t matched_{0};
+    bool dirty_{true};  // the view changed: select again now
+    bool stale_{false};  // the cluster changed: select again within TOP_RESELECT
+    std::chrono::steady_clock::time_point selected_at_;
+    uint64_t revision_{0};
+    uint64_t resyncs_{0};
+    int rows_{0};
+    int cols_{0};
+    std::vector<tinykube::MemberNode> heap_;
+    std::vector<tinykube::MemberNode> visible_;
+    std::vector<std::vector<std::string>> shown_;  // [row][cell] as last written, colour included
+    std::string line_;
+    std::string cell_;
+};
+
+inline int run_top(std::shared_ptr<grpc::Channel> channel, const std::string& address, const std::string& tenant) {
+    RawTerminal terminal;
+    std::string error;
+    if (!terminal.enter(error)) {
+        std::cerr << "❌ Error: " << error << std::endl;
+        return 1;
+    }
+    tinykube::MirrorWatcher watch("top", address, std::move(channel), TOP_MAX_BACKOFF, false);
+    watch.start();
+    TopView view(watch, tenant);
+
+    std::string out;
+    auto next_frame = std::chrono::steady_clock::now();
+    while (true) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= next_frame) {
+            out.clear();
+            view.draw(out);
+            write_all(STDOUT_FILENO, out);
+            next_frame = now + TOP_REFRESH;
+        }
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next_frame - now).count();
+        pollfd input{STDIN_FILENO, POLLIN, 0};
+        if (poll(&input, 1, static_cast<int>(std::max<int64_t>(wait, 0))) > 0) {
+            char keys[64];
+            ssize_t n = ::read(STDIN_FILENO, keys, sizeof(keys));
+            if (n > 0) {
+                if (!view.key(std::string_view(keys, static_cast<size_t>(n)))) {
+                    break;
+                }
+                next_frame = now;  // answer keys without waiting for the tick
+            }
+        }
+    }
+    watch.stop();
+    return 0;
+}
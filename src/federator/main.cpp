@@ -0,0 +1,162 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <grpcpp/grpcpp.h>
+#include <thread>
+#include <csignal>
+#include <atomic>
+#include <unordered_set>
+#include <vector>
+
+#include "federator/service.hpp"
+
+// The signal handler only flips these lock-free flags; the main loop notices
+// within a second and does the logging, which a handler may not.
+std::atomic<bool> g_running{true};
+std::atomic<int> g_stop_signal{0};
+static_assert(std::atomic<bool>::is_always_lock_free && std::atomic<int>::is_always_lock_free);
+
+void signal_handler(int signal) {
+    g_stop_signal.store(signal, std::memory_order_relaxed);
+    g_running.store(false, std::memory_order_relaxed);
+}
+
+void print_usage(const char* program_name) {
+    std::cout << "🌐 TinyKube Federator - global view over several control planes\n" << std::endl;
+    std::cout << "Usage: " << program_name << " [OPTIONS] -m <name>=<address>..." << std::endl;
+    std::cout << "\nOptions:" << std::endl;
+    std::cout << "  -m, --member <name>=<address>   Control plane to watch (repeatable)" << std::endl;
+    std::cout << "  -l, --listen <address>          Address to answer queries on (default: 0.0.0.0:50060)" << std::endl;
+    std::cout << "  --tls-ca, --tls-cert, --tls-key <file>   Dial members and answer queries with mutual TLS" << std::endl;
+    std::cout << "  --tls-server-name <name>        Name to expect in the members' certificates" << std::endl;
+    std::cout << "  -h, --help                      Show this help message" << std::endl;
+    std::cout << "\nQuery it with tinykubectl -s <federator> clusters | cluster <name> [status]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string listen_address("0.0.0.0:50060");
+    std::vector<std::pair<std::string, std::string>> member_specs;
+    tinykube::TlsFiles tls;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else if (arg == "-m" || arg == "--member") {
+            std::string spec = i + 1 < argc ? argv[++i] : "";
+            auto pos = spec.find('=');
+            if (pos == std::string::npos || pos == 0 || pos + 1 == spec.size()) {
+                std::cerr << "❌ Error: --member requires <name>=<address>" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+            member_specs.emplace_back(spec.substr(0, pos), spec.substr(pos + 1));
+        }
+        else if (arg == "-l" || arg == "--listen") {
+            if (i + 1 < argc) {
+                listen_address = argv[++i];
+            } else {
+                std::cerr << "❌ Error: --listen requires a value" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--tls-ca" || arg == "--tls-cert" || arg == "--tls-key" || arg == "--tls-server-name") {
+            if (i + 1 < argc) {
+                (arg == "--tls-ca" ? tls.ca : arg == "--tls-cert" ? tls.cert
+                                     : arg == "--tls-key" ? tls.key : tls.server_name) = argv[++i];
+            } else {
+                std::cerr << "❌ Error: " << arg << " requires a value" << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else {
+            std::cerr << "❌ Error: Unknown argument '" << arg << "'" << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (member_specs.empty()) {
+        std::cerr << "❌ Error: at least one --member is required" << std::endl;
+        print_usage(argv[0]);
+        return 1;
+    }
+    std::unordered_set<std::string> member_names;
+    for (const auto& [name, address] : member_specs) {
+        if (!member_names.insert(name).second) {
+            std::cerr << "❌ Error: member " << name << " is given more than once" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<std::unique_ptr<MemberWatcher>> members;
+    for (const auto& [name, address] : member_specs) {
+        // a channel of its own, so each member sees exactly one connection
+        grpc::ChannelArguments args;
+        args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+        args.SetMaxReceiveMessageSize(-1);  // watch snapshots of big clusters exceed the 4 MiB default
+        std::string error;
+        auto channel = tinykube::create_channel(address, tls, args, error);
+        if (!channel) {
+            std::cerr << "❌ Error: " << error << std::endl;
+            return 1;
+        }
+        members.push_back(std::make_unique<MemberWatcher>(name, address, channel, MEMBER_MAX_BACKOFF, true));
+    }
+
+    std::string tls_error;
+    auto credentials = tinykube::server_credentials(tls, tls_error);
+    if (!credentials) {
+        std::cerr << "❌ Error: " << tls_error << std::endl;
+        return 1;
+    }
+
+    FederationServiceImpl service(members);
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort(listen_address, credentials);
+    builder.RegisterService(&service);
+    auto server = builder.BuildAndStart();
+    if (!server) {
+        std::cerr << "❌ Error: could not listen on " << listen_address << std::endl;
+        return 1;
+    }
+    for (auto& member : members) {
+        member->start();
+    }
+
+    std::cout << "🌐 TinyKube Federator listening on " << listen_address << ", watching " << members.size()
+              << " control planes" << std::endl;
+    std::cout << "🛑 Press Ctrl+C to stop" << std::endl;
+
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+
+    std::thread server_thread([&] { server->Wait(); });
+    int cycle = 0;
+    while (g_running.load(std::memory_order_relaxed)) {
+        if (cycle++ % 5 == 0) {
+            for (const auto& member : members) {
+                auto summary = member->mirror().summary();
+                std::cout << (summary.connected ? "🟢 " : "🔴 ") << summary.name << ": " << summary.nodes
+                          << " nodes, " << summary.count(tinykube::NodeStatus::READY) << " ready, "
+                          << summary.count(tinykube::NodeStatus::SUSPECT) << " suspect, "
+                          << summary.count(tinykube::NodeStatus::NOT_READY) << " not ready (revision "
+                          << summary.revision << ")" << std::endl;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+    std::cout << "\n🛑 Received signal " << g_stop_signal.load() << ", shutting down gracefully..." << std::endl;
+
+    for (auto& member : members) {
+        member->stop();
+    }
+    server->Shutdown();
+    server_thread.join();
+    std::cout << "👋 Federator shutdown complete" << std::endl;
+    return 0;
+}
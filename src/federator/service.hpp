@@ -0,0 +1,112 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+
+#include "control_plane.grpc.pb.h"
+#include "control_plane.pb.h"
+
+#include "tinykube/federation.hpp"
+#include "tinykube/mirror_watcher.hpp"
+#include "tinykube/tls.hpp"
+
+// tinykube_federator's pieces: a watcher per member control plane feeding
+// its ClusterMirror, and the Federation service answering from the mirrors.
+
+using grpc::ServerContext;
+using grpc::Status;
+
+inline constexpr size_t DRILL_DOWN_DEFAULT_LIMIT = 100;
+
+// a member control plane's WatchNodes stream, logged as it connects and drops
+using MemberWatcher = tinykube::MirrorWatcher;
+inline constexpr auto MEMBER_MAX_BACKOFF = std::chrono::milliseconds(10000);
+
+inline void to_health(const tinykube::ClusterSummary& summary, tinykube::ClusterHealth* health) {
+    using tinykube::NodeStatus;
+    health->set_name(summary.name);
+    health->set_address(summary.address);
+    health->set_connected(summary.connected);
+    health->set_revision(summary.revision);
+    health->set_last_event_unix_ms(summary.last_event_ms);
+    health->set_resyncs(summary.resyncs);
+    health->set_nodes(static_cast<uint32_t>(summary.nodes));
+    health->set_ready(static_cast<uint32_t>(summary.count(NodeStatus::READY)));
+    health->set_degraded(static_cast<uint32_t>(summary.count(NodeStatus::DEGRADED)));
+    health->set_suspect(static_cast<uint32_t>(summary.count(NodeStatus::SUSPECT)));
+    health->set_not_ready(static_cast<uint32_t>(summary.count(NodeStatus::NOT_READY)));
+    health->set_unknown(static_cast<uint32_t>(summary.count(NodeStatus::UNKNOWN)));
+    health->set_unschedulable(static_cast<uint32_t>(summary.unschedulable));
+    health->set_alive_cpu_millis(summary.alive_cpu_millis);
+    health->set_alive_memory_mb(summary.alive_memory_mb);
+}
+
+class FederationServiceImpl final : public tinykube::Federation::Service {
+public:
+    explicit FederationServiceImpl(const std::vector<std::unique_ptr<MemberWatcher>>& members) : members_(members) {}
+
+    // O(members): each mirror hands over its counters
+    Status Summarize(ServerContext* context,
+                     const tinykube::FederationRequest* request,
+                     tinykube::FederationSummary* response) override {
+        (void)context;
+        tinykube::ClusterSummary total;
+        total.name = "total";
+        total.connected = true;
+        bool found = false;
+        for (const auto& member : members_) {
+            if (!request->cluster().empty() && member->mirror().name() != request->cluster()) {
+                continue;
+            }
+            auto summary = member->mirror().summary();
+            total.add(summary);
+            total.revision = std::max(total.revision, summary.revision);
+            total.last_event_ms = std::max(total.last_event_ms, summary.last_event_ms);
+            to_health(summary, response->add_clusters());
+            found = true;
+        }
+        if (!found && !request->cluster().empty()) {
+            return Status(grpc::StatusCode::NOT_FOUND, "unknown cluster");
+        }
+        to_health(total, response->mutable_total());
+        return Status::OK;
+    }
+
+    // on demand, from the mirror: the member sees no extra traffic
+    Status DrillDown(ServerContext* context,
+                     const tinykube::DrillDownRequest* request,
+                     tinykube::DrillDownResponse* response) override {
+        (void)context;
+        for (const auto& member : members_) {
+            if (member->mirror().name() != request->cluster()) {
+                continue;
+            }
+            size_t limit = request->limit() > 0 ? request->limit() : DRILL_DOWN_DEFAULT_LIMIT;
+            size_t matched = 0;
+            auto nodes = member->mirror().nodes(request->tenant(), static_cast<tinykube::NodeStatus>(request->status()),
+                                                limit, matched);
+            response->set_found(true);
+            response->set_matched(static_cast<uint32_t>(matched));
+            for (const auto& node : nodes) {
+                auto* record = response->add_nodes();
+                record->set_name(node.name);
+                record->set_tenant(node.tenant);
+                record->set_status(static_cast<uint32_t>(node.status));
+                record->set_unschedulable(node.unschedulable);
+                record->set_cpu_millis(node.cpu_millis);
+                record->set_memory_mb(node.memory_mb);
+                record->set_last_seen_ms(node.last_seen_ms);
+            }
+            return Status::OK;
+        }
+        return Status::OK;  // found stays false
+    }
+private:
+    const std::vector<std::unique_ptr<MemberWatcher>>& members_;
+};
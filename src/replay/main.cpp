@@ -0,0 +1,243 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+
+#include "control/service.hpp"
+#include "tinykube/arrow_ipc.hpp"
+#include "tinykube/capture.hpp"
+
+using grpc::ClientContext;
+using grpc::ClientWriter;
+
+// one client-side heartbeat stream; captured streams are folded onto these
+struct ReplayStream {
+    ClientContext context;
+    tinykube::Empty response;
+    std::unique_ptr<ClientWriter<tinykube::Heartbeat>> writer;
+};
+
+inline constexpr size_t ARROW_BATCH_ROWS = 65536;
+
+// The capture as a time series in an Arrow IPC file (Feather V2), one row per
+// record, for analysis instead of replay. Returns false on a write error.
+bool export_arrow(tinykube::CaptureReader& reader, const std::string& out_path, uint64_t& rows) {
+    std::ofstream out(out_path, std::ios::binary);
+    tinykube::ArrowFileWriter file([&](const char* data, size_t size) {
+        return static_cast<bool>(out.write(data, static_cast<std::streamsize>(size)));
+    });
+    enum { OFFSET_US, TYPE, STREAM, TENANT, NODE, CPU_MILLIS, MEMORY_MB, CLIENT_MS };
+    std::vector<tinykube::ArrowColumn> columns{
+        {"offset_us", tinykube::ArrowType::INT64},
+        {"type", tinykube::ArrowType::UTF8},
+        {"stream", tinykube::ArrowType::INT64},
+        {"tenant", tinykube::ArrowType::UTF8},
+        {"node", tinykube::ArrowType::UTF8},
+        {"cpu_millis", tinykube::ArrowType::INT64},
+        {"memory_mb", tinykube::ArrowType::INT64},
+        {"client_ms", tinykube::ArrowType::TIMESTAMP_MS},
+    };
+    for (auto& column : columns) {
+        column.reserve(ARROW_BATCH_ROWS);
+    }
+    if (!out || !file.begin(columns)) {
+        return false;
+    }
+
+    tinykube::CaptureRecord record;
+    while (reader.next(record)) {
+        bool registration = record.type == tinykube::CaptureType::REGISTER;
+        columns[OFFSET_US].append_int64(static_cast<int64_t>(record.offset_us));
+        columns[TYPE].append_utf8(registration ? "register" : "heartbeat");
+        columns[STREAM].append_int64(static_cast<int64_t>(record.stream));
+        columns[TENANT].append_utf8(record.tenant);
+        columns[NODE].append_utf8(record.node);
+        columns[CPU_MILLIS].append_int64(record.cpu_millis);
+        columns[MEMORY_MB].append_int64(record.memory_mb);
+        columns[CLIENT_MS].append_int64(record.client_ms);
+        if (columns.front().length() == ARROW_BATCH_ROWS) {
+            if (!file.write_batch(columns)) {
+                return false;
+            }
+            for (auto& column : columns) {
+                column.clear();
+            }
+        }
+    }
+    if (columns.front().length() > 0 && !file.write_batch(columns)) {
+        return false;
+    }
+    rows = file.rows_written();
+    return file.finish() && static_cast<bool>(out.flush());
+}
+
+void print_usage(const char* program_name) {
+    std::cout << "🎬 TinyKube Replay - feed a control plane capture through the real service\n" << std::endl;
+    std::cout << "Usage: " << program_name << " <capture-file> [OPTIONS]" << std::endl;
+    std::cout << "\nOptions:" << std::endl;
+    std::cout << "  -x, --speed <factor>      Replay at factor x the captured rate (default: 1)" << std::endl;
+    std::cout << "  -m, --max                 Replay as fast as possible" << std::endl;
+    std::cout << "  -S, --streams <n>         Heartbeat streams to replay over (default: 64)" << std::endl;
+    std::cout << "  -a, --arrow <file>        Write the capture as an Arrow/Feather time series instead" << std::endl;
+    std::cout << "  -h, --help                Show this help message" << std::endl;
+    std::cout << "\nExamples:" << std::endl;
+    std::cout << "  tinykube_control --capture prod.tkcap" << std::endl;
+    std::cout << "  " << program_name << " prod.tkcap --speed 10" << std::endl;
+    std::cout << "  " << program_name << " prod.tkcap --arrow prod.arrow\n" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    double speed = 1.0;
+    size_t stream_count = 64;
+    std::string arrow_path;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else if ((arg == "-x" || arg == "--speed") && i + 1 < argc) {
+            speed = std::stod(argv[++i]);
+        }
+        else if (arg == "-m" || arg == "--max") {
+            speed = 0;
+        }
+        else if ((arg == "-S" || arg == "--streams") && i + 1 < argc) {
+            stream_count = std::max<size_t>(1, std::stoul(argv[++i]));
+        }
+        else if ((arg == "-a" || arg == "--arrow") && i + 1 < argc) {
+            arrow_path = argv[++i];
+        }
+        else if (path.empty() && arg[0] != '-') {
+            path = arg;
+        }
+        else {
+            std::cerr << "❌ Error: Unknown or incomplete argument '" << arg << "'" << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (path.empty() || speed < 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    tinykube::CaptureReader reader(path);
+    if (!reader.valid()) {
+        std::cerr << "❌ Error: " << path << " is not a TinyKube capture" << std::endl;
+        return 1;
+    }
+
+    if (!arrow_path.empty()) {
+        uint64_t rows = 0;
+        auto started = std::chrono::steady_clock::now();
+        if (!export_arrow(reader, arrow_path, rows)) {
+            std::cerr << "❌ Error: could not write " << arrow_path << std::endl;
+            return 1;
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+        std::cout << "💾 Wrote " << rows << " records to " << arrow_path << " in " << elapsed.count() << "ms"
+                  << (reader.valid() ? "" : " (capture truncated)") << std::endl;
+        return 0;
+    }
+
+    // in-process server: the same service code, no sockets, no cron journal
+    ControlPlaneOptions options;
+    options.cron_journal_path.clear();
+    options.verbose = false;
+    ControlPlaneServiceImpl service(options);
+    grpc::ServerBuilder builder;
+    builder.RegisterService(&service);
+    auto server = builder.BuildAndStart();
+    auto stub = tinykube::ControlPlane::NewStub(server->InProcessChannel(grpc::ChannelArguments()));
+
+    std::cout << "🎬 Replaying " << path << " at "
+              << (speed == 0 ? std::string("max speed") : std::to_string(speed) + "x") << " over "
+              << stream_count << " heartbeat streams" << std::endl;
+
+    std::vector<std::unique_ptr<ReplayStream>> streams(stream_count);
+    uint64_t registrations = 0, rejected = 0, heartbeats = 0, broken = 0;
+    int64_t max_lag_us = 0;
+    auto started = std::chrono::steady_clock::now();
+
+    tinykube::CaptureRecord record;
+    while (reader.next(record)) {
+        if (speed > 0) {
+            auto due = started + std::chrono::microseconds(static_cast<int64_t>(record.offset_us / speed));
+            auto now = std::chrono::steady_clock::now();
+            if (due > now) {
+                std::this_thread::sleep_until(due);
+            } else {
+                max_lag_us = std::max<int64_t>(max_lag_us,
+                    std::chrono::duration_cast<std::chrono::microseconds>(now - due).count());
+            }
+        }
+
+        if (record.type == tinykube::CaptureType::REGISTER) {
+            tinykube::RegisterRequest request;
+            request.mutable_node()->set_name(record.node);
+            request.mutable_node()->set_tenant(record.tenant);
+            request.mutable_node()->set_cpu_millis(record.cpu_millis);
+            request.mutable_node()->set_memory_mb(record.memory_mb);
+            tinykube::RegisterResponse response;
+            ClientContext context;
+            if (!stub->RegisterNode(&context, request, &response).ok() || !response.accepted()) {
+                rejected++;
+            }
+            registrations++;
+            continue;
+        }
+
+        auto& stream = streams[record.stream % stream_count];
+        if (!stream) {
+            stream = std::make_unique<ReplayStream>();
+            stream->writer = stub->StreamHeartbeats(&stream->context, &stream->response);
+        }
+        tinykube::Heartbeat heartbeat;
+        heartbeat.set_node_name(record.node);
+        heartbeat.set_tenant(record.tenant);
+        heartbeat.set_now_unix_ms(record.client_ms);
+        if (!stream->writer->Write(heartbeat)) {
+            broken++;
+        }
+        heartbeats++;
+    }
+    bool complete = reader.valid();
+
+    for (auto& stream : streams) {
+        if (stream) {
+            stream->writer->WritesDone();
+            stream->writer->Finish();
+        }
+    }
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    auto nodes = service.tenants().snapshot();
+    size_t ready = 0;
+    for (const auto& node : nodes) {
+        ready += node.is_alive() ? 1 : 0;
+    }
+
+    std::cout << (complete ? "✅" : "⚠️ ") << " Replayed " << registrations << " registrations ("
+              << rejected << " rejected) and " << heartbeats << " heartbeats (" << broken << " failed writes)"
+              << (complete ? "" : ", capture truncated") << std::endl;
+    std::cout << "⏱️  " << std::fixed << std::setprecision(3) << elapsed_s << "s, "
+              << std::setprecision(0) << (registrations + heartbeats) / std::max(elapsed_s, 1e-9) << " records/s";
+    if (speed > 0) {
+        std::cout << ", max lag behind schedule " << std::setprecision(3) << max_lag_us / 1000.0 << "ms";
+    }
+    std::cout << std::defaultfloat << std::endl;
+    std::cout << "📊 Registry: " << nodes.size() << " nodes, " << ready << " alive, revision "
+              << service.tenants().revision() << std::endl;
+
+    service.shutdown();
+    server->Shutdown();
+    return complete ? 0 : 1;
+}
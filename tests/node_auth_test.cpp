@@ -0,0 +1,148 @@
+// Node token checks: tampering, expiry, identity and separator handling.
+// Plain asserts with a failure count, so it runs under ctest with no framework.
+#include <iostream>
+#include <string>
+
+#include "tinykube/node_auth.hpp"
+
+namespace {
+    int failures = 0;
+
+    void check(bool condition, const char* what) {
+        if (!condition) {
+            std::cerr << "❌ FAILED: " << what << std::endl;
+            failures++;
+        }
+    }
+
+    const std::string KEY = "0123456789abcdef0123456789abcdef";
+    constexpr int64_t NOW = 1'700'000'000'000;
+
+    void test_session_round_trip() {
+        tinykube::NodeAuthority authority(KEY);
+        int64_t expires = 0;
+        std::string token = authority.issue_session("team-a", "node-1", NOW, expires);
+        tinykube::SessionClaim claim;
+        check(authority.check_session(token, NOW, claim), "fresh session token is accepted");
+        check(claim.tenant == "team-a" && claim.node == "node-1", "claim carries tenant and node");
+        check(claim.expires_ms == expires && expires == NOW + tinykube::SESSION_TOKEN_TTL_MS, "claim carries expiry");
+    }
+
+    void test_default_tenant() {
+        tinykube::NodeAuthority authority(KEY);
+        int64_t expires = 0;
+        tinykube::SessionClaim claim;
+        check(authority.check_session(authority.issue_session("", "node-1", NOW, expires), NOW, claim) &&
+                  claim.tenant == tinykube::DEFAULT_TENANT,
+              "empty tenant is issued as the default tenant");
+        check(authority.check_bootstrap("", "node-1", authority.bootstrap_token(tinykube::DEFAULT_TENANT, "node-1")),
+              "bootstrap tokens treat empty and default tenant alike");
+    }
+
+    void test_tampered_mac() {
+        tinykube::NodeAuthority authority(KEY);
+        int64_t expires = 0;
+        std::string token = authority.issue_session("team-a", "node-1", NOW, expires);
+        size_t mac_at = token.find(':') + 1;
+        token[mac_at] = token[mac_at] == '0' ? '1' : '0';
+        tinykube::SessionClaim claim;
+        check(!authority.check_session(token, NOW, claim), "flipped MAC digit is rejected");
+
+        std::string bootstrap = authority.bootstrap_token("team-a", "node-1");
+        bootstrap.back() = bootstrap.back() == '0' ? '1' : '0';
+        check(!authority.check_bootstrap("team-a", "node-1", bootstrap), "flipped bootstrap digit is rejected");
+        check(!authority.check_bootstrap("team-a", "node-1", ""), "empty bootstrap token is rejected");
+    }
+
+    void test_other_key() {
+        tinykube::NodeAuthority authority(KEY);
+        tinykube::NodeAuthority other("fedcba9876543210fedcba9876543210");
+        int64_t expires = 0;
+        tinykube::SessionClaim claim;
+        check(!other.check_session(authority.issue_session("team-a", "node-1", NOW, expires), NOW, claim),
+              "session from another cluster key is rejected");
+        check(!other.check_bootstrap("team-a", "node-1", authority.bootstrap_token("team-a", "node-1")),
+              "bootstrap from another cluster key is rejected");
+    }
+
+    void test_expiry() {
+        tinykube::NodeAuthority authority(KEY, 1000);
+        int64_t expires = 0;
+        std::string token = authority.issue_session("team-a", "node-1", NOW, expires);
+        tinykube::SessionClaim claim;
+        check(authority.check_session(token, expires - 1, claim), "token is valid just before expiry");
+        check(!authority.check_session(token, expires, claim), "token is rejected at expiry");
+
+        // pushing the expiry out invalidates the MAC
+        std::string extended = std::to_string(expires + 60'000) + token.substr(token.find(':'));
+        check(!authority.check_session(extended, expires, claim), "edited expiry is rejected");
+    }
+
+    void test_wrong_identity() {
+        tinykube::NodeAuthority authority(KEY);
+        int64_t expires = 0;
+        std::string token = authority.issue_session("team-a", "node-1", NOW, expires);
+        std::string prefix = token.substr(0, token.rfind("6:team-a:"));
+        tinykube::SessionClaim claim;
+        check(!authority.check_session(prefix + "6:team-b:node-1", NOW, claim), "session for another tenant is rejected");
+        check(!authority.check_session(prefix + "6:team-a:node-2", NOW, claim), "session for another node is rejected");
+
+        std::string bootstrap = authority.bootstrap_token("team-a", "node-1");
+        check(!authority.check_bootstrap("team-a", "node-2", bootstrap), "bootstrap for another node is rejected");
+        check(!authority.check_bootstrap("team-b", "node-1", bootstrap), "bootstrap for another tenant is rejected");
+    }
+
+    void test_separators_in_names() {
+        tinykube::NodeAuthority authority(KEY);
+        int64_t expires = 0;
+        tinykube::SessionClaim claim;
+        std::string token = authority.issue_session("team:a", "rack:1:node", NOW, expires);
+        check(authority.check_session(token, NOW, claim) && claim.tenant == "team:a" && claim.node == "rack:1:node",
+              "names containing ':' round-trip");
+
+        // the same characters split differently must not verify
+        std::string prefix = token.substr(0, token.rfind("6:team:a:"));
+        check(!authority.check_session(prefix + "4:team:a:rack:1:node", NOW, claim),
+              "moving the tenant/node boundary is rejected");
+
+        check(authority.bootstrap_token("a:b", "c") != authority.bootstrap_token("a", "b:c"),
+              "bootstrap tokens don't collide across the separator");
+    }
+
+    void test_malformed() {
+        tinykube::NodeAuthority authority(KEY);
+        tinykube::SessionClaim claim;
+        for (const char* token : {"", ":", "::::", "123", "123:abc", "123:abc:6:team-a", "x:abc:6:team-a:node",
+                                  "123:abc:99:team-a:node", "123:abc:-1:team-a:node", "123:abc:0::node"}) {
+            check(!authority.check_session(token, NOW, claim), token);
+        }
+    }
+
+    void test_stream_auth() {
+        tinykube::StreamAuth auth;
+        auth.add({"a:b", "c", NOW + 1000});
+        check(auth.allows("a:b", "c", NOW), "stream allows its claimed node");
+        check(!auth.allows("a", "b:c", NOW), "stream keys don't collide across the separator");
+        check(!auth.allows("a:b", "c", NOW + 1000), "stream claim expires");
+        auth.add({tinykube::DEFAULT_TENANT, "d", NOW + 1000});
+        check(auth.allows("", "d", NOW), "empty tenant means the default tenant");
+    }
+}
+
+int main() {
+    test_session_round_trip();
+    test_default_tenant();
+    test_tampered_mac();
+    test_other_key();
+    test_expiry();
+    test_wrong_identity();
+    test_separators_in_names();
+    test_malformed();
+    test_stream_auth();
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "✅ node auth: all checks passed" << std::endl;
+    return 0;
+}